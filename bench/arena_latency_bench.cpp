@@ -0,0 +1,77 @@
+#include "bench.h"
+#include "memory_arena.h"
+#include "random.h"
+#include "tlsf_arena.h"
+
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+
+using namespace nlrs;
+
+const usize arena_bytes = 256u * 1024u * 1024u;
+const usize num_live = 20000u;
+const usize num_ops = 200000u;
+
+// Measures the latency of each individual allocate and free call under a churn workload,
+// where random live blocks are replaced with blocks of random sizes.
+void measure_latency(const char* name, memory_arena& arena)
+{
+    nlrs::random<usize> rng;
+    rng.seed(1337u);
+    std::vector<void*> live(num_live, nullptr);
+    bench::latency_samples alloc_latency(num_ops);
+    bench::latency_samples free_latency(num_ops);
+
+    for (void*& ptr : live)
+    {
+        ptr = arena.allocate(rng(16u, 4096u));
+    }
+
+    for (usize i = 0u; i < num_ops; ++i)
+    {
+        void*& slot = live[rng(0u, num_live - 1u)];
+        usize size = rng(16u, 4096u);
+
+        bench::stopwatch watch;
+        arena.free(slot);
+        free_latency.add(watch.elapsed_ns());
+
+        watch.restart();
+        slot = arena.allocate(size);
+        alloc_latency.add(watch.elapsed_ns());
+        bench::do_not_optimize(slot);
+    }
+
+    for (void* ptr : live)
+    {
+        arena.free(ptr);
+    }
+
+    std::printf("  %s\n", name);
+    bench::report_latency("allocate", alloc_latency);
+    bench::report_latency("free", free_latency);
+}
+
+}
+
+BENCHMARK(arena_latency_percentiles)
+{
+    void* memory = std::malloc(arena_bytes);
+
+    {
+        tlsf_arena arena(memory, arena_bytes);
+        measure_latency("tlsf_arena", arena);
+    }
+
+    {
+        free_list_arena arena(memory, arena_bytes);
+        measure_latency("free_list_arena", arena);
+    }
+
+    measure_latency("system_arena", system_arena::get_instance());
+
+    std::free(memory);
+}
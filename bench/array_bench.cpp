@@ -0,0 +1,103 @@
+#include "array.h"
+#include "bench.h"
+#include "memory_arena.h"
+#include "stl/vector.h"
+
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+
+using namespace nlrs;
+
+const usize arena_bytes = 256u * 1024u * 1024u;
+const usize num_elements = 1u << 20u;
+const usize num_repeats = 20u;
+const usize block_size = 100u;
+
+template<typename Body>
+void run(const char* label, usize num_ops, Body body)
+{
+    bench::stopwatch watch;
+    for (usize r = 0u; r < num_repeats; ++r)
+    {
+        body();
+    }
+    bench::report_throughput(label, num_repeats * num_ops, watch.elapsed_seconds());
+}
+
+// a block of floats, as if from a mesh loader
+float block[block_size];
+
+}
+
+BENCHMARK(array_vs_vector)
+{
+    // both containers get their memory from the same arena, so that the difference is down
+    // to the containers alone
+    void* memory = std::malloc(arena_bytes);
+    {
+        free_list_arena arena(memory, arena_bytes);
+
+        run("array push_back", num_elements, [&arena]() -> void
+        {
+            array<u32> values(arena);
+            for (usize i = 0u; i < num_elements; ++i)
+            {
+                values.push_back(u32(i));
+            }
+            bench::do_not_optimize(values.data());
+        });
+        run("pmr::vector push_back", num_elements, [&arena]() -> void
+        {
+            pmr::vector<u32> values{ polymorphic_allocator<u32>(arena) };
+            for (usize i = 0u; i < num_elements; ++i)
+            {
+                values.push_back(u32(i));
+            }
+            bench::do_not_optimize(values.data());
+        });
+
+        run("array append", num_elements, [&arena]() -> void
+        {
+            array<float> values(arena);
+            for (usize i = 0u; i < num_elements; i += block_size)
+            {
+                values.append(block, block_size);
+            }
+            bench::do_not_optimize(values.data());
+        });
+        run("pmr::vector insert at end", num_elements, [&arena]() -> void
+        {
+            pmr::vector<float> values{ polymorphic_allocator<float>(arena) };
+            for (usize i = 0u; i < num_elements; i += block_size)
+            {
+                values.insert(values.end(), block, block + block_size);
+            }
+            bench::do_not_optimize(values.data());
+        });
+
+        run("array resize_uninitialized and fill", num_elements, [&arena]() -> void
+        {
+            array<u32> values(arena);
+            values.resize_uninitialized(num_elements);
+            for (usize i = 0u; i < num_elements; ++i)
+            {
+                values[i] = u32(i);
+            }
+            bench::do_not_optimize(values.data());
+        });
+        run("pmr::vector resize and fill", num_elements, [&arena]() -> void
+        {
+            pmr::vector<u32> values{ polymorphic_allocator<u32>(arena) };
+            values.resize(num_elements);
+            for (usize i = 0u; i < num_elements; ++i)
+            {
+                values[i] = u32(i);
+            }
+            bench::do_not_optimize(values.data());
+        });
+    }
+    std::free(memory);
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include "aliases.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace nlrs
+{
+namespace bench
+{
+
+// A benchmark is a plain function which times its own inner loop and prints
+// its results using the report functions below. Benchmarks register themselves
+// through the BENCHMARK macro and are run in registration order by main.cpp.
+
+using bench_func = void(*)();
+
+struct bench_entry
+{
+    const char* name;
+    bench_func  func;
+};
+
+inline std::vector<bench_entry>& registry()
+{
+    static std::vector<bench_entry> entries;
+    return entries;
+}
+
+struct registration
+{
+    registration(const char* name, bench_func func)
+    {
+        registry().push_back(bench_entry{ name, func });
+    }
+};
+
+// Runs every benchmark whose name contains the filter. A null filter runs everything.
+inline void run_all(const char* filter)
+{
+    for (const bench_entry& entry : registry())
+    {
+        if (filter && !std::strstr(entry.name, filter))
+        {
+            continue;
+        }
+        std::printf("\n%s\n", entry.name);
+        entry.func();
+    }
+}
+
+// Prevents the compiler from optimizing away a value which is otherwise unused.
+template<typename T>
+inline void do_not_optimize(const T& value)
+{
+#if defined(_MSC_VER)
+    static volatile const void* sink;
+    sink = &value;
+#else
+    asm volatile("" : : "r,m"(value) : "memory");
+#endif
+}
+
+class stopwatch
+{
+public:
+    using clock = std::chrono::high_resolution_clock;
+
+    stopwatch()
+        : start_(clock::now())
+    {}
+
+    void restart()
+    {
+        start_ = clock::now();
+    }
+
+    u64 elapsed_ns() const
+    {
+        return u64(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start_).count());
+    }
+
+    double elapsed_seconds() const
+    {
+        return double(elapsed_ns()) * 1e-9;
+    }
+
+private:
+    clock::time_point start_;
+};
+
+// Collects the latencies of individual operations, in nanoseconds.
+class latency_samples
+{
+public:
+    explicit latency_samples(usize expected = 0u)
+    {
+        samples_.reserve(expected);
+    }
+
+    void add(u64 ns)
+    {
+        samples_.push_back(ns);
+        sorted_ = false;
+    }
+
+    usize count() const { return samples_.size(); }
+
+    // p is in the range [0, 100]
+    u64 percentile(double p)
+    {
+        if (samples_.empty())
+        {
+            return 0u;
+        }
+        if (!sorted_)
+        {
+            std::sort(samples_.begin(), samples_.end());
+            sorted_ = true;
+        }
+        usize index = usize((p / 100.0) * double(samples_.size() - 1u) + 0.5);
+        return samples_[std::min(index, samples_.size() - 1u)];
+    }
+
+private:
+    std::vector<u64> samples_;
+    bool sorted_{ false };
+};
+
+inline void report_throughput(const char* label, usize num_ops, double seconds)
+{
+    std::printf("  %-40s %10.2f Mops/s  (%.3f ms)\n", label, double(num_ops) / seconds * 1e-6, seconds * 1e3);
+}
+
+inline void report_latency(const char* label, latency_samples& samples)
+{
+    std::printf("  %-40s p50 %6llu ns  p90 %6llu ns  p99 %6llu ns  p99.9 %6llu ns  max %7llu ns\n",
+        label,
+        (unsigned long long)samples.percentile(50.0),
+        (unsigned long long)samples.percentile(90.0),
+        (unsigned long long)samples.percentile(99.0),
+        (unsigned long long)samples.percentile(99.9),
+        (unsigned long long)samples.percentile(100.0));
+}
+
+inline void report_bytes(const char* label, usize bytes)
+{
+    std::printf("  %-40s %10.2f KiB\n", label, double(bytes) / 1024.0);
+}
+
+}
+}
+
+#define BENCHMARK(name) \
+    static void bench_##name(); \
+    static nlrs::bench::registration bench_registration_##name(#name, &bench_##name); \
+    static void bench_##name()
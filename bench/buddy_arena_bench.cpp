@@ -0,0 +1,88 @@
+#include "bench.h"
+#include "buddy_arena.h"
+#include "memory_arena.h"
+#include "random.h"
+
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+
+using namespace nlrs;
+
+const usize arena_bytes = 256u * 1024u * 1024u;
+const usize num_live = 20000u;
+const usize num_rounds = 5u;
+const usize ops_per_round = 400000u;
+
+// Sizes spread evenly over the powers of two from 16 bytes to 16 KiB, like the mix of
+// small objects and buffers in a long-running process.
+usize random_size(nlrs::random<usize>& rng)
+{
+    usize order = rng(4u, 13u);
+    return rng(usize(1u) << order, (usize(2u) << order) - 1u);
+}
+
+// Keeps num_live random blocks alive, replacing a random one at a time, and reports the
+// throughput of each round, so that any slowdown as the arena fragments shows up.
+template<typename Arena>
+void long_churn(const char* label, Arena& arena)
+{
+    std::printf("  %s\n", label);
+    nlrs::random<usize> rng;
+    rng.seed(1337u);
+    std::vector<void*> live(num_live, nullptr);
+    std::vector<usize> sizes(num_live, 0u);
+
+    for (usize i = 0u; i < num_live; ++i)
+    {
+        sizes[i] = random_size(rng);
+        live[i] = arena.allocate(sizes[i]);
+    }
+
+    for (usize round = 0u; round < num_rounds; ++round)
+    {
+        bench::stopwatch watch;
+        for (usize i = 0u; i < ops_per_round; ++i)
+        {
+            usize slot = rng(0u, num_live - 1u);
+            arena.free(live[slot], sizes[slot]);
+            sizes[slot] = random_size(rng);
+            live[slot] = arena.allocate(sizes[slot]);
+            bench::do_not_optimize(live[slot]);
+        }
+        char round_label[64];
+        std::snprintf(round_label, sizeof(round_label), "round %zu", round + 1u);
+        bench::report_throughput(round_label, ops_per_round, watch.elapsed_seconds());
+    }
+#ifdef NLRS_ARENA_STATS
+    arena_stats stats = arena.stats();
+    bench::report_bytes("peak bytes in use", stats.peak_bytes_in_use);
+    std::printf("  %-40s %10.3f\n", "fragmentation", stats.fragmentation());
+#endif
+
+    for (usize i = 0u; i < num_live; ++i)
+    {
+        arena.free(live[i], sizes[i]);
+    }
+}
+
+}
+
+BENCHMARK(buddy_arena_long_churn)
+{
+    void* memory = std::malloc(arena_bytes);
+
+    {
+        free_list_arena arena(memory, arena_bytes);
+        long_churn("free_list_arena", arena);
+    }
+
+    {
+        buddy_arena arena(memory, arena_bytes);
+        long_churn("buddy_arena", arena);
+    }
+
+    std::free(memory);
+}
@@ -0,0 +1,125 @@
+#include "bench.h"
+#include "concurrent_object_pool.h"
+#include "memory_arena.h"
+#include "object_pool.h"
+#include "random.h"
+
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+using namespace nlrs;
+
+const usize ops_per_thread = 1000000u;
+const usize live_per_thread = 64u;
+
+struct job
+{
+    explicit job(u64 job_id)
+        : id(job_id),
+        data{}
+    {}
+
+    u64 id;
+    u64 data[3];
+};
+
+// object_pool behind a single mutex, the baseline
+class locked_pool
+{
+public:
+    locked_pool()
+        : pool_(system_arena::get_instance())
+    {}
+
+    job* create(u64 id)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return pool_.create(id);
+    }
+
+    void release(job* obj)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pool_.release(obj);
+    }
+
+private:
+    std::mutex mutex_;
+    object_pool<job, 64u> pool_;
+};
+
+// Each thread keeps live_per_thread jobs, and replaces a random one at a time.
+template<typename Pool>
+void churn_thread(Pool& pool, u32 seed)
+{
+    nlrs::random<usize> rng;
+    rng.seed(seed);
+    job* live[live_per_thread];
+    for (job*& obj : live)
+    {
+        obj = pool.create(u64(0u));
+    }
+    for (usize i = 0u; i < ops_per_thread; ++i)
+    {
+        job*& obj = live[rng(0u, live_per_thread - 1u)];
+        pool.release(obj);
+        obj = pool.create(u64(i));
+        bench::do_not_optimize(obj);
+    }
+    for (job* obj : live)
+    {
+        pool.release(obj);
+    }
+}
+
+template<typename Thread>
+void run_threads(const char* name, unsigned num_threads, Thread thread)
+{
+    std::vector<std::thread> threads;
+    bench::stopwatch watch;
+    for (unsigned t = 0u; t < num_threads; ++t)
+    {
+        threads.emplace_back(thread, t + 1u);
+    }
+    for (std::thread& t : threads)
+    {
+        t.join();
+    }
+    char label[64];
+    std::snprintf(label, sizeof(label), "%s, %u threads", name, num_threads);
+    bench::report_throughput(label, num_threads * ops_per_thread, watch.elapsed_seconds());
+}
+
+}
+
+BENCHMARK(concurrent_object_pool_churn)
+{
+    unsigned max_threads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned num_threads = 1u; num_threads <= max_threads; num_threads *= 2u)
+    {
+        locked_pool pool;
+        run_threads("locked object_pool", num_threads,
+            [&pool](u32 seed) -> void { churn_thread(pool, seed); });
+    }
+    for (unsigned num_threads = 1u; num_threads <= max_threads; num_threads *= 2u)
+    {
+        concurrent_object_pool<job> pool(system_arena::get_instance());
+        run_threads("concurrent_object_pool", num_threads,
+            [&pool](u32 seed) -> void { churn_thread(pool, seed); });
+    }
+    for (unsigned num_threads = 1u; num_threads <= max_threads; num_threads *= 2u)
+    {
+        concurrent_object_pool<job> pool(system_arena::get_instance());
+        run_threads("concurrent_object_pool + cache", num_threads,
+            [&pool](u32 seed) -> void
+            {
+                concurrent_object_pool<job>::thread_cache cache(pool);
+                churn_thread(cache, seed);
+            });
+    }
+}
@@ -0,0 +1,210 @@
+#include "bench.h"
+#include "bit_math.h"
+#include "memory_arena.h"
+#include "random.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+
+using namespace nlrs;
+
+// The allocation policy free_list_arena used before it had size classes: a single
+// address-ordered free list which is searched on a first-fit basis. Kept here as a
+// baseline for the churn benchmark. There are no guards or alignment handling, which
+// only makes the baseline faster than it used to be.
+class first_fit_arena
+{
+public:
+    first_fit_arena(void* memory, usize num_bytes)
+        : arena_(static_cast<u8*>(memory)),
+        offset_(0u),
+        size_(num_bytes),
+        head_(nullptr)
+    {}
+
+    void* allocate(usize bytes)
+    {
+        usize block_size = usize(next_power_of_two(std::max(bytes + sizeof(usize), sizeof(free_block))));
+        free_block* prev = nullptr;
+        for (free_block* cur = head_; cur; prev = cur, cur = cur->next)
+        {
+            if (cur->size < block_size)
+            {
+                continue;
+            }
+            (prev ? prev->next : head_) = cur->next;
+            usize* hdr = reinterpret_cast<usize*>(cur);
+            *hdr = cur->size;
+            return hdr + 1u;
+        }
+        if (offset_ + block_size > size_)
+        {
+            return nullptr;
+        }
+        usize* hdr = reinterpret_cast<usize*>(arena_ + offset_);
+        offset_ += block_size;
+        *hdr = block_size;
+        return hdr + 1u;
+    }
+
+    void free(void* ptr)
+    {
+        usize* hdr = static_cast<usize*>(ptr) - 1u;
+        uptr start = reinterpret_cast<uptr>(hdr);
+        usize size = *hdr;
+        free_block* prev = nullptr;
+        free_block* cur = head_;
+        while (cur && reinterpret_cast<uptr>(cur) < start)
+        {
+            prev = cur;
+            cur = cur->next;
+        }
+        free_block* block = reinterpret_cast<free_block*>(hdr);
+        if (prev && reinterpret_cast<uptr>(prev) + prev->size == start)
+        {
+            prev->size += size;
+            block = prev;
+        }
+        else
+        {
+            block->size = size;
+            block->next = cur;
+            (prev ? prev->next : head_) = block;
+        }
+        if (cur && reinterpret_cast<uptr>(block) + block->size == reinterpret_cast<uptr>(cur))
+        {
+            block->size += cur->size;
+            block->next = cur->next;
+        }
+    }
+
+private:
+    struct free_block
+    {
+        usize       size;
+        free_block* next;
+    };
+
+    u8*         arena_;
+    usize       offset_;
+    usize       size_;
+    free_block* head_;
+};
+
+const usize arena_bytes = 256u * 1024u * 1024u;
+const usize num_live = 20000u;
+const usize num_churn_ops = 200000u;
+
+// Fills the arena with live blocks of random sizes, then repeatedly frees a random
+// live block and allocates a new one of a random size. The free list grows with the
+// fragmentation that this causes.
+template<typename Arena>
+void churn(const char* label, Arena& arena)
+{
+    nlrs::random<usize> rng;
+    rng.seed(1337u);
+    std::vector<void*> live(num_live, nullptr);
+
+    for (void*& ptr : live)
+    {
+        ptr = arena.allocate(rng(16u, 2048u));
+    }
+
+    bench::stopwatch watch;
+    for (usize i = 0u; i < num_churn_ops; ++i)
+    {
+        void*& slot = live[rng(0u, num_live - 1u)];
+        arena.free(slot);
+        slot = arena.allocate(rng(16u, 2048u));
+        bench::do_not_optimize(slot);
+    }
+    bench::report_throughput(label, num_churn_ops, watch.elapsed_seconds());
+
+    for (void* ptr : live)
+    {
+        arena.free(ptr);
+    }
+}
+
+}
+
+BENCHMARK(free_list_arena_churn)
+{
+    void* memory = std::malloc(arena_bytes);
+
+    {
+        first_fit_arena arena(memory, arena_bytes);
+        churn("first fit (previous policy)", arena);
+    }
+
+    {
+        free_list_arena arena(memory, arena_bytes);
+        churn("free_list_arena size classes", arena);
+    }
+
+    std::free(memory);
+}
+
+namespace
+{
+
+const usize num_objects = 100000u;
+
+// Allocates many objects of the same size, and reports the memory the arena used per object.
+template<typename Arena>
+void memory_per_object(const char* label, usize object_size)
+{
+    void* memory = std::malloc(arena_bytes);
+    {
+        Arena arena(memory, arena_bytes);
+        std::vector<void*> objects(num_objects, nullptr);
+        for (void*& ptr : objects)
+        {
+            ptr = arena.allocate(object_size);
+        }
+        usize used = usize(static_cast<u8*>(objects.back()) - static_cast<u8*>(objects.front())) +
+            arena.block_size(objects.back());
+        std::printf("  %-40s %10.1f bytes/object\n", label, double(used) / double(num_objects));
+        for (void* ptr : objects)
+        {
+            arena.free(ptr);
+        }
+    }
+    std::free(memory);
+}
+
+}
+
+BENCHMARK(free_list_arena_policy_memory_per_object)
+{
+    const usize sizes[] = { 8u, 24u, 48u, 100u, 200u };
+    for (usize size : sizes)
+    {
+        char label[64];
+        std::snprintf(label, sizeof(label), "debug policy, %zu byte objects", size);
+        memory_per_object<basic_free_list_arena<free_list_debug_policy>>(label, size);
+        std::snprintf(label, sizeof(label), "release policy, %zu byte objects", size);
+        memory_per_object<basic_free_list_arena<free_list_release_policy>>(label, size);
+    }
+}
+
+BENCHMARK(free_list_arena_policy_churn)
+{
+    void* memory = std::malloc(arena_bytes);
+
+    {
+        basic_free_list_arena<free_list_debug_policy> arena(memory, arena_bytes);
+        churn("debug policy (guards and fills)", arena);
+    }
+
+    {
+        basic_free_list_arena<free_list_release_policy> arena(memory, arena_bytes);
+        churn("release policy (compact layout)", arena);
+    }
+
+    std::free(memory);
+}
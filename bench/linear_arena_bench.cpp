@@ -0,0 +1,96 @@
+#include "bench.h"
+#include "linear_arena.h"
+#include "memory_arena.h"
+
+#include "stl/vector.h"
+#include <cstdlib>
+
+namespace
+{
+
+using namespace nlrs;
+
+const usize arena_bytes = 64u * 1024u * 1024u;
+const usize num_frames = 1000u;
+const usize allocations_per_frame = 2000u;
+
+// Simulates per-frame scratch allocations: many small temporaries, all of which
+// are released at the end of the frame.
+void scratch_allocations(const char* label, memory_arena& arena, void(*end_frame)(memory_arena&, void**))
+{
+    void* ptrs[allocations_per_frame];
+    bench::stopwatch watch;
+    for (usize frame = 0u; frame < num_frames; ++frame)
+    {
+        for (usize i = 0u; i < allocations_per_frame; ++i)
+        {
+            ptrs[i] = arena.allocate(16u + (i % 8u) * 24u);
+            bench::do_not_optimize(ptrs[i]);
+        }
+        end_frame(arena, ptrs);
+    }
+    bench::report_throughput(label, num_frames * allocations_per_frame, watch.elapsed_seconds());
+}
+
+void scratch_vectors(const char* label, memory_arena& arena, void(*end_frame)(memory_arena&))
+{
+    bench::stopwatch watch;
+    for (usize frame = 0u; frame < num_frames; ++frame)
+    {
+        for (usize i = 0u; i < 100u; ++i)
+        {
+            pmr::vector<u32> vec{ polymorphic_allocator<u32>(arena) };
+            for (u32 j = 0u; j < 64u; ++j)
+            {
+                vec.push_back(j);
+            }
+            bench::do_not_optimize(vec.data());
+        }
+        end_frame(arena);
+    }
+    bench::report_throughput(label, num_frames * 100u, watch.elapsed_seconds());
+}
+
+}
+
+BENCHMARK(linear_arena_scratch)
+{
+    void* memory = std::malloc(arena_bytes);
+
+    {
+        free_list_arena arena(memory, arena_bytes);
+        scratch_allocations("free_list_arena allocate + free", arena,
+            [](memory_arena& a, void** ptrs) -> void
+            {
+                for (usize i = 0u; i < allocations_per_frame; ++i)
+                {
+                    a.free(ptrs[i]);
+                }
+            });
+    }
+
+    {
+        linear_arena arena(memory, arena_bytes);
+        scratch_allocations("linear_arena allocate + reset", arena,
+            [](memory_arena& a, void**) -> void
+            {
+                static_cast<linear_arena&>(a).reset();
+            });
+    }
+
+    {
+        free_list_arena arena(memory, arena_bytes);
+        scratch_vectors("free_list_arena vector of 64 (vectors/s)", arena, [](memory_arena&) -> void {});
+    }
+
+    {
+        linear_arena arena(memory, arena_bytes);
+        scratch_vectors("linear_arena vector of 64 (vectors/s)", arena,
+            [](memory_arena& a) -> void
+            {
+                static_cast<linear_arena&>(a).reset();
+            });
+    }
+
+    std::free(memory);
+}
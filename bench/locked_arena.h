@@ -0,0 +1,53 @@
+#pragma once
+
+#include "aliases.h"
+#include "memory_arena.h"
+
+#include <mutex>
+
+namespace nlrs
+{
+namespace bench
+{
+
+// The way the arenas used to be shared between threads: a global lock around every call.
+class locked_arena : public memory_arena
+{
+public:
+    explicit locked_arena(memory_arena& backing)
+        : backing_(backing)
+    {}
+
+    void* allocate(usize bytes, u8 alignment = 8u) override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return backing_.allocate(bytes, alignment);
+    }
+
+    void* reallocate(void* ptr, usize new_size) override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return backing_.reallocate(ptr, new_size);
+    }
+
+    void free(void* ptr) override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        backing_.free(ptr);
+    }
+
+#ifdef NLRS_ARENA_STATS
+    arena_stats stats() const override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return backing_.stats();
+    }
+#endif
+
+private:
+    memory_arena&       backing_;
+    mutable std::mutex  mutex_;
+};
+
+}
+}
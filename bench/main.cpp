@@ -0,0 +1,10 @@
+#include "bench.h"
+
+// Usage: bench [filter]
+// Only the benchmarks whose name contains the filter string are run.
+int main(int argc, char** argv)
+{
+    nlrs::bench::run_all(argc > 1 ? argv[1] : nullptr);
+
+    return 0;
+}
@@ -0,0 +1,131 @@
+#include "bench.h"
+#include "memory_arena.h"
+#include "object_pool.h"
+#include "random.h"
+
+#include <iterator>
+#include <vector>
+
+namespace
+{
+
+using namespace nlrs;
+
+const usize num_churn_ops = 2000000u;
+const usize num_iteration_objects = 1024u * 1024u;
+const usize num_iterations = 20u;
+
+struct pipeline_like
+{
+    explicit pipeline_like(u64 shader_id)
+        : shader(shader_id),
+        state{}
+    {}
+
+    u64 shader;
+    u32 state[6];
+};
+
+// Fills a pool with num_live objects, and then releases a random object and creates a new
+// one in its place, over and over. The throughput should not depend on the number of
+// chunks; past the size of the cache, the random choice of the slots makes it drop anyway.
+template<usize N>
+void churn(usize num_live)
+{
+    object_pool<pipeline_like, N> pool(system_arena::get_instance());
+    nlrs::random<usize> rng;
+    rng.seed(1337u);
+    std::vector<pipeline_like*> live(num_live, nullptr);
+
+    bench::stopwatch watch;
+    for (usize i = 0u; i < num_live; ++i)
+    {
+        live[i] = pool.create(u64(i));
+    }
+    char label[64];
+    std::snprintf(label, sizeof(label), "fill %zu, %zu per chunk", num_live, N);
+    bench::report_throughput(label, num_live, watch.elapsed_seconds());
+
+    watch.restart();
+    for (usize i = 0u; i < num_churn_ops; ++i)
+    {
+        pipeline_like*& slot = live[rng(0u, num_live - 1u)];
+        pool.release(slot);
+        slot = pool.create(u64(i));
+        bench::do_not_optimize(slot);
+    }
+    std::snprintf(label, sizeof(label), "churn %zu, %zu per chunk", num_live, N);
+    bench::report_throughput(label, num_churn_ops, watch.elapsed_seconds());
+
+    for (pipeline_like* obj : live)
+    {
+        pool.release(obj);
+    }
+    watch.restart();
+    usize num_freed = pool.release_empty_chunks();
+    std::snprintf(label, sizeof(label), "release_empty_chunks, %zu chunks", num_freed);
+    bench::report_throughput(label, num_live, watch.elapsed_seconds());
+}
+
+}
+
+BENCHMARK(object_pool_growth)
+{
+    for (usize num_live : { usize(32u), usize(1024u), usize(32u * 1024u), usize(1024u * 1024u) })
+    {
+        churn<32u>(num_live);
+    }
+    for (usize num_live : { usize(32u), usize(1024u), usize(32u * 1024u), usize(1024u * 1024u) })
+    {
+        churn<1024u>(num_live);
+    }
+}
+
+namespace
+{
+
+template<usize N>
+void sum_live(const char* label, object_pool<pipeline_like, N>& pool)
+{
+    u64 sum = 0u;
+    bench::stopwatch watch;
+    for (usize i = 0u; i < num_iterations; ++i)
+    {
+        pool.for_each_live([&sum](pipeline_like& obj) -> void { sum += obj.shader; });
+    }
+    bench::do_not_optimize(sum);
+    bench::report_throughput(label, num_iterations * pool.size(), watch.elapsed_seconds());
+}
+
+}
+
+// Iterates over the live objects of a pool in which three quarters of the objects were
+// released at random, before and after compacting it.
+BENCHMARK(object_pool_iteration)
+{
+    object_pool<pipeline_like, 1024u> pool(system_arena::get_instance());
+    std::vector<pipeline_like*> objects;
+    objects.reserve(num_iteration_objects);
+    pool.create_n(num_iteration_objects, std::back_inserter(objects), u64(1u));
+
+    nlrs::random<usize> rng;
+    rng.seed(1337u);
+    for (pipeline_like*& obj : objects)
+    {
+        if (rng(0u, 3u) != 0u)
+        {
+            pool.release(obj);
+        }
+    }
+    sum_live("for_each_live, fragmented", pool);
+
+    bench::stopwatch watch;
+    usize moved = pool.compact([](pipeline_like*, pipeline_like*) -> void {});
+    bench::report_throughput("compact", moved, watch.elapsed_seconds());
+    pool.release_empty_chunks();
+    sum_live("for_each_live, compacted", pool);
+
+    watch.restart();
+    pool.release_all();
+    bench::report_throughput("release_all", num_iteration_objects / 4u, watch.elapsed_seconds());
+}
@@ -0,0 +1,135 @@
+#include "bench.h"
+#include "linear_arena.h"
+#include "memory_arena.h"
+#include "pmr_adapters.h"
+#include "random.h"
+
+#ifdef NLRS_HAS_MEMORY_RESOURCE
+
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+
+using namespace nlrs;
+
+const usize arena_bytes = 256u * 1024u * 1024u;
+const usize num_live = 20000u;
+const usize num_churn_ops = 1000000u;
+const usize num_frames = 1000u;
+const usize allocations_per_frame = 2000u;
+
+// Calls the arena directly, passing the size back on free as the resources require.
+struct arena_calls
+{
+    memory_arena& arena;
+
+    void* allocate(usize bytes) { return arena.allocate(bytes); }
+    void free(void* ptr, usize bytes) { arena.free(ptr, bytes); }
+};
+
+struct resource_calls
+{
+    std::pmr::memory_resource& resource;
+
+    void* allocate(usize bytes) { return resource.allocate(bytes, 8u); }
+    void free(void* ptr, usize bytes) { resource.deallocate(ptr, bytes, 8u); }
+};
+
+// Small object churn: frees a random live object and allocates a new one of a random size.
+template<typename Calls>
+void small_object_churn(const char* label, Calls calls)
+{
+    nlrs::random<usize> rng;
+    rng.seed(1337u);
+    std::vector<void*> live(num_live, nullptr);
+    std::vector<usize> sizes(num_live, 0u);
+
+    for (usize i = 0u; i < num_live; ++i)
+    {
+        sizes[i] = rng(8u, 256u);
+        live[i] = calls.allocate(sizes[i]);
+    }
+
+    bench::stopwatch watch;
+    for (usize i = 0u; i < num_churn_ops; ++i)
+    {
+        usize slot = rng(0u, num_live - 1u);
+        calls.free(live[slot], sizes[slot]);
+        sizes[slot] = rng(8u, 256u);
+        live[slot] = calls.allocate(sizes[slot]);
+        bench::do_not_optimize(live[slot]);
+    }
+    bench::report_throughput(label, num_churn_ops, watch.elapsed_seconds());
+
+    for (usize i = 0u; i < num_live; ++i)
+    {
+        calls.free(live[i], sizes[i]);
+    }
+}
+
+// Per-frame scratch allocations which are all released at the end of the frame.
+template<typename Calls, typename EndFrame>
+void scratch(const char* label, Calls calls, EndFrame end_frame)
+{
+    bench::stopwatch watch;
+    for (usize frame = 0u; frame < num_frames; ++frame)
+    {
+        for (usize i = 0u; i < allocations_per_frame; ++i)
+        {
+            bench::do_not_optimize(calls.allocate(16u + (i % 8u) * 24u));
+        }
+        end_frame();
+    }
+    bench::report_throughput(label, num_frames * allocations_per_frame, watch.elapsed_seconds());
+}
+
+}
+
+BENCHMARK(pmr_pool_resources_over_free_list_arena)
+{
+    void* memory = std::malloc(arena_bytes);
+
+    {
+        free_list_arena arena(memory, arena_bytes);
+        small_object_churn("free_list_arena", arena_calls{ arena });
+    }
+
+    {
+        free_list_arena arena(memory, arena_bytes);
+        arena_memory_resource upstream(arena);
+        std::pmr::unsynchronized_pool_resource pool(&upstream);
+        small_object_churn("unsynchronized_pool_resource", resource_calls{ pool });
+    }
+
+    {
+        free_list_arena arena(memory, arena_bytes);
+        arena_memory_resource upstream(arena);
+        std::pmr::synchronized_pool_resource pool(&upstream);
+        small_object_churn("synchronized_pool_resource", resource_calls{ pool });
+    }
+
+    std::free(memory);
+}
+
+BENCHMARK(pmr_monotonic_resource_vs_linear_arena)
+{
+    void* memory = std::malloc(arena_bytes);
+
+    {
+        linear_arena arena(memory, arena_bytes);
+        scratch("linear_arena allocate + reset", arena_calls{ arena }, [&arena]() { arena.reset(); });
+    }
+
+    {
+        free_list_arena arena(memory, arena_bytes);
+        arena_memory_resource upstream(arena);
+        std::pmr::monotonic_buffer_resource monotonic(&upstream);
+        scratch("monotonic_buffer_resource + release", resource_calls{ monotonic }, [&monotonic]() { monotonic.release(); });
+    }
+
+    std::free(memory);
+}
+
+#endif
@@ -0,0 +1,93 @@
+#include "bench.h"
+#include "random.h"
+#include "relocatable_heap.h"
+
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+
+using namespace nlrs;
+
+// about 10 MiB are live at any time, so the heap fails once it is badly fragmented
+const usize heap_bytes = 12u * 1024u * 1024u;
+const u32 num_live = 4000u;
+const usize num_frames = 2000u;
+const usize replacements_per_frame = 200u;
+const usize defragment_budget = 256u * 1024u;
+
+// Sizes spread evenly over the powers of two from 16 bytes to 16 KiB.
+usize random_size(nlrs::random<usize>& rng)
+{
+    usize order = rng(4u, 13u);
+    return rng(usize(1u) << order, (usize(2u) << order) - 1u);
+}
+
+// Plays a long session in which each frame replaces some of the live blocks by blocks of
+// other sizes, and optionally defragments the heap with a fixed budget at the end of each
+// frame.
+void session(const char* label, bool defragment)
+{
+    std::printf("  %s\n", label);
+    void* memory = std::malloc(heap_bytes);
+    relocatable_heap heap(memory, heap_bytes, num_live);
+    nlrs::random<usize> rng;
+    rng.seed(1337u);
+
+    std::vector<relocatable_heap::handle> live(num_live);
+    for (relocatable_heap::handle& h : live)
+    {
+        h = heap.allocate(random_size(rng));
+    }
+
+    bench::latency_samples defragment_latency(num_frames);
+    usize failed = 0u;
+    usize moved = 0u;
+    bench::stopwatch watch;
+    for (usize frame = 0u; frame < num_frames; ++frame)
+    {
+        for (usize i = 0u; i < replacements_per_frame; ++i)
+        {
+            relocatable_heap::handle& h = live[rng(0u, num_live - 1u)];
+            if (h)
+            {
+                heap.free(h);
+            }
+            h = heap.allocate(random_size(rng));
+            failed += h ? 0u : 1u;
+        }
+        if (defragment)
+        {
+            bench::stopwatch defragment_watch;
+            moved += heap.defragment(defragment_budget);
+            defragment_latency.add(defragment_watch.elapsed_ns());
+        }
+    }
+    bench::report_throughput("replacements", num_frames * replacements_per_frame, watch.elapsed_seconds());
+    if (defragment)
+    {
+        bench::report_latency("defragment", defragment_latency);
+        bench::report_bytes("moved per frame", moved / num_frames);
+    }
+    bench::report_bytes("free", heap.free_bytes());
+    bench::report_bytes("largest free block", heap.largest_free_block());
+    std::printf("  %-40s %10zu\n", "failed allocations", failed);
+
+    for (relocatable_heap::handle h : live)
+    {
+        if (h)
+        {
+            heap.free(h);
+        }
+    }
+    std::free(memory);
+}
+
+}
+
+BENCHMARK(relocatable_heap_session)
+{
+    session("without defragmenting", false);
+    session("defragmenting every frame", true);
+}
@@ -0,0 +1,162 @@
+#include "bench.h"
+#include "locked_arena.h"
+#include "memory_arena.h"
+#include "random.h"
+#include "sharded_arena.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+using namespace nlrs;
+
+const usize arena_bytes = 512u * 1024u * 1024u;
+const usize ops_per_thread = 500000u;
+const usize live_per_thread = 256u;
+const usize results_per_worker = 100000u;
+
+void churn_thread(memory_arena& arena, u32 seed)
+{
+    nlrs::random<usize> rng;
+    rng.seed(seed);
+    void* live[live_per_thread] = { nullptr };
+    for (usize i = 0u; i < ops_per_thread; ++i)
+    {
+        void*& slot = live[rng(0u, live_per_thread - 1u)];
+        arena.free(slot);
+        slot = arena.allocate(rng(8u, 512u));
+        bench::do_not_optimize(slot);
+    }
+    for (void* ptr : live)
+    {
+        arena.free(ptr);
+    }
+}
+
+void local_churn(const char* name, memory_arena& arena, unsigned num_threads)
+{
+    std::vector<std::thread> threads;
+    bench::stopwatch watch;
+    for (unsigned t = 0u; t < num_threads; ++t)
+    {
+        threads.emplace_back(churn_thread, std::ref(arena), t + 1u);
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    char label[64];
+    std::snprintf(label, sizeof(label), "%s, %u threads", name, num_threads);
+    bench::report_throughput(label, num_threads * ops_per_thread, watch.elapsed_seconds());
+}
+
+// Workers allocate results and hand them to a consumer thread, which frees them. The
+// handoff is a single-slot mailbox per worker, so that the queueing itself is cheap.
+void producer_consumer(const char* name, memory_arena& arena, unsigned num_workers)
+{
+    std::vector<std::atomic<void*>> mailboxes(num_workers);
+    for (std::atomic<void*>& mailbox : mailboxes)
+    {
+        mailbox.store(nullptr);
+    }
+    std::atomic<unsigned> workers_done{ 0u };
+
+    bench::stopwatch watch;
+    std::vector<std::thread> threads;
+    for (unsigned w = 0u; w < num_workers; ++w)
+    {
+        threads.emplace_back([&, w]() -> void
+        {
+            for (usize i = 0u; i < results_per_worker; ++i)
+            {
+                void* result = arena.allocate(64u + (i % 8u) * 32u);
+                while (mailboxes[w].load(std::memory_order_acquire))
+                {
+                    std::this_thread::yield();
+                }
+                mailboxes[w].store(result, std::memory_order_release);
+            }
+            workers_done.fetch_add(1u, std::memory_order_release);
+        });
+    }
+
+    // the consumer frees the results on the calling thread
+    while (true)
+    {
+        bool done = workers_done.load(std::memory_order_acquire) == num_workers;
+        bool idle = true;
+        for (std::atomic<void*>& mailbox : mailboxes)
+        {
+            void* result = mailbox.exchange(nullptr, std::memory_order_acquire);
+            if (result)
+            {
+                arena.free(result);
+                idle = false;
+            }
+        }
+        if (done && idle)
+        {
+            break;
+        }
+        if (idle)
+        {
+            std::this_thread::yield();
+        }
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    char label[64];
+    std::snprintf(label, sizeof(label), "%s, %u workers", name, num_workers);
+    bench::report_throughput(label, num_workers * results_per_worker, watch.elapsed_seconds());
+}
+
+}
+
+BENCHMARK(sharded_arena_scaling)
+{
+    void* memory = std::malloc(arena_bytes);
+    unsigned max_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (unsigned num_threads = 1u; num_threads <= max_threads; num_threads *= 2u)
+    {
+        free_list_arena backing(memory, arena_bytes);
+        bench::locked_arena arena(backing);
+        local_churn("locked free_list_arena", arena, num_threads);
+    }
+
+    for (unsigned num_threads = 1u; num_threads <= max_threads; num_threads *= 2u)
+    {
+        sharded_arena arena(memory, arena_bytes, max_threads);
+        local_churn("sharded_arena", arena, num_threads);
+    }
+
+    std::free(memory);
+}
+
+BENCHMARK(sharded_arena_remote_frees)
+{
+    void* memory = std::malloc(arena_bytes);
+    unsigned max_workers = std::max(1u, std::thread::hardware_concurrency() - 1u);
+
+    for (unsigned num_workers = 1u; num_workers <= max_workers; num_workers *= 2u)
+    {
+        free_list_arena backing(memory, arena_bytes);
+        bench::locked_arena arena(backing);
+        producer_consumer("locked free_list_arena", arena, num_workers);
+    }
+
+    for (unsigned num_workers = 1u; num_workers <= max_workers; num_workers *= 2u)
+    {
+        sharded_arena arena(memory, arena_bytes, num_workers + 1u);
+        producer_consumer("sharded_arena", arena, num_workers);
+    }
+
+    std::free(memory);
+}
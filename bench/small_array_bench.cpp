@@ -0,0 +1,54 @@
+#include "bench.h"
+#include "memory_arena.h"
+#include "resizable_array.h"
+#include "small_array.h"
+#include "stl/vector.h"
+
+namespace
+{
+
+using namespace nlrs;
+
+const usize num_lists = 1000000u;
+
+struct attribute
+{
+    i32 location;
+    u32 type;
+};
+
+// Builds num_lists short lists of attributes, like the descriptor options passed to the
+// graphics api, and reads them back.
+template<typename List, typename... Args>
+void build_lists(const char* label, usize length, Args&... args)
+{
+    bench::stopwatch watch;
+    u64 sum = 0u;
+    for (usize i = 0u; i < num_lists; ++i)
+    {
+        List list(args...);
+        for (usize j = 0u; j < length; ++j)
+        {
+            list.push_back(attribute{ i32(j), u32(i) });
+        }
+        for (const attribute& attrib : list)
+        {
+            sum += attrib.type;
+        }
+    }
+    bench::do_not_optimize(sum);
+    bench::report_throughput(label, num_lists, watch.elapsed_seconds());
+}
+
+}
+
+BENCHMARK(small_array_lists)
+{
+    memory_arena& arena = system_arena::get_instance();
+    polymorphic_allocator<attribute> allocator(arena);
+    build_lists<resizable_array<attribute, 6>>("resizable_array, 4 elements", 4u);
+    build_lists<small_array<attribute, 6>>("small_array, 4 elements", 4u, arena);
+    build_lists<pmr::vector<attribute>>("pmr::vector, 4 elements", 4u, allocator);
+    build_lists<small_array<attribute, 6>>("small_array, 12 elements", 12u, arena);
+    build_lists<pmr::vector<attribute>>("pmr::vector, 12 elements", 12u, allocator);
+}
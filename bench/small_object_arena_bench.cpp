@@ -0,0 +1,113 @@
+#include "bench.h"
+#include "memory_arena.h"
+#include "pool_arena.h"
+#include "random.h"
+#include "small_object_arena.h"
+#include "tlsf_arena.h"
+
+#include "stl/unordered_map.h"
+#include <cstdlib>
+#include <list>
+
+namespace
+{
+
+using namespace nlrs;
+
+const usize arena_bytes = 64u * 1024u * 1024u;
+const usize num_keys = 20000u;
+const usize num_map_ops = 1000000u;
+const usize num_list_ops = 1000000u;
+
+// Inserts and erases random keys, so the map keeps allocating and freeing nodes.
+void map_churn(const char* label, memory_arena& arena)
+{
+    nlrs::random<u32> rng;
+    rng.seed(1337u);
+    pmr::unordered_map<u32, u64> map{ 2u * num_keys, std::hash<u32>(), std::equal_to<u32>(),
+        polymorphic_allocator<std::pair<const u32, u64>>(arena) };
+
+    bench::stopwatch watch;
+    for (usize i = 0u; i < num_map_ops; ++i)
+    {
+        u32 key = rng(0u, u32(num_keys));
+        auto it = map.find(key);
+        if (it == map.end())
+        {
+            map.emplace(key, u64(i));
+        }
+        else
+        {
+            map.erase(it);
+        }
+    }
+    bench::do_not_optimize(map.size());
+    bench::report_throughput(label, num_map_ops, watch.elapsed_seconds());
+}
+
+// A queue of list nodes, all of the same size.
+void list_queue(const char* label, memory_arena& arena)
+{
+    std::list<u64, polymorphic_allocator<u64>> list{ polymorphic_allocator<u64>(arena) };
+    for (u64 i = 0u; i < 1000u; ++i)
+    {
+        list.push_back(i);
+    }
+
+    bench::stopwatch watch;
+    for (usize i = 0u; i < num_list_ops; ++i)
+    {
+        list.push_back(u64(i));
+        list.pop_front();
+    }
+    bench::do_not_optimize(list.front());
+    bench::report_throughput(label, num_list_ops, watch.elapsed_seconds());
+}
+
+}
+
+BENCHMARK(small_object_arena_map_churn)
+{
+    void* memory = std::malloc(arena_bytes);
+
+    {
+        free_list_arena arena(memory, arena_bytes);
+        map_churn("free_list_arena", arena);
+    }
+
+    {
+        tlsf_arena arena(memory, arena_bytes);
+        map_churn("tlsf_arena", arena);
+    }
+
+    {
+        free_list_arena backing(memory, arena_bytes);
+        small_object_arena arena(backing);
+        map_churn("small_object_arena over free_list_arena", arena);
+    }
+
+    std::free(memory);
+}
+
+BENCHMARK(pool_arena_list_queue)
+{
+    void* memory = std::malloc(arena_bytes);
+
+    {
+        free_list_arena arena(memory, arena_bytes);
+        list_queue("free_list_arena", arena);
+    }
+
+    {
+        free_list_arena backing(memory, arena_bytes);
+        small_object_arena arena(backing);
+        list_queue("small_object_arena", arena);
+    }
+
+    {
+        pool_arena arena(memory, arena_bytes, 32u);
+        list_queue("pool_arena", arena);
+    }
+
+    std::free(memory);
+}
@@ -0,0 +1,91 @@
+#include "bench.h"
+#include "buffer.h"
+#include "memory_arena.h"
+#include "stack_arena.h"
+
+#include <cstdlib>
+
+namespace
+{
+
+using namespace nlrs;
+
+const usize arena_bytes = 64u * 1024u * 1024u;
+const usize num_rounds = 2000u;
+const usize depth = 1000u;
+
+// Allocates a stack of blocks, and frees them in reverse order.
+void lifo_allocations(const char* label, memory_arena& arena)
+{
+    void* ptrs[depth];
+    bench::stopwatch watch;
+    for (usize round = 0u; round < num_rounds; ++round)
+    {
+        for (usize i = 0u; i < depth; ++i)
+        {
+            ptrs[i] = arena.allocate(16u + (i % 16u) * 16u);
+            bench::do_not_optimize(ptrs[i]);
+        }
+        for (usize i = depth; i > 0u; --i)
+        {
+            arena.free(ptrs[i - 1u]);
+        }
+    }
+    bench::report_throughput(label, num_rounds * depth, watch.elapsed_seconds());
+}
+
+// Grows a buffer one element at a time, doubling the capacity when it runs out.
+void buffer_growth(const char* label, memory_arena& arena)
+{
+    const usize num_elements = 1u << 20u;
+    const usize rounds = 50u;
+    bench::stopwatch watch;
+    for (usize round = 0u; round < rounds; ++round)
+    {
+        buffer<u32> buf(arena, 16u);
+        for (usize i = 0u; i < num_elements; ++i)
+        {
+            if (i == buf.capacity())
+            {
+                buf.reserve(2u * i);
+            }
+            *buf.at(i) = u32(i);
+        }
+        bench::do_not_optimize(*buf.at(num_elements - 1u));
+    }
+    bench::report_throughput(label, rounds * num_elements, watch.elapsed_seconds());
+}
+
+}
+
+BENCHMARK(stack_arena_throughput)
+{
+    void* memory = std::malloc(arena_bytes);
+
+    {
+        free_list_arena arena(memory, arena_bytes);
+        lifo_allocations("free_list_arena lifo allocate + free", arena);
+    }
+
+    {
+        stack_arena arena(memory, arena_bytes);
+        lifo_allocations("stack_arena lifo allocate + free", arena);
+    }
+
+    {
+        stack_arena arena(memory, arena_bytes);
+        lifo_allocations("stack_arena top lifo allocate + free", arena.top());
+    }
+
+    {
+        free_list_arena arena(memory, arena_bytes);
+        buffer_growth("free_list_arena buffer growth (elements/s)", arena);
+    }
+
+    {
+        stack_arena arena(memory, arena_bytes);
+        buffer_growth("stack_arena buffer growth (elements/s)", arena);
+    }
+
+    std::free(memory);
+}
@@ -0,0 +1,79 @@
+#include "bench.h"
+#include "linear_arena.h"
+#include "memory_arena.h"
+#include "static_allocator.h"
+
+#include "stl/unordered_map.h"
+#include "stl/vector.h"
+#include <cstdlib>
+
+namespace
+{
+
+using namespace nlrs;
+
+const usize arena_bytes = 64u * 1024u * 1024u;
+const usize num_frames = 1000u;
+const usize vectors_per_frame = 100u;
+const usize nodes_per_frame = 2000u;
+
+// Many short vectors grown by push_back, so that allocation is a sizeable part of the loop.
+template<typename Vector, typename Allocator>
+void push_backs(const char* label, linear_arena& arena, Allocator allocator)
+{
+    bench::stopwatch watch;
+    for (usize frame = 0u; frame < num_frames; ++frame)
+    {
+        for (usize i = 0u; i < vectors_per_frame; ++i)
+        {
+            Vector vec{ allocator };
+            for (u32 j = 0u; j < 64u; ++j)
+            {
+                vec.push_back(j);
+            }
+            bench::do_not_optimize(vec.data());
+        }
+        arena.reset();
+    }
+    bench::report_throughput(label, num_frames * vectors_per_frame, watch.elapsed_seconds());
+}
+
+// A node based container makes one allocation per insertion.
+template<typename Map, typename Allocator>
+void map_inserts(const char* label, linear_arena& arena, Allocator allocator)
+{
+    bench::stopwatch watch;
+    for (usize frame = 0u; frame < num_frames; ++frame)
+    {
+        {
+            Map map{ 2u * nodes_per_frame, std::hash<u32>(), std::equal_to<u32>(), allocator };
+            for (u32 i = 0u; i < nodes_per_frame; ++i)
+            {
+                map.emplace(i, i);
+            }
+            bench::do_not_optimize(map.size());
+        }
+        arena.reset();
+    }
+    bench::report_throughput(label, num_frames * nodes_per_frame, watch.elapsed_seconds());
+}
+
+}
+
+BENCHMARK(static_allocator_linear_arena)
+{
+    void* memory = std::malloc(arena_bytes);
+    linear_arena arena(memory, arena_bytes);
+
+    push_backs<pmr::vector<u32>>("polymorphic vector of 64 (vectors/s)", arena,
+        polymorphic_allocator<u32>(arena));
+    push_backs<pmr::arena_vector<u32, linear_arena>>("static vector of 64 (vectors/s)", arena,
+        static_allocator<u32, linear_arena>(arena));
+
+    map_inserts<pmr::unordered_map<u32, u32>>("polymorphic unordered_map insert", arena,
+        polymorphic_allocator<std::pair<const u32, u32>>(arena));
+    map_inserts<pmr::arena_unordered_map<u32, u32, linear_arena>>("static unordered_map insert", arena,
+        static_allocator<std::pair<const u32, u32>, linear_arena>(arena));
+
+    std::free(memory);
+}
@@ -0,0 +1,77 @@
+#include "bench.h"
+#include "locked_arena.h"
+#include "memory_arena.h"
+#include "random.h"
+#include "thread_cache_arena.h"
+
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+using namespace nlrs;
+
+const usize arena_bytes = 512u * 1024u * 1024u;
+const usize ops_per_thread = 500000u;
+const usize live_per_thread = 256u;
+
+void churn_thread(memory_arena& arena, u32 seed)
+{
+    nlrs::random<usize> rng;
+    rng.seed(seed);
+    void* live[live_per_thread] = { nullptr };
+    for (usize i = 0u; i < ops_per_thread; ++i)
+    {
+        void*& slot = live[rng(0u, live_per_thread - 1u)];
+        arena.free(slot);
+        slot = arena.allocate(rng(8u, 512u));
+        bench::do_not_optimize(slot);
+    }
+    for (void* ptr : live)
+    {
+        arena.free(ptr);
+    }
+}
+
+void multithreaded_churn(const char* name, memory_arena& arena, unsigned num_threads)
+{
+    std::vector<std::thread> threads;
+    bench::stopwatch watch;
+    for (unsigned t = 0u; t < num_threads; ++t)
+    {
+        threads.emplace_back(churn_thread, std::ref(arena), t + 1u);
+    }
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    char label[64];
+    std::snprintf(label, sizeof(label), "%s, %u threads", name, num_threads);
+    bench::report_throughput(label, num_threads * ops_per_thread, watch.elapsed_seconds());
+}
+
+}
+
+BENCHMARK(thread_cache_arena_scaling)
+{
+    void* memory = std::malloc(arena_bytes);
+    unsigned max_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (unsigned num_threads = 1u; num_threads <= max_threads; num_threads *= 2u)
+    {
+        free_list_arena backing(memory, arena_bytes);
+        bench::locked_arena arena(backing);
+        multithreaded_churn("locked free_list_arena", arena, num_threads);
+    }
+
+    for (unsigned num_threads = 1u; num_threads <= max_threads; num_threads *= 2u)
+    {
+        free_list_arena backing(memory, arena_bytes);
+        thread_cache_arena arena(backing);
+        multithreaded_churn("thread_cache_arena", arena, num_threads);
+    }
+
+    std::free(memory);
+}
@@ -7,6 +7,18 @@ function project_test(location)
     files {
         location.."/common/test/**.cpp",
         location.."/common/src/memory_arena.cpp",
+        location.."/common/src/linear_arena.cpp",
+        location.."/common/src/buddy_arena.cpp",
+        location.."/common/src/pool_arena.cpp",
+        location.."/common/src/small_object_arena.cpp",
+        location.."/common/src/sharded_arena.cpp",
+        location.."/common/src/relocatable_heap.cpp",
+        location.."/common/src/stack_arena.cpp",
+        location.."/common/src/thread_cache_arena.cpp",
+        location.."/common/src/arena_trace.cpp",
+        location.."/common/src/pmr_adapters.cpp",
+        location.."/common/src/tlsf_arena.cpp",
+        location.."/common/src/virtual_arena.cpp",
         location.."/common/src/file_sentry.cpp"
     }
     includedirs { location.."/common/extern/unittest++", location.."/common/include" }
@@ -25,6 +37,53 @@ function project_test(location)
         libdirs { location.."/common/extern/unittest++/lib/osx" }
 end
 
+function project_bench(location)
+    project "bench"
+    kind "ConsoleApp"
+    language "C++"
+    targetdir "bin"
+    files {
+        location.."/common/bench/**.cpp",
+        location.."/common/src/memory_arena.cpp",
+        location.."/common/src/linear_arena.cpp",
+        location.."/common/src/buddy_arena.cpp",
+        location.."/common/src/pool_arena.cpp",
+        location.."/common/src/small_object_arena.cpp",
+        location.."/common/src/sharded_arena.cpp",
+        location.."/common/src/relocatable_heap.cpp",
+        location.."/common/src/stack_arena.cpp",
+        location.."/common/src/thread_cache_arena.cpp",
+        location.."/common/src/arena_trace.cpp",
+        location.."/common/src/pmr_adapters.cpp",
+        location.."/common/src/tlsf_arena.cpp",
+        location.."/common/src/virtual_arena.cpp"
+    }
+    includedirs { location.."/common/include" }
+    debugdir "bin"
+    filter "action:vs*"
+        defines { "_CRT_SECURE_NO_WARNINGS" }
+end
+
+function project_arena_replay(location)
+    project "arena_replay"
+    kind "ConsoleApp"
+    language "C++"
+    targetdir "bin"
+    files {
+        location.."/common/tools/arena_replay/**.cpp",
+        location.."/common/src/arena_trace.cpp",
+        location.."/common/src/buddy_arena.cpp",
+        location.."/common/src/memory_arena.cpp",
+        location.."/common/src/thread_cache_arena.cpp",
+        location.."/common/src/tlsf_arena.cpp",
+        location.."/common/src/virtual_arena.cpp"
+    }
+    includedirs { location.."/common/include", location.."/common/bench" }
+    debugdir "bin"
+    filter "action:vs*"
+        defines { "_CRT_SECURE_NO_WARNINGS" }
+end
+
 function project_common(location)
     project "common"
     kind "StaticLib"
@@ -34,6 +93,18 @@ function project_common(location)
     files {
         location.."/common/include/**.h",
         location.."/common/src/memory_arena.cpp",
+        location.."/common/src/linear_arena.cpp",
+        location.."/common/src/buddy_arena.cpp",
+        location.."/common/src/pool_arena.cpp",
+        location.."/common/src/small_object_arena.cpp",
+        location.."/common/src/sharded_arena.cpp",
+        location.."/common/src/relocatable_heap.cpp",
+        location.."/common/src/stack_arena.cpp",
+        location.."/common/src/thread_cache_arena.cpp",
+        location.."/common/src/arena_trace.cpp",
+        location.."/common/src/pmr_adapters.cpp",
+        location.."/common/src/tlsf_arena.cpp",
+        location.."/common/src/virtual_arena.cpp",
         location.."/common/src/file_sentry.cpp"
     }
 end
@@ -0,0 +1,229 @@
+#pragma once
+
+#include "aliases.h"
+#include "bit_math.h"
+
+#include <algorithm>
+#include <atomic>
+
+// Arena statistics are gathered only when NLRS_ARENA_STATS is defined. Otherwise
+// memory_arena has no stats() function, the arenas carry no bookkeeping state, and
+// NLRS_ARENA_STATS_RECORD expands to nothing.
+#ifdef NLRS_ARENA_STATS
+#define NLRS_ARENA_STATS_RECORD(_EXPR) _EXPR
+#else
+#define NLRS_ARENA_STATS_RECORD(_EXPR)
+#endif
+
+namespace nlrs
+{
+
+// A snapshot of how an arena uses its memory, for sizing arenas from real workloads.
+//
+// Byte counts are in terms of what the arena actually sets aside for each allocation,
+// including its headers, guards, alignment padding and rounding. Arenas which release
+// memory in bulk, such as linear_arena on rewind, can't tell how many allocations were
+// released, and only reset num_allocations when they are emptied completely.
+struct arena_stats
+{
+    const static usize num_size_buckets{ 32u };
+
+    // the number of live allocations
+    usize num_allocations;
+    // the number of allocations made over the lifetime of the arena
+    usize total_allocations;
+    usize bytes_in_use;
+    usize peak_bytes_in_use;
+    // The highest offset into its memory which the arena has ever used. Arenas which
+    // don't manage a contiguous block of memory report the peak bytes in use.
+    usize high_water_mark;
+    // the memory which the arena could still hand out, and the largest single block of it
+    usize free_bytes;
+    usize largest_free_block;
+    // Bucket i counts the requests of [2^i, 2^(i+1)) bytes. Requests larger than that
+    // end up in the last bucket.
+    usize size_histogram[num_size_buckets];
+    // The bytes set aside beyond the requested size, summed over every request in
+    // the corresponding size bucket.
+    usize waste_histogram[num_size_buckets];
+
+    // Returns 0 if the free memory is in one contiguous block, approaching 1 as it is
+    // split into many smaller blocks.
+    inline float fragmentation() const
+    {
+        if (free_bytes == 0u)
+        {
+            return 0.f;
+        }
+        return 1.f - float(largest_free_block) / float(free_bytes);
+    }
+
+    inline usize internal_waste() const
+    {
+        usize waste = 0u;
+        for (usize bytes : waste_histogram)
+        {
+            waste += bytes;
+        }
+        return waste;
+    }
+
+    inline static usize size_bucket(usize bytes)
+    {
+        return bytes == 0u ? 0u : std::min(usize(find_last_set(bytes)), num_size_buckets - 1u);
+    }
+};
+
+// The counters which the arenas update as they allocate and free memory. The free memory
+// is only known to the arena itself, and is filled in when the snapshot is taken.
+class arena_stats_recorder
+{
+public:
+    arena_stats_recorder()
+        : stats_{}
+    {}
+
+    inline void on_allocate(usize requested_bytes, usize block_bytes)
+    {
+        usize bucket = arena_stats::size_bucket(requested_bytes);
+        ++stats_.size_histogram[bucket];
+        stats_.waste_histogram[bucket] += block_bytes > requested_bytes ? block_bytes - requested_bytes : 0u;
+        ++stats_.num_allocations;
+        ++stats_.total_allocations;
+        stats_.bytes_in_use += block_bytes;
+        stats_.peak_bytes_in_use = std::max(stats_.peak_bytes_in_use, stats_.bytes_in_use);
+    }
+
+    inline void on_free(usize block_bytes)
+    {
+        --stats_.num_allocations;
+        stats_.bytes_in_use -= block_bytes;
+    }
+
+    // A live allocation changed size in place.
+    inline void on_resize(usize old_block_bytes, usize new_block_bytes)
+    {
+        stats_.bytes_in_use = stats_.bytes_in_use - old_block_bytes + new_block_bytes;
+        stats_.peak_bytes_in_use = std::max(stats_.peak_bytes_in_use, stats_.bytes_in_use);
+    }
+
+    // Memory was released in bulk, leaving the given number of bytes in use.
+    inline void on_rewind(usize bytes_in_use)
+    {
+        stats_.bytes_in_use = bytes_in_use;
+        if (bytes_in_use == 0u)
+        {
+            stats_.num_allocations = 0u;
+        }
+    }
+
+    inline void on_high_water(usize offset)
+    {
+        stats_.high_water_mark = std::max(stats_.high_water_mark, offset);
+    }
+
+    inline arena_stats snapshot(usize free_bytes, usize largest_free_block) const
+    {
+        arena_stats stats = stats_;
+        stats.high_water_mark = std::max(stats.high_water_mark, stats.peak_bytes_in_use);
+        stats.free_bytes = free_bytes;
+        stats.largest_free_block = largest_free_block;
+        return stats;
+    }
+
+private:
+    arena_stats stats_;
+};
+
+// An arena_stats_recorder for arenas which are used from many threads at once. The counters
+// are relaxed atomics, so recording doesn't serialize the threads. A snapshot taken while
+// other threads allocate is not consistent across counters, but each counter is exact once
+// the threads are done.
+class concurrent_arena_stats_recorder
+{
+public:
+    concurrent_arena_stats_recorder()
+        : num_allocations_(0u),
+        total_allocations_(0u),
+        bytes_in_use_(0u),
+        peak_bytes_in_use_(0u)
+    {
+        for (usize i = 0u; i < arena_stats::num_size_buckets; ++i)
+        {
+            size_histogram_[i].store(0u, std::memory_order_relaxed);
+            waste_histogram_[i].store(0u, std::memory_order_relaxed);
+        }
+    }
+
+    concurrent_arena_stats_recorder(const concurrent_arena_stats_recorder&) = delete;
+    concurrent_arena_stats_recorder& operator=(const concurrent_arena_stats_recorder&) = delete;
+
+    inline void on_allocate(usize requested_bytes, usize block_bytes)
+    {
+        usize bucket = arena_stats::size_bucket(requested_bytes);
+        size_histogram_[bucket].fetch_add(1u, std::memory_order_relaxed);
+        if (block_bytes > requested_bytes)
+        {
+            waste_histogram_[bucket].fetch_add(block_bytes - requested_bytes, std::memory_order_relaxed);
+        }
+        num_allocations_.fetch_add(1u, std::memory_order_relaxed);
+        total_allocations_.fetch_add(1u, std::memory_order_relaxed);
+        raise_peak(bytes_in_use_.fetch_add(block_bytes, std::memory_order_relaxed) + block_bytes);
+    }
+
+    inline void on_free(usize block_bytes)
+    {
+        num_allocations_.fetch_sub(1u, std::memory_order_relaxed);
+        bytes_in_use_.fetch_sub(block_bytes, std::memory_order_relaxed);
+    }
+
+    // A live allocation changed size in place.
+    inline void on_resize(usize old_block_bytes, usize new_block_bytes)
+    {
+        if (new_block_bytes >= old_block_bytes)
+        {
+            usize grown = new_block_bytes - old_block_bytes;
+            raise_peak(bytes_in_use_.fetch_add(grown, std::memory_order_relaxed) + grown);
+        }
+        else
+        {
+            bytes_in_use_.fetch_sub(old_block_bytes - new_block_bytes, std::memory_order_relaxed);
+        }
+    }
+
+    inline arena_stats snapshot(usize free_bytes, usize largest_free_block) const
+    {
+        arena_stats stats{};
+        stats.num_allocations = num_allocations_.load(std::memory_order_relaxed);
+        stats.total_allocations = total_allocations_.load(std::memory_order_relaxed);
+        stats.bytes_in_use = bytes_in_use_.load(std::memory_order_relaxed);
+        stats.peak_bytes_in_use = peak_bytes_in_use_.load(std::memory_order_relaxed);
+        stats.high_water_mark = stats.peak_bytes_in_use;
+        stats.free_bytes = free_bytes;
+        stats.largest_free_block = largest_free_block;
+        for (usize i = 0u; i < arena_stats::num_size_buckets; ++i)
+        {
+            stats.size_histogram[i] = size_histogram_[i].load(std::memory_order_relaxed);
+            stats.waste_histogram[i] = waste_histogram_[i].load(std::memory_order_relaxed);
+        }
+        return stats;
+    }
+
+private:
+    inline void raise_peak(usize bytes_in_use)
+    {
+        usize peak = peak_bytes_in_use_.load(std::memory_order_relaxed);
+        while (peak < bytes_in_use &&
+            !peak_bytes_in_use_.compare_exchange_weak(peak, bytes_in_use, std::memory_order_relaxed))
+        {}
+    }
+
+    std::atomic<usize>  num_allocations_;
+    std::atomic<usize>  total_allocations_;
+    std::atomic<usize>  bytes_in_use_;
+    std::atomic<usize>  peak_bytes_in_use_;
+    std::atomic<usize>  size_histogram_[arena_stats::num_size_buckets];
+    std::atomic<usize>  waste_histogram_[arena_stats::num_size_buckets];
+};
+
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "aliases.h"
+#include "memory_arena.h"
+
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace nlrs
+{
+
+enum class trace_op : u8
+{
+    allocate,
+    reallocate,
+    free
+};
+
+// One record in an allocation trace. Every allocation gets an id when it is made, which
+// stays the same when it is reallocated, so a replay can map the ids to its own pointers.
+// The ids are handed out consecutively from zero.
+//
+// The lifetime of an allocation is the time between its allocate and free events.
+struct trace_event
+{
+    // nanoseconds since the recording started
+    u64         time_ns;
+    // the requested size, or the new size on reallocate. Zero for free.
+    u64         size;
+    u32         id;
+    trace_op    op;
+    u8          alignment;
+    u16         reserved;
+};
+
+static_assert(sizeof(trace_event) == 24u, "trace_event must stay compact");
+
+// A trace file is this header followed by the events as they are laid out in memory, in
+// the byte order of the recording machine.
+struct trace_file_header
+{
+    const static u32 magic_value{ 0x5254414eu }; // "NATR"
+    const static u32 current_version{ 1u };
+
+    u32 magic;
+    u32 version;
+};
+
+// A memory_arena decorator, which forwards every call to the backing arena and streams
+// the events to a trace file. Events are buffered, and written out when the buffer fills
+// up and when the arena is destroyed.
+//
+// Calls into the backing arena are serialized, so that the trace order is the order in
+// which the backing arena saw the calls. The arena must outlive all the allocations made
+// through it, otherwise their frees go unrecorded. Blocks which were allocated from the
+// backing arena before the recording started can still be reallocated and freed through
+// it; those calls are forwarded without being recorded.
+class recording_arena : public memory_arena
+{
+public:
+    const static usize buffer_capacity{ 4096u };
+
+    recording_arena(memory_arena& backing, const char* path);
+    recording_arena() = delete;
+    recording_arena(const recording_arena&) = delete;
+    recording_arena(recording_arena&&) = delete;
+    recording_arena& operator=(const recording_arena&) = delete;
+    recording_arena& operator=(recording_arena&&) = delete;
+    ~recording_arena();
+
+    void* allocate(usize bytes, u8 alignment = 8u)  override;
+    void* reallocate(void* ptr, usize new_size)     override;
+    void  free(void* ptr)                           override;
+    void  free(void* ptr, usize bytes, u8 alignment = 8u) override;
+#ifdef NLRS_ARENA_STATS
+    arena_stats stats() const                       override;
+#endif
+
+    // Returns false if the trace file couldn't be opened. The calls are still forwarded
+    // to the backing arena.
+    inline bool is_recording() const
+    {
+        return file_ != nullptr;
+    }
+
+    // Writes the buffered events to the trace file.
+    void flush();
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    void record(trace_op op, u32 id, usize size, u8 alignment);
+    void write_buffer();
+
+    memory_arena&                   backing_;
+    std::FILE*                      file_;
+    mutable std::mutex              mutex_;
+    clock::time_point               start_;
+    // the ids of the live allocations
+    std::unordered_map<void*, u32>  ids_;
+    u32                             next_id_;
+    std::vector<trace_event>        buffer_;
+};
+
+// Reads a trace written by recording_arena into events. Returns false if the file can't
+// be read, or isn't a trace of the current version.
+bool read_arena_trace(const char* path, std::vector<trace_event>& events);
+
+}
@@ -0,0 +1,367 @@
+#pragma once
+
+#include "aliases.h"
+#include "buffer.h"
+#include "memory_arena.h"
+#include "nlrs_assert.h"
+
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace nlrs
+{
+
+// Whether an object can be moved to a new address by copying its bytes, without calling its
+// move constructor and destructor. This is true for trivially copyable types, and can be
+// specialized for types which merely own memory through a pointer, like array itself.
+template<typename T>
+struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+
+// A dynamic array of T, which gets its memory from a memory_arena through a buffer<T>.
+//
+// The capacity doubles when the array runs out of room, so that appending is amortized O(1).
+// Trivially relocatable elements are moved by reallocating the buffer, which the arena can
+// often do in place, and copied into the array with memcpy. Other elements are moved one by
+// one into a new buffer. Pointers to the elements are invalidated when the array grows.
+//
+// If the arena runs out of memory, the functions which grow the array return false and leave
+// it as it was. emplace_back and push_back can't report it, so for them it is an assertion
+// failure.
+template<typename T>
+class array
+{
+public:
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    array(memory_arena& allocator, usize capacity = 0u);
+    array(array&&);
+    array& operator=(array&&);
+    ~array();
+
+    array() = delete;
+    array(const array&) = delete;
+    array& operator=(const array&) = delete;
+
+    T&          at(usize index);
+    const T&    at(usize index) const;
+    T&          operator[](usize index);
+    const T&    operator[](usize index) const;
+    T&          front() { return at(0u); }
+    const T&    front() const { return at(0u); }
+    T&          back() { return at(size_ - 1u); }
+    const T&    back() const { return at(size_ - 1u); }
+
+    T* data() { return storage_.capacity() ? storage_.at(0u) : nullptr; }
+    const T* data() const { return storage_.capacity() ? storage_.at(0u) : nullptr; }
+
+    iterator begin() { return data(); }
+    iterator end() { return data() + size_; }
+    const_iterator begin() const { return data(); }
+    const_iterator end() const { return data() + size_; }
+    const_iterator cbegin() const { return data(); }
+    const_iterator cend() const { return data() + size_; }
+
+    template<typename... Args>
+    T& emplace_back(Args&&... args);
+    T& push_back(const T& value);
+    T& push_back(T&& value);
+    void pop_back();
+
+    // Copies count elements to the end of the array. The elements may come from the array
+    // itself. Unlike resizing the array and copying the elements in, the new elements are
+    // written only once.
+    bool append(const T* elements, usize count);
+
+    // Increase the capacity of the array to at least new_capacity.
+    bool reserve(usize new_capacity);
+    // New elements are value-initialized, or copied from value.
+    bool resize(usize new_size);
+    bool resize(usize new_size, const T& value);
+    // Changes the size without initializing the new elements, which the caller must write
+    // before reading them. Only for trivial types.
+    bool resize_uninitialized(usize new_size);
+    void clear();
+
+    usize size() const { return size_; }
+    usize capacity() const { return storage_.capacity(); }
+    bool empty() const { return size_ == 0u; }
+    memory_arena& allocator() const { return storage_.allocator(); }
+
+private:
+    // Makes room for at least required elements, growing the capacity geometrically.
+    bool grow_for(usize required);
+    bool relocate(usize new_capacity);
+    void destroy_from(usize index);
+
+    buffer<T>   storage_;
+    usize       size_;
+};
+
+// An array owns its elements through a pointer, so it can be relocated by copying its bytes.
+template<typename T>
+struct is_trivially_relocatable<array<T>> : std::true_type {};
+
+template<typename T>
+array<T>::array(memory_arena& allocator, usize capacity)
+    : storage_(allocator, capacity),
+    size_(0u)
+{}
+
+template<typename T>
+array<T>::array(array&& other)
+    : storage_(std::move(other.storage_)),
+    size_(other.size_)
+{
+    other.size_ = 0u;
+}
+
+template<typename T>
+array<T>& array<T>::operator=(array&& rhs)
+{
+    clear();
+    storage_ = std::move(rhs.storage_);
+    size_ = rhs.size_;
+    rhs.size_ = 0u;
+    return *this;
+}
+
+template<typename T>
+array<T>::~array()
+{
+    clear();
+}
+
+template<typename T>
+T& array<T>::at(usize index)
+{
+    NLRS_ASSERT(index < size_);
+    return *storage_.at(index);
+}
+
+template<typename T>
+const T& array<T>::at(usize index) const
+{
+    NLRS_ASSERT(index < size_);
+    return *storage_.at(index);
+}
+
+template<typename T>
+T& array<T>::operator[](usize index)
+{
+    return at(index);
+}
+
+template<typename T>
+const T& array<T>::operator[](usize index) const
+{
+    return at(index);
+}
+
+template<typename T>
+bool array<T>::grow_for(usize required)
+{
+    usize capacity = storage_.capacity();
+    if (required <= capacity)
+    {
+        return true;
+    }
+    usize new_capacity = capacity == 0u ? 8u : 2u * capacity;
+    return relocate(new_capacity < required ? required : new_capacity);
+}
+
+template<typename T>
+bool array<T>::relocate(usize new_capacity)
+{
+    if (is_trivially_relocatable<T>::value)
+    {
+        return storage_.reserve(new_capacity);
+    }
+    buffer<T> storage(storage_.allocator(), new_capacity);
+    if (storage.capacity() < new_capacity)
+    {
+        return false;
+    }
+    for (usize i = 0u; i < size_; ++i)
+    {
+        T* elem = storage_.at(i);
+        new (storage.at(i)) T(std::move_if_noexcept(*elem));
+        elem->~T();
+    }
+    storage_ = std::move(storage);
+    return true;
+}
+
+template<typename T>
+void array<T>::destroy_from(usize index)
+{
+    if (!std::is_trivially_destructible<T>::value)
+    {
+        for (usize i = index; i < size_; ++i)
+        {
+            storage_.at(i)->~T();
+        }
+    }
+    size_ = index;
+}
+
+template<typename T>
+template<typename... Args>
+T& array<T>::emplace_back(Args&&... args)
+{
+    if (size_ == storage_.capacity())
+    {
+        // the arguments may refer to an element, so the new element is made before growing
+        T value{ std::forward<Args>(args)... };
+        bool grown = grow_for(size_ + 1u);
+        NLRS_ASSERT(grown);
+        (void)grown;
+        T* elem = new (storage_.at(size_)) T(std::move(value));
+        ++size_;
+        return *elem;
+    }
+    T* elem = new (storage_.at(size_)) T{ std::forward<Args>(args)... };
+    ++size_;
+    return *elem;
+}
+
+template<typename T>
+T& array<T>::push_back(const T& value)
+{
+    return emplace_back(value);
+}
+
+template<typename T>
+T& array<T>::push_back(T&& value)
+{
+    return emplace_back(std::move(value));
+}
+
+template<typename T>
+void array<T>::pop_back()
+{
+    NLRS_ASSERT(size_ > 0u);
+    storage_.at(--size_)->~T();
+}
+
+template<typename T>
+bool array<T>::append(const T* elements, usize count)
+{
+    if (count == 0u)
+    {
+        return true;
+    }
+    const T* first = data();
+    if (first && elements >= first && elements < first + size_)
+    {
+        usize offset = usize(elements - first);
+        if (!grow_for(size_ + count))
+        {
+            return false;
+        }
+        elements = data() + offset;
+    }
+    else if (!grow_for(size_ + count))
+    {
+        return false;
+    }
+
+    T* dest = storage_.at(size_);
+    if (std::is_trivially_copyable<T>::value)
+    {
+        std::memcpy(static_cast<void*>(dest), elements, count * sizeof(T));
+    }
+    else
+    {
+        for (usize i = 0u; i < count; ++i)
+        {
+            new (dest + i) T(elements[i]);
+        }
+    }
+    size_ += count;
+    return true;
+}
+
+template<typename T>
+bool array<T>::reserve(usize new_capacity)
+{
+    if (new_capacity > storage_.capacity())
+    {
+        return relocate(new_capacity);
+    }
+    return true;
+}
+
+template<typename T>
+bool array<T>::resize(usize new_size)
+{
+    if (new_size <= size_)
+    {
+        destroy_from(new_size);
+        return true;
+    }
+    if (!grow_for(new_size))
+    {
+        return false;
+    }
+    for (usize i = size_; i < new_size; ++i)
+    {
+        new (storage_.at(i)) T();
+    }
+    size_ = new_size;
+    return true;
+}
+
+template<typename T>
+bool array<T>::resize(usize new_size, const T& value)
+{
+    if (new_size <= size_)
+    {
+        destroy_from(new_size);
+        return true;
+    }
+    if (new_size > storage_.capacity())
+    {
+        // value may be an element
+        T copy(value);
+        if (!grow_for(new_size))
+        {
+            return false;
+        }
+        for (usize i = size_; i < new_size; ++i)
+        {
+            new (storage_.at(i)) T(copy);
+        }
+    }
+    else
+    {
+        for (usize i = size_; i < new_size; ++i)
+        {
+            new (storage_.at(i)) T(value);
+        }
+    }
+    size_ = new_size;
+    return true;
+}
+
+template<typename T>
+bool array<T>::resize_uninitialized(usize new_size)
+{
+    static_assert(std::is_trivial<T>::value, "only trivial elements can be left uninitialized");
+    if (!grow_for(new_size))
+    {
+        return false;
+    }
+    size_ = new_size;
+    return true;
+}
+
+template<typename T>
+void array<T>::clear()
+{
+    destroy_from(0u);
+}
+
+}
@@ -2,6 +2,10 @@
 
 #include "aliases.h"
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 namespace nlrs {
 
 inline u64 next_power_of_two(u64 n) {
@@ -17,4 +21,36 @@ inline u64 next_power_of_two(u64 n) {
     return n;
 }
 
+// Returns the index of the least significant set bit. The argument must not be 0.
+inline u32 find_first_set(u64 n) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, n);
+    return u32(index);
+#else
+    return u32(__builtin_ctzll(n));
+#endif
+}
+
+// Returns the index of the most significant set bit, i.e. floor(log2(n)).
+// The argument must not be 0.
+inline u32 find_last_set(u64 n) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, n);
+    return u32(index);
+#else
+    return u32(63 - __builtin_clzll(n));
+#endif
+}
+
+// Returns the largest power of two which divides the address, up to max_alignment. An
+// allocation is aligned to at least the alignment it was requested with, so arenas which
+// don't store the alignment use this as a conservative guess of it.
+inline u8 alignment_of_address(const void* ptr, u8 max_alignment = 128u) {
+    uptr address = reinterpret_cast<uptr>(ptr);
+    uptr lowest_bit = address & (~address + 1u);
+    return (lowest_bit == 0u || lowest_bit > max_alignment) ? max_alignment : u8(lowest_bit);
+}
+
 }
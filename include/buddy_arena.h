@@ -0,0 +1,105 @@
+#pragma once
+
+#include "aliases.h"
+#include "memory_arena.h"
+
+namespace nlrs
+{
+
+// A binary buddy allocator over a fixed block of memory.
+//
+// Every block is a power of two in size, at an offset which is a multiple of its size.
+// A block of order k, that is of 2^k bytes, is split into two buddies of order k - 1, and
+// the buddy of the block at offset o is at o ^ 2^k. When a block is freed, it is merged
+// with its buddy for as long as the buddy is free and whole, so coalescing is deterministic
+// and doesn't depend on the order of the frees. There is a doubly linked free list for
+// each order, and a bitmap of the non-empty ones, so allocate and free take O(log n) steps.
+//
+// The blocks carry no header. The order and state of each block are kept in a table of
+// one byte per min_block_size bytes at the end of the memory, which also lets free catch
+// double frees. Blocks are aligned to their size, up to the largest alignment a
+// memory_arena supports.
+//
+// Like tlsf_arena, allocate returns nullptr when there is no free block large enough.
+class buddy_arena : public memory_arena
+{
+public:
+    const static usize max_orders{ 64u };
+
+    // The minimum block size must be a power of two, large enough for the free list links.
+    buddy_arena(void* memory, usize num_bytes, usize min_block_size = 32u);
+    buddy_arena() = delete;
+    buddy_arena(const buddy_arena&) = delete;
+    buddy_arena(buddy_arena&&) = delete;
+    buddy_arena& operator=(const buddy_arena&) = delete;
+    buddy_arena& operator=(buddy_arena&&) = delete;
+    ~buddy_arena();
+
+    void* allocate(usize bytes, u8 alignment = 8u)  override;
+    void* reallocate(void* ptr, usize new_size)     override;
+    void  free(void* ptr)                           override;
+    using memory_arena::free;
+#ifdef NLRS_ARENA_STATS
+    arena_stats stats() const                       override;
+#endif
+
+    inline usize num_allocations() const
+    {
+        return alloc_count_;
+    }
+
+    // The size of the block containing the allocation, which is at least the requested size.
+    usize block_size(void* ptr) const;
+
+    // The number of bytes managed by the buddy system, excluding the block table.
+    inline usize capacity() const
+    {
+        return size_;
+    }
+
+    inline usize free_bytes() const
+    {
+        return free_bytes_;
+    }
+
+    // The largest block which could currently be allocated
+    usize largest_free_block() const;
+
+private:
+    struct free_block
+    {
+        free_block* prev;
+        free_block* next;
+    };
+
+    // the table entry of a free block has the free bit set, and the order in the low bits
+    const static u8 free_bit{ 0x80u };
+    const static u8 order_mask{ 0x7fu };
+
+    inline usize offset_of(const void* ptr) const
+    {
+        return usize(static_cast<const u8*>(ptr) - memory_);
+    }
+
+    inline u8& table_entry(usize offset) const
+    {
+        return table_[offset >> min_order_];
+    }
+
+    void insert_free_block(usize offset, u32 order);
+    void remove_free_block(usize offset, u32 order);
+
+    u8*         memory_;
+    usize       size_;
+    u8*         table_;
+    u32         min_order_;
+    u64         free_orders_;
+    free_block* free_lists_[max_orders];
+    usize       free_bytes_;
+    usize       alloc_count_;
+#ifdef NLRS_ARENA_STATS
+    arena_stats_recorder stats_;
+#endif
+};
+
+}
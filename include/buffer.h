@@ -32,19 +32,22 @@ public:
     const T*    operator[](usize index) const;
 
     // Increase the capacity of the container to at least new_size.
-    // If new_size is smaller than the current capacity, then nothing happens
-    void        reserve(usize newSize);
+    // If new_size is smaller than the current capacity, then nothing happens.
+    // Returns false, keeping the old memory, if the allocator runs out of memory.
+    bool        reserve(usize newSize);
     usize       capacity() const;
 
+    memory_arena& allocator() const { return *allocator_; }
+
 private:
-    memory_arena&   allocator_;
+    memory_arena*   allocator_;
     u8*             buffer_;
     usize           capacity_;
 };
 
 template<typename T, size_t alignment>
 buffer<T, alignment>::buffer(memory_arena& allocator, usize capacity)
-    : allocator_(allocator),
+    : allocator_(&allocator),
     buffer_(nullptr),
     capacity_(0u)
 {
@@ -66,7 +69,7 @@ buffer<T, alignment>& buffer<T, alignment>::operator=(buffer&& rhs)
 {
     if (buffer_)
     {
-        allocator_.free(buffer_);
+        allocator_->free(buffer_, sizeof(T) * capacity_, alignment);
     }
     allocator_ = rhs.allocator_;
     buffer_ = rhs.buffer_;
@@ -81,7 +84,7 @@ buffer<T, alignment>::~buffer()
 {
     if (buffer_)
     {
-        allocator_.free(buffer_);
+        allocator_->free(buffer_, sizeof(T) * capacity_, alignment);
     }
 }
 
@@ -112,22 +115,28 @@ const T* buffer<T, alignment>::operator[](usize index) const
 }
 
 template<typename T, size_t alignment>
-void buffer<T, alignment>::reserve(usize new_size)
+bool buffer<T, alignment>::reserve(usize new_size)
 {
-    if (new_size == 0u)
+    if (new_size <= capacity_)
     {
-        return;
+        return true;
     }
+    u8* memory = nullptr;
     if (!buffer_)
     {
-        buffer_ = (u8*)allocator_.allocate(sizeof(T) * new_size, alignment);
-        capacity_ = new_size;
+        memory = (u8*)allocator_->allocate(sizeof(T) * new_size, alignment);
+    }
+    else
+    {
+        memory = (u8*)allocator_->reallocate(buffer_, sizeof(T) * new_size);
     }
-    else if (capacity_ < new_size)
+    if (!memory)
     {
-        buffer_ = (u8*)allocator_.reallocate(buffer_, sizeof(T) * new_size);
-        capacity_ = new_size;
+        return false;
     }
+    buffer_ = memory;
+    capacity_ = new_size;
+    return true;
 }
 
 template<typename T, size_t alignment>
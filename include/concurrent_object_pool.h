@@ -0,0 +1,345 @@
+#pragma once
+
+#include "aliases.h"
+#include "memory_arena.h"
+#include "nlrs_assert.h"
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <utility>
+
+namespace nlrs
+{
+
+// A thread-safe object_pool. Any thread may create objects, and release objects created by
+// any other thread.
+//
+// The free objects are kept on a lock-free Treiber stack. The head of the stack is a 32-bit
+// element index and a 32-bit tag which is incremented by every push and pop, so that a pop
+// can't succeed against a head which was popped and pushed back in the meantime (the ABA
+// problem). The links between the free elements are kept apart from the objects, so that a
+// thread reading a link never races with the thread which owns the object.
+//
+// The pool grows by chunks of N objects, allocated from the arena under a mutex, up to
+// max_chunks chunks; create returns nullptr past that, or if the arena is out of memory.
+// The arena is only used under the mutex, so it doesn't need to be thread-safe itself.
+//
+// Threads which create and release many objects can take a thread_cache, which keeps a
+// few free objects for the thread alone and moves them to and from the shared stack in
+// batches. Like object_pool, the pool doesn't destroy the objects still alive when it is
+// destroyed.
+template<typename T, usize N = 64u>
+class concurrent_object_pool
+{
+public:
+    class thread_cache;
+
+    concurrent_object_pool(memory_arena& allocator, usize max_chunks = 1024u);
+    ~concurrent_object_pool();
+
+    concurrent_object_pool() = delete;
+    concurrent_object_pool(const concurrent_object_pool&) = delete;
+    concurrent_object_pool(concurrent_object_pool&&) = delete;
+    concurrent_object_pool& operator=(const concurrent_object_pool&) = delete;
+    concurrent_object_pool& operator=(concurrent_object_pool&&) = delete;
+
+    template<typename... Args>
+    T* create(Args&&... args);
+    void release(T* object);
+
+    usize num_chunks() const
+    {
+        return num_chunks_.load(std::memory_order_acquire);
+    }
+
+    usize capacity() const
+    {
+        return num_chunks() * N;
+    }
+
+private:
+    struct element
+    {
+        // the element's index in the pool, which never changes
+        u32 index;
+        alignas(T) u8 storage[sizeof(T)];
+    };
+
+    // A chunk starts with the free list links of its elements, followed by the elements.
+    const static usize elements_offset = (N * sizeof(std::atomic<u32>) + alignof(element) - 1u) & ~(alignof(element) - 1u);
+    const static usize chunk_bytes = elements_offset + N * sizeof(element);
+    const static usize chunk_alignment = alignof(element) > alignof(std::atomic<u32>) ? alignof(element) : alignof(std::atomic<u32>);
+    const static u32 no_element = 0xffffffffu;
+
+    inline u8* chunk_of(u32 index) const
+    {
+        return chunks_[index / N].load(std::memory_order_acquire);
+    }
+
+    inline std::atomic<u32>& next_of(u32 index) const
+    {
+        return reinterpret_cast<std::atomic<u32>*>(chunk_of(index))[index % N];
+    }
+
+    inline element* element_at(u32 index) const
+    {
+        return reinterpret_cast<element*>(chunk_of(index) + elements_offset) + index % N;
+    }
+
+    static element* element_of(T* object)
+    {
+        return reinterpret_cast<element*>(reinterpret_cast<u8*>(object) - offsetof(element, storage));
+    }
+
+    static u64 make_head(u32 index, u32 tag)
+    {
+        return (u64(tag) << 32u) | u64(index);
+    }
+
+    // Pushes the chain of elements from first to last, which must already be linked.
+    void push(u32 first, u32 last);
+    u32 pop();
+    // Allocates a new chunk, pushes all but one of its elements, and returns that one.
+    u32 grow();
+
+    template<typename... Args>
+    T* construct(u32 index, Args&&... args)
+    {
+        T* obj = reinterpret_cast<T*>(element_at(index)->storage);
+        new (obj) T{ std::forward<Args>(args)... };
+        return obj;
+    }
+
+    memory_arena&               allocator_;
+    std::atomic<u8*>*           chunks_;
+    const usize                 max_chunks_;
+    std::atomic<usize>          num_chunks_;
+    std::mutex                  grow_mutex_;
+    // the top of the stack of free elements, and its tag
+    alignas(64) std::atomic<u64> head_;
+};
+
+// A cache of free objects for a single thread. It must be destroyed before the pool, and
+// returns its objects to the pool when it is destroyed.
+template<typename T, usize N>
+class concurrent_object_pool<T, N>::thread_cache
+{
+public:
+    const static usize max_cached{ 32u };
+
+    explicit thread_cache(concurrent_object_pool& pool)
+        : pool_(pool),
+        count_(0u)
+    {}
+    ~thread_cache()
+    {
+        flush(count_);
+    }
+
+    thread_cache(const thread_cache&) = delete;
+    thread_cache& operator=(const thread_cache&) = delete;
+
+    template<typename... Args>
+    T* create(Args&&... args)
+    {
+        if (count_ == 0u)
+        {
+            refill();
+            if (count_ == 0u)
+            {
+                return nullptr;
+            }
+        }
+        return pool_.construct(cached_[--count_], std::forward<Args>(args)...);
+    }
+
+    void release(T* object)
+    {
+        object->~T();
+        if (count_ == max_cached)
+        {
+            flush(max_cached / 2u);
+        }
+        cached_[count_++] = element_of(object)->index;
+    }
+
+private:
+    // takes half a cache's worth of elements from the pool, one at a time
+    void refill()
+    {
+        while (count_ < max_cached / 2u)
+        {
+            u32 index = pool_.pop();
+            if (index == no_element)
+            {
+                index = pool_.grow();
+                if (index == no_element)
+                {
+                    return;
+                }
+            }
+            cached_[count_++] = index;
+        }
+    }
+
+    // returns the oldest elements to the pool with a single push
+    void flush(usize num)
+    {
+        if (num == 0u)
+        {
+            return;
+        }
+        for (usize i = 0u; i + 1u < num; ++i)
+        {
+            pool_.next_of(cached_[i]).store(cached_[i + 1u], std::memory_order_relaxed);
+        }
+        pool_.push(cached_[0], cached_[num - 1u]);
+        for (usize i = num; i < count_; ++i)
+        {
+            cached_[i - num] = cached_[i];
+        }
+        count_ -= num;
+    }
+
+    concurrent_object_pool& pool_;
+    usize                   count_;
+    u32                     cached_[max_cached];
+};
+
+template<typename T, usize N>
+concurrent_object_pool<T, N>::concurrent_object_pool(memory_arena& allocator, usize max_chunks)
+    : allocator_(allocator),
+    chunks_(nullptr),
+    max_chunks_(max_chunks),
+    num_chunks_(0u),
+    grow_mutex_(),
+    head_(make_head(no_element, 0u))
+{
+    static_assert(N > 0u, "a chunk must hold at least one object");
+    NLRS_ASSERT(max_chunks > 0u && max_chunks * N < no_element);
+    chunks_ = static_cast<std::atomic<u8*>*>(
+        allocator_.allocate(max_chunks * sizeof(std::atomic<u8*>), u8(alignof(std::atomic<u8*>))));
+    NLRS_ASSERT(chunks_);
+    for (usize i = 0u; i < max_chunks; ++i)
+    {
+        new (chunks_ + i) std::atomic<u8*>(nullptr);
+    }
+}
+
+template<typename T, usize N>
+concurrent_object_pool<T, N>::~concurrent_object_pool()
+{
+    usize num_chunks = num_chunks_.load(std::memory_order_acquire);
+    for (usize i = 0u; i < num_chunks; ++i)
+    {
+        allocator_.free(chunks_[i].load(std::memory_order_relaxed), chunk_bytes, u8(chunk_alignment));
+    }
+    allocator_.free(chunks_, max_chunks_ * sizeof(std::atomic<u8*>), u8(alignof(std::atomic<u8*>)));
+}
+
+template<typename T, usize N>
+void concurrent_object_pool<T, N>::push(u32 first, u32 last)
+{
+    u64 head = head_.load(std::memory_order_relaxed);
+    while (true)
+    {
+        next_of(last).store(u32(head), std::memory_order_relaxed);
+        u64 new_head = make_head(first, u32(head >> 32u) + 1u);
+        if (head_.compare_exchange_weak(head, new_head, std::memory_order_release, std::memory_order_relaxed))
+        {
+            return;
+        }
+    }
+}
+
+template<typename T, usize N>
+u32 concurrent_object_pool<T, N>::pop()
+{
+    u64 head = head_.load(std::memory_order_acquire);
+    while (true)
+    {
+        u32 index = u32(head);
+        if (index == no_element)
+        {
+            return no_element;
+        }
+        // If another thread pops this element first, the link may be stale, but then the
+        // tag has changed and the exchange fails.
+        u32 next = next_of(index).load(std::memory_order_relaxed);
+        u64 new_head = make_head(next, u32(head >> 32u) + 1u);
+        if (head_.compare_exchange_weak(head, new_head, std::memory_order_acquire, std::memory_order_acquire))
+        {
+            return index;
+        }
+    }
+}
+
+template<typename T, usize N>
+u32 concurrent_object_pool<T, N>::grow()
+{
+    std::lock_guard<std::mutex> lock(grow_mutex_);
+
+    // another thread may have grown the pool while this one waited for the lock
+    u32 index = pop();
+    if (index != no_element)
+    {
+        return index;
+    }
+
+    usize chunk_index = num_chunks_.load(std::memory_order_relaxed);
+    if (chunk_index == max_chunks_)
+    {
+        return no_element;
+    }
+    u8* chunk = static_cast<u8*>(allocator_.allocate(chunk_bytes, u8(chunk_alignment)));
+    if (!chunk)
+    {
+        return no_element;
+    }
+
+    const u32 first = u32(chunk_index * N);
+    std::atomic<u32>* links = reinterpret_cast<std::atomic<u32>*>(chunk);
+    element* elements = reinterpret_cast<element*>(chunk + elements_offset);
+    for (u32 i = 0u; i < N; ++i)
+    {
+        new (links + i) std::atomic<u32>(first + i + 1u);
+        elements[i].index = first + i;
+    }
+    chunks_[chunk_index].store(chunk, std::memory_order_release);
+    num_chunks_.store(chunk_index + 1u, std::memory_order_release);
+
+    // the first element is for the caller, and the rest go to the free list
+    if (N > 1u)
+    {
+        push(first + 1u, first + u32(N) - 1u);
+    }
+    return first;
+}
+
+template<typename T, usize N>
+template<typename... Args>
+T* concurrent_object_pool<T, N>::create(Args&&... args)
+{
+    u32 index = pop();
+    if (index == no_element)
+    {
+        index = grow();
+        if (index == no_element)
+        {
+            return nullptr;
+        }
+    }
+    return construct(index, std::forward<Args>(args)...);
+}
+
+template<typename T, usize N>
+void concurrent_object_pool<T, N>::release(T* obj)
+{
+    obj->~T();
+    u32 index = element_of(obj)->index;
+    push(index, index);
+}
+
+}
@@ -2,7 +2,7 @@
 
 #include "aliases.h"
 #include "locator.h"
-#include "resizable_array.h"
+#include "small_array.h"
 #include "vector.h"
 
 #include "stl/vector.h"
@@ -11,9 +11,9 @@ namespace nlrs
 {
 
 using buffer_handle = u64;
-using descriptor_handle = uptr;
+using descriptor_handle = u64;
 using shader_handle = u32;
-using pipeline_handle = uptr;
+using pipeline_handle = u64;
 
 /***
 *       ___       ______
@@ -76,7 +76,7 @@ private:
     attribute_type type_;
 };
 
-using descriptor_options = resizable_array<vertex_attribute, 6>;
+using descriptor_options = small_array<vertex_attribute, 6>;
 
 /***
 *       ______           __
@@ -104,7 +104,7 @@ struct shader_stage
 {
     shader_type type;
     const char* source;
-    resizable_array<uniform_block, 6> uniforms;
+    small_array<uniform_block, 6> uniforms;
 };
 
 /***
@@ -205,7 +205,7 @@ struct compute_options
 {
     shader_handle shader;
     u32 num_groups_x, num_groups_y, num_groups_z;
-    resizable_array<buffer_block, 6> buffers;
+    small_array<buffer_block, 6> buffers;
 };
 
 /***
@@ -225,8 +225,9 @@ public:
     static constexpr shader_handle     invalid_shader{ 0u };
     static constexpr pipeline_handle   invalid_pipeline{ 0u };
 
-    static constexpr usize max_pipelines{ 32u };
-    static constexpr usize max_descriptors{ 32u };
+    // the tables of pipelines and descriptors start with room for this many, and grow as needed
+    static constexpr usize initial_pipeline_capacity{ 32u };
+    static constexpr usize initial_descriptor_capacity{ 32u };
 
     struct pass_options
     {
@@ -259,7 +260,7 @@ public:
     // create a buffer of a given size, but set it's data later
     buffer_handle make_buffer(const buffer_options& opts, usize data_size);
     template<typename T>
-    buffer_handle make_buffer(const buffer_options& opts, const std::pmr::vector<T>& data)
+    buffer_handle make_buffer(const buffer_options& opts, const pmr::vector<T>& data)
     {
         NLRS_ASSERT(data.size() != 0u);
         return make_buffer_with_data(opts, data.data(), sizeof(T) * data.size());
@@ -274,7 +275,7 @@ public:
     buffer_handle make_buffer_with_data(const buffer_options& options, const void* data, usize data_size);
     void set_buffer_data(buffer_handle info, const void* data, usize bytes);
     template<typename T>
-    void set_buffer(buffer_handle info, const std::pmr::vector<T>& data)
+    void set_buffer(buffer_handle info, const pmr::vector<T>& data)
     {
         set_buffer_data(info, data.data(), data.size() * sizeof(T));
     }
@@ -291,7 +292,7 @@ public:
     descriptor_handle make_descriptor(const descriptor_options& attributes);
     void release_descriptor(descriptor_handle info);
 
-    shader_handle make_shader(const std::pmr::vector<shader_stage>&);
+    shader_handle make_shader(const pmr::vector<shader_stage>&);
     // release a shader created with make_shader
     // if the shader is invalid, this does nothing
     void release_shader(shader_handle info);
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "aliases.h"
+#include "memory_arena.h"
+#include "nlrs_assert.h"
+
+namespace nlrs
+{
+
+// A bump allocator over a fixed block of memory. Allocation just advances an offset,
+// and free does nothing. Memory is reclaimed all at once, either by rewinding to a
+// previously taken marker, or by resetting the whole arena.
+//
+// This is intended for short-lived scratch memory, such as temporaries which all die
+// at the end of a frame:
+//
+//  {
+//      linear_arena::scope scope(frame_arena);
+//      pmr::vector<int> temp{ polymorphic_allocator<int>(frame_arena) };
+//      ...
+//  } // everything allocated within the scope is released here
+//
+// The most recent allocation can be reallocated in place. Other allocations are moved to
+// the top of the arena on reallocation, since their sizes aren't stored.
+//
+// Like free_list_arena, allocate returns nullptr when the arena runs out of memory, and so
+// does reallocate, leaving the old allocation as it was.
+//
+// allocate and free are defined in this header, so that they can be inlined into a
+// pointer increment by callers which know the arena type, such as static_allocator.
+class linear_arena : public memory_arena
+{
+public:
+    using marker = usize;
+
+    // Rewinds the arena to the marker taken at construction when the scope ends.
+    class scope
+    {
+    public:
+        explicit scope(linear_arena& arena)
+            : arena_(arena),
+            marker_(arena.get_marker())
+        {}
+        ~scope()
+        {
+            arena_.rewind(marker_);
+        }
+
+        scope() = delete;
+        scope(const scope&) = delete;
+        scope& operator=(const scope&) = delete;
+        scope(scope&&) = delete;
+        scope& operator=(scope&&) = delete;
+
+    private:
+        linear_arena&   arena_;
+        marker          marker_;
+    };
+
+    linear_arena(void* memory, usize num_bytes);
+    linear_arena() = delete;
+    linear_arena(const linear_arena&) = delete;
+    linear_arena(linear_arena&&) = delete;
+    linear_arena& operator=(const linear_arena&) = delete;
+    linear_arena& operator=(linear_arena&&) = delete;
+    ~linear_arena() = default;
+
+    void* allocate(usize bytes, u8 alignment = 8u)  override;
+    void* reallocate(void* ptr, usize new_size)     override;
+    // Does nothing, memory is reclaimed using rewind or reset
+    void  free(void* ptr)                           override;
+    void  free(void* ptr, usize bytes, u8 alignment = 8u) override;
+#ifdef NLRS_ARENA_STATS
+    arena_stats stats() const                       override;
+#endif
+
+    // Returns a marker to the current top of the arena.
+    inline marker get_marker() const
+    {
+        return offset_;
+    }
+
+    // Releases everything allocated after the marker was taken.
+    void rewind(marker m);
+
+    // Releases everything in the arena.
+    inline void reset()
+    {
+        rewind(0u);
+    }
+
+    inline usize used() const
+    {
+        return offset_;
+    }
+
+    inline usize capacity() const
+    {
+        return size_;
+    }
+
+private:
+    u8*         arena_;
+    usize       offset_;
+    const usize size_;
+    // the most recent allocation, which can be resized in place
+    u8*         last_;
+#ifdef NLRS_ARENA_STATS
+    arena_stats_recorder stats_;
+#endif
+};
+
+// Both of these are hot in tight loops, so they are defined here to allow inlining
+inline void* linear_arena::allocate(usize bytes, u8 alignment)
+{
+    NLRS_ASSERT((alignment & (alignment - 1u)) == 0u);
+    if (bytes == 0u)
+    {
+        return nullptr;
+    }
+
+    uptr top = reinterpret_cast<uptr>(arena_) + offset_;
+    uptr aligned = (top + (alignment - 1u)) & ~uptr(alignment - 1u);
+    usize new_offset = offset_ + usize(aligned - top) + bytes;
+    if (new_offset > size_)
+    {
+        return nullptr;
+    }
+
+    NLRS_ARENA_STATS_RECORD(stats_.on_allocate(bytes, new_offset - offset_));
+    NLRS_ARENA_STATS_RECORD(stats_.on_high_water(new_offset));
+    offset_ = new_offset;
+    last_ = reinterpret_cast<u8*>(aligned);
+    return last_;
+}
+
+inline void linear_arena::free(void*)
+{}
+
+inline void linear_arena::free(void*, usize, u8)
+{}
+
+}
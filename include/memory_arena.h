@@ -1,8 +1,10 @@
 #pragma once
 
 #include "aliases.h"
+#include "arena_stats.h"
 #include "locator.h"
 
+#include <atomic>
 #include <scoped_allocator>
 #include <type_traits>
 
@@ -31,12 +33,39 @@ public:
     //Free a block of memory previously allocated here. If the pointer is null,
     //then nothing happens.
     virtual void free(void* ptr) = 0;
+
+    // Free a block of memory whose size is known to the caller. The size and alignment
+    // must be the ones passed to allocate, or the size passed to the latest reallocate.
+    //
+    // Arenas which can find the block from its size alone override this to skip reading
+    // the block's header. By default this just calls free(ptr).
+    virtual void free(void* ptr, usize bytes, u8 alignment = 8u)
+    {
+        (void)bytes;
+        (void)alignment;
+        free(ptr);
+    }
+
+#ifdef NLRS_ARENA_STATS
+    // Returns a snapshot of the arena's allocation statistics.
+    virtual arena_stats stats() const = 0;
+#endif
 };
 
-// A wrapper around malloc, realloc, and free.
+// A wrapper around malloc, realloc, and free, which honours the requested alignment.
+//
+// Allocations of at least huge_page_threshold bytes are mapped directly from the operating
+// system instead. On Linux the mapping is aligned to the huge page size and advised to be
+// backed by transparent huge pages, which reduces TLB misses on large arrays.
+//
+// Every allocation is preceded by a small header, which records how it was allocated.
+// The arena is safe to use from multiple threads.
 class system_arena : public memory_arena
 {
 public:
+    const static usize huge_page_size{ 2u * 1024u * 1024u };
+    const static usize huge_page_threshold{ huge_page_size };
+
     ~system_arena();
     system_arena(const system_arena&) = delete;
     system_arena& operator=(const system_arena&) = delete;
@@ -48,42 +77,86 @@ public:
     void* allocate(usize bytes, u8 alignment = 8u)  override;
     void* reallocate(void* ptr, usize newSize)      override;
     void  free(void* ptr)                           override;
+    using memory_arena::free;
+#ifdef NLRS_ARENA_STATS
+    // The system arena holds no free memory of its own, so the free memory is reported as zero.
+    arena_stats stats() const                       override;
+#endif
+
+    inline unsigned int num_allocations() const
+    {
+        return (unsigned int)alloc_count_.load(std::memory_order_relaxed);
+    }
 
 private:
     system_arena() = default;
 
-    int alloc_count_{ 0 };
+    std::atomic<int> alloc_count_{ 0 };
+#ifdef NLRS_ARENA_STATS
+    concurrent_arena_stats_recorder stats_;
+#endif
 };
 
 // This allocator manages the memory within a memory arena by mainting a linked list
 // of freed memory blocks. As memory is freed, it merges adjacent free blocks into
-// larger free blocks. Memory is allocated from the free list on a first-fit policy.
+// larger free blocks.
+//
+// Free blocks are additionally kept in segregated lists, one per power-of-two size
+// class. A free block of size s lives in class floor(log2(s)), so every block in
+// class k is at least 2^k bytes large. Since allocated blocks are always powers of two,
+// any block in a class at least as large as the requested block fits. A bitmap of the
+// non-empty classes lets allocate find such a block in constant time.
+//
+// Every block starts with a boundary tag, which contains the block size and flags telling
+// whether the block itself and the block physically preceding it are allocated. Free
+// blocks also store their size in their last word. When a block is freed, its neighbours
+// are found directly from these tags and merged in constant time. The top of the used
+// region is marked by an allocated sentinel tag, so that blocks are never merged past it.
 //
 // The actual block size allocated is never exactly the same as the requested size.
 // The allocated block size is rounded up to the next power of 2. The largest expected
 // user of this allocator is the array, which uses realloc on resize. If the block is
-// already large enough to hold the new size, then nothing need be done.
+// already large enough to hold the new size, then nothing need be done. Otherwise the
+// block is grown in place if the block physically following it is free, or if the block
+// is at the top of the used region.
+//
+// When a free block larger than the requested block is reused, the rest of it is split
+// off and returned to the free list.
 //
 // Ideally, larger, power-of-two blocks would reduce memory fragmentation.
 //
-// This allocator writes certain magic numbers into memory for debugging purposes.
-// Memory blocks are surrounded by the 0xBEEFCAFE magic number.
-// When NARWHAL_DEBUG is defined, allocated but uninitialized memory is set to 0xA5
-// When NARWHAL_DEBUG is defined, freed memory is set to 0xEE.
-class free_list_arena : public memory_arena
+// What the free_list_arena writes into memory for debugging purposes is decided by its
+// debug policy. The policy has two flags:
+//
+// guard_blocks: every block carries a header with its size and alignment, and the user's
+// memory is surrounded by the 0xBEEFCAFE magic number. The guards are checked when the
+// block is freed.
+// fill_memory: allocated but uninitialized memory is set to 0xA5, and freed memory is
+// set to 0xEE.
+//
+// Without guards the block layout is compact: the user's memory follows the boundary tag
+// directly, so a block only carries one word of overhead. Allocations aligned to more than
+// a word are preceded by a single padding word, which records their offset and alignment.
+template<typename DebugPolicy>
+class basic_free_list_arena : public memory_arena
 {
 public:
-    free_list_arena(void* memory, usize num_bytes);
-    free_list_arena() = delete;
-    free_list_arena(const free_list_arena&) = delete;
-    free_list_arena(free_list_arena&&) = delete;
-    free_list_arena& operator=(const free_list_arena&) = delete;
-    free_list_arena& operator=(free_list_arena&&) = delete;
-    ~free_list_arena();
+    basic_free_list_arena(void* memory, usize num_bytes);
+    basic_free_list_arena() = delete;
+    basic_free_list_arena(const basic_free_list_arena&) = delete;
+    basic_free_list_arena(basic_free_list_arena&&) = delete;
+    basic_free_list_arena& operator=(const basic_free_list_arena&) = delete;
+    basic_free_list_arena& operator=(basic_free_list_arena&&) = delete;
+    ~basic_free_list_arena();
 
     void* allocate(usize bytes, u8 alignment = 8u)  override;
     void* reallocate(void* ptr, usize new_size)      override;
     void  free(void* ptr)                           override;
+    using memory_arena::free;
+#ifdef NLRS_ARENA_STATS
+    // The free memory includes the unused space above the top of the used region.
+    arena_stats stats() const                       override;
+#endif
 
     inline unsigned int num_free_blocks() const
     {
@@ -95,14 +168,44 @@ public:
         return (unsigned int)alloc_count_;
     }
 
+    // The size of the whole block containing the allocation, including its overhead.
     inline usize block_size(void* ptr) const
     {
-        header* hdr = static_cast<header*>(ptr) - 1u;
-        return hdr->size;
+        return tag_size(*reinterpret_cast<const usize*>(block_start_of(ptr)));
     }
 
+    // The number of bytes of the allocation which the user can use, which may be more than
+    // was requested.
+    inline usize usable_size(void* ptr) const
+    {
+        u8* block_start = block_start_of(ptr);
+        return capacity_of(ptr, block_start, tag_size(*reinterpret_cast<const usize*>(block_start)));
+    }
+
+    // The alignment which the allocation was requested with.
+    inline u8 alignment(void* ptr) const
+    {
+        return alignment_of(ptr);
+    }
+
+protected:
+    // Called when a block doesn't fit between the top of the used region and the end of
+    // the arena. A derived arena can make more memory available directly after the current
+    // end, and return the new size of the arena, which should be at least required_size.
+    // By default the arena doesn't grow, and allocate returns nullptr.
+    virtual usize grow(usize required_size);
+
+    // If the last block before the top of the used region is free, it is removed from the
+    // free list and the top is moved down. Returns the new offset of the top, after which
+    // only the sentinel tag is used.
+    usize trim_top();
+
+    // Shrinks the arena to the given size, which must leave room for the sentinel tag at
+    // the top of the used region.
+    void shrink(usize size);
+
 private:
-    // the location of the allocated memory will be
+    // With guard_blocks, the location of the allocated memory will be
     // sizeof(header) + offset bytes after the guard bytes
     struct header
     {
@@ -111,27 +214,85 @@ private:
         u8      alignment;
     };
 
+    // A free block begins with its tag, like every other block. The block size is also
+    // stored in the last word of the block.
     struct free_block
     {
-        usize size;
-        free_block*  next;
+        usize       tag;
+        // neighbouring free blocks in the same size class
+        free_block* next_in_class;
+        free_block* prev_in_class;
     };
 
-    static void* annotate_memory(void* memory, usize bytes, u8 align_offset);
-
+    // the lowest bits of the tag are free, since block sizes are multiples of min_block_size
+    const static usize  tag_allocated{ 1u };
+    const static usize  tag_prev_allocated{ 2u };
+    const static usize  tag_flags{ tag_allocated | tag_prev_allocated };
+    // Marks the padding word of the compact layout, which is never a valid block tag.
+    // The alignment and the offset of the user's memory are stored above the flag.
+    const static usize  tag_padding{ 4u };
+    const static usize  padding_alignment_shift{ 8u };
+    const static usize  padding_offset_shift{ 16u };
+
+    static usize tag_size(usize tag) { return tag & ~tag_flags; }
+
+    // The number of bytes of a block which can't hold the user's memory, in the worst case.
+    static usize block_overhead(u8 alignment);
+    // Writes the block's guards and header, and returns the user's memory.
+    static void* annotate_memory(void* memory, usize bytes, u8 alignment);
+    static u8* block_start_of(void* ptr);
+    static u8 alignment_of(void* ptr);
+    // The number of bytes available to the user in the block containing ptr.
+    static usize capacity_of(void* ptr, u8* block_start, usize block_size);
+
+    void insert_into_size_class(free_block* block);
+    void remove_from_size_class(free_block* block);
+    // Shrinks the allocated block to used_size bytes, if the rest is large enough to be a
+    // free block of its own. Returns the resulting size of the allocated block.
+    usize split_block(u8* block, usize block_size, usize used_size);
+
+    const static u32    num_tag_bytes{ sizeof(usize) };
     const static u32    guard_byte{ sizeof(u32) };
     const static u32    num_guard_bytes{ 2u * sizeof(u32) };
     const static u32    num_header_bytes{ sizeof(header) };
+    const static u32    num_size_classes{ 64u };
     const static usize  min_block_size;
 
     int               alloc_count_;
     unsigned int      free_list_size_;
     void*             arena_;
     usize             offset_;
-    const usize       size_;
-    free_block*       free_list_head_;
+    usize             size_;
+    // bit i is set if size_classes_[i] is non-empty
+    u64               size_class_bits_;
+    free_block*       size_classes_[num_size_classes];
+#ifdef NLRS_ARENA_STATS
+    arena_stats_recorder stats_;
+#endif
 };
 
+struct free_list_debug_policy
+{
+    const static bool guard_blocks{ true };
+    const static bool fill_memory{ true };
+};
+
+struct free_list_release_policy
+{
+    const static bool guard_blocks{ false };
+    const static bool fill_memory{ false };
+};
+
+// Both policies are instantiated in memory_arena.cpp
+extern template class basic_free_list_arena<free_list_debug_policy>;
+extern template class basic_free_list_arena<free_list_release_policy>;
+
+#ifdef NLRS_DEBUG
+using free_list_arena = basic_free_list_arena<free_list_debug_policy>;
+#else
+using free_list_arena = basic_free_list_arena<free_list_release_policy>;
+#endif
+
 using free_list_locator = locator<memory_arena, 0>;
 using system_memory_locator = locator<memory_arena, 1>;
 
@@ -148,7 +309,7 @@ public:
     using value_type = T;
 
     using pointer = T*;
-    using const_pointer = T*;
+    using const_pointer = const T*;
 
     using propagate_on_container_copy_assignment = std::false_type;
     using propagate_on_container_move_assignment = std::true_type;
@@ -178,10 +339,9 @@ public:
         return (T*)arena_.allocate(sizeof(T) * n, alignof(T));
     }
 
-    void deallocate(T* ptr, usize)
+    void deallocate(T* ptr, usize n)
     {
-        // TODO: assert that n is the same as before
-        arena_.free(ptr);
+        arena_.free(ptr, sizeof(T) * n, alignof(T));
     }
 
     template<typename U>
@@ -1,15 +1,32 @@
 #pragma once
 
 #include "aliases.h"
+#include "bit_math.h"
 #include "memory_arena.h"
 #include "nlrs_assert.h"
-#include "buffer.h"
 
+#include <cstddef>
+#include <new>
 #include <utility>
 
 namespace nlrs
 {
 
+// A pool of objects of type T, which grows by chaining chunks of N objects allocated from
+// its memory_arena. Chunks are never moved, so pointers to the objects stay valid for as
+// long as the objects live.
+//
+// create and release are O(1): released objects go on an intrusive free list, and a new
+// chunk is only allocated when the free list is exhausted. create returns nullptr only if
+// the arena can't provide a new chunk.
+//
+// Each chunk has a bitmap of its live objects, so that for_each_live and release_all can
+// visit the live objects without the caller tracking them. Each object also carries a
+// pointer to its chunk, which is how release finds the bit to clear.
+//
+// Chunks are kept when they become empty, so that a pool which oscillates in size doesn't
+// allocate and free chunks over and over. Call release_empty_chunks to return them to the
+// arena. Objects still alive when the pool is destroyed are not destroyed.
 template<typename T, usize N = 32u>
 class object_pool
 {
@@ -17,7 +34,7 @@ public:
     object_pool(memory_arena& allocator);
     object_pool(object_pool&&);
     object_pool& operator=(object_pool&&);
-    ~object_pool() = default;
+    ~object_pool();
 
     object_pool() = delete;
     object_pool(const object_pool&) = delete;
@@ -27,11 +44,42 @@ public:
     T* create(Arg&&... args);
     void release(T* object);
 
+    // Creates up to count objects from the same arguments, and writes pointers to them to
+    // out. Returns the number of objects created, which is less than count only if the arena
+    // ran out of memory.
+    template<typename OutputIt, typename... Arg>
+    usize create_n(usize count, OutputIt out, const Arg&... args);
+
+    // Releases every live object.
+    void release_all();
+
+    // Calls f with a reference to each live object, oldest chunk first. f may release the
+    // object it is given, but must not create objects.
+    template<typename F>
+    void for_each_live(F f);
+
+    // Moves live objects out of the newest chunks into the free slots of the oldest ones, so
+    // that the live objects fill the first size() slots, and new objects are created right
+    // after them. Pointers to the moved objects are invalidated: relocate(from, to) is called
+    // for each moved object, after the object has been moved to `to`, and `from` destroyed.
+    // Returns the number of objects moved.
+    template<typename Relocate>
+    usize compact(Relocate relocate);
+
+    // Frees the chunks which hold no live objects, and returns the number of chunks freed.
+    // This takes O(capacity()) steps.
+    usize release_empty_chunks();
+
     usize size() const { return size_; }
+    usize capacity() const { return num_chunks_ * N; }
+    usize num_chunks() const { return num_chunks_; }
 
 private:
+    struct chunk;
+
     struct alignas(8) element
     {
+        chunk* owner;
         union
         {
             element* next;
@@ -39,24 +87,97 @@ private:
         };
     };
 
-    buffer<element> buffer_;
+    static_assert(N > 0u, "a chunk must hold at least one object");
+    const static usize num_words = (N + 63u) / 64u;
+
+    struct chunk
+    {
+        // towards the older chunks
+        chunk* next;
+        // towards the newer chunks
+        chunk* prev;
+        // a bit for each live object
+        u64 live[num_words];
+    };
+
+    const static usize elements_offset = (sizeof(chunk) + alignof(element) - 1u) & ~(alignof(element) - 1u);
+    const static usize chunk_bytes = elements_offset + N * sizeof(element);
+    const static usize chunk_alignment = alignof(chunk) > alignof(element) ? alignof(chunk) : alignof(element);
+
+    static element* elements_of(chunk* c)
+    {
+        return reinterpret_cast<element*>(reinterpret_cast<u8*>(c) + elements_offset);
+    }
+
+    static T* object_of(element* elem)
+    {
+        return reinterpret_cast<T*>(&elem->buffer[0]);
+    }
+
+    static element* element_of(T* obj)
+    {
+        return reinterpret_cast<element*>(reinterpret_cast<u8*>(obj) - offsetof(element, buffer));
+    }
+
+    static bool is_live(chunk* c, usize i)
+    {
+        return (c->live[i / 64u] >> (i % 64u)) & 1u;
+    }
+
+    static void set_live(chunk* c, usize i, bool live)
+    {
+        u64 bit = u64(1u) << (i % 64u);
+        c->live[i / 64u] = live ? c->live[i / 64u] | bit : c->live[i / 64u] & ~bit;
+    }
+
+    static bool is_empty(const chunk* c)
+    {
+        for (usize w = 0u; w < num_words; ++w)
+        {
+            if (c->live[w])
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool add_chunk();
+    // Rebuilds the free list from the bitmaps, so that the oldest free slots come first.
+    void rebuild_free_list();
+    void free_chunks();
+
+    memory_arena* allocator_;
+    // the newest chunk, and the oldest
+    chunk* chunks_;
+    chunk* oldest_chunk_;
+    usize num_chunks_;
     usize size_;
     element* head_;
 };
 
 template<typename T, usize N>
 object_pool<T, N>::object_pool(memory_arena& allocator)
-    : buffer_(allocator, N),
+    : allocator_(&allocator),
+    chunks_(nullptr),
+    oldest_chunk_(nullptr),
+    num_chunks_(0u),
     size_(0u),
     head_(nullptr)
 {}
 
 template<typename T, usize N>
 object_pool<T, N>::object_pool(object_pool&& other)
-    : buffer_(std::move(other.buffer_)),
+    : allocator_(other.allocator_),
+    chunks_(other.chunks_),
+    oldest_chunk_(other.oldest_chunk_),
+    num_chunks_(other.num_chunks_),
     size_(other.size_),
     head_(other.head_)
 {
+    other.chunks_ = nullptr;
+    other.oldest_chunk_ = nullptr;
+    other.num_chunks_ = 0u;
     other.size_ = 0u;
     other.head_ = nullptr;
 }
@@ -64,10 +185,18 @@ object_pool<T, N>::object_pool(object_pool&& other)
 template<typename T, usize N>
 object_pool<T, N>& object_pool<T, N>::operator=(object_pool<T, N>&& rhs)
 {
-    buffer_ = std::move(rhs.buffer_);
+    free_chunks();
+
+    allocator_ = rhs.allocator_;
+    chunks_ = rhs.chunks_;
+    oldest_chunk_ = rhs.oldest_chunk_;
+    num_chunks_ = rhs.num_chunks_;
     size_ = rhs.size_;
     head_ = rhs.head_;
 
+    rhs.chunks_ = nullptr;
+    rhs.oldest_chunk_ = nullptr;
+    rhs.num_chunks_ = 0u;
     rhs.size_ = 0u;
     rhs.head_ = nullptr;
 
@@ -75,24 +204,93 @@ object_pool<T, N>& object_pool<T, N>::operator=(object_pool<T, N>&& rhs)
 }
 
 template<typename T, usize N>
-template<typename... Args>
-T* object_pool<T, N>::create(Args&&... args)
+object_pool<T, N>::~object_pool()
+{
+    free_chunks();
+}
+
+template<typename T, usize N>
+void object_pool<T, N>::free_chunks()
 {
-    if (size_ == buffer_.capacity())
+    while (chunks_)
     {
-        return nullptr;
+        chunk* next = chunks_->next;
+        allocator_->free(chunks_, chunk_bytes, u8(chunk_alignment));
+        chunks_ = next;
     }
-    T* obj = nullptr;
-    if (head_)
+    oldest_chunk_ = nullptr;
+    num_chunks_ = 0u;
+    head_ = nullptr;
+}
+
+template<typename T, usize N>
+bool object_pool<T, N>::add_chunk()
+{
+    chunk* c = static_cast<chunk*>(allocator_->allocate(chunk_bytes, u8(chunk_alignment)));
+    if (!c)
+    {
+        return false;
+    }
+    c->next = chunks_;
+    c->prev = nullptr;
+    for (usize w = 0u; w < num_words; ++w)
     {
-        obj = reinterpret_cast<T*>(&head_->buffer[0]);
-        head_ = head_->next;
+        c->live[w] = 0u;
+    }
+    if (chunks_)
+    {
+        chunks_->prev = c;
     }
     else
     {
-        obj = reinterpret_cast<T*>(&buffer_.at(size_)->buffer[0]);
+        oldest_chunk_ = c;
+    }
+    chunks_ = c;
+    ++num_chunks_;
+
+    // push the elements in reverse, so that they are handed out in address order
+    element* elements = elements_of(c);
+    for (usize i = N; i-- > 0u;)
+    {
+        elements[i].owner = c;
+        elements[i].next = head_;
+        head_ = elements + i;
+    }
+    return true;
+}
+
+template<typename T, usize N>
+void object_pool<T, N>::rebuild_free_list()
+{
+    element** tail = &head_;
+    for (chunk* c = oldest_chunk_; c; c = c->prev)
+    {
+        element* elements = elements_of(c);
+        for (usize i = 0u; i < N; ++i)
+        {
+            if (!is_live(c, i))
+            {
+                *tail = elements + i;
+                tail = &elements[i].next;
+            }
+        }
+    }
+    *tail = nullptr;
+}
+
+template<typename T, usize N>
+template<typename... Args>
+T* object_pool<T, N>::create(Args&&... args)
+{
+    if (!head_ && !add_chunk())
+    {
+        return nullptr;
     }
+    element* elem = head_;
+    head_ = head_->next;
+    set_live(elem->owner, usize(elem - elements_of(elem->owner)), true);
 
+    T* obj = object_of(elem);
     new (obj) T{ std::forward<Args>(args)... };
     ++size_;
 
@@ -104,10 +302,128 @@ void object_pool<T, N>::release(T* obj)
 {
     NLRS_ASSERT(size_ > 0);
     obj->~T();
-    element* elem = reinterpret_cast<element*>(obj);
+    element* elem = element_of(obj);
+    usize index = usize(elem - elements_of(elem->owner));
+    NLRS_ASSERT(is_live(elem->owner, index));
+    set_live(elem->owner, index, false);
     elem->next = head_;
     head_ = elem;
     --size_;
 }
 
+template<typename T, usize N>
+template<typename OutputIt, typename... Args>
+usize object_pool<T, N>::create_n(usize count, OutputIt out, const Args&... args)
+{
+    for (usize i = 0u; i < count; ++i)
+    {
+        T* obj = create(args...);
+        if (!obj)
+        {
+            return i;
+        }
+        *out++ = obj;
+    }
+    return count;
+}
+
+template<typename T, usize N>
+template<typename F>
+void object_pool<T, N>::for_each_live(F f)
+{
+    for (chunk* c = oldest_chunk_; c; c = c->prev)
+    {
+        element* elements = elements_of(c);
+        for (usize w = 0u; w < num_words; ++w)
+        {
+            u64 bits = c->live[w];
+            while (bits)
+            {
+                f(*object_of(elements + w * 64u + find_first_set(bits)));
+                bits &= bits - 1u;
+            }
+        }
+    }
+}
+
+template<typename T, usize N>
+void object_pool<T, N>::release_all()
+{
+    for_each_live([](T& obj) -> void { obj.~T(); });
+    for (chunk* c = chunks_; c; c = c->next)
+    {
+        for (usize w = 0u; w < num_words; ++w)
+        {
+            c->live[w] = 0u;
+        }
+    }
+    size_ = 0u;
+    rebuild_free_list();
+}
+
+template<typename T, usize N>
+template<typename Relocate>
+usize object_pool<T, N>::compact(Relocate relocate)
+{
+    // Every free slot among the first size_ slots is filled with a live object from past
+    // them, taken from the back. There are as many of one as of the other.
+    usize moved = 0u;
+    chunk* back = chunks_;
+    usize back_index = N;
+    usize position = 0u;
+    for (chunk* c = oldest_chunk_; c && position < size_; c = c->prev)
+    {
+        element* elements = elements_of(c);
+        for (usize i = 0u; i < N && position < size_; ++i, ++position)
+        {
+            if (is_live(c, i))
+            {
+                continue;
+            }
+            do
+            {
+                if (back_index == 0u)
+                {
+                    back = back->next;
+                    back_index = N;
+                }
+                --back_index;
+            } while (!is_live(back, back_index));
+
+            T* from = object_of(elements_of(back) + back_index);
+            T* to = object_of(elements + i);
+            new (to) T(std::move(*from));
+            from->~T();
+            set_live(back, back_index, false);
+            set_live(c, i, true);
+            relocate(from, to);
+            ++moved;
+        }
+    }
+    rebuild_free_list();
+    return moved;
+}
+
+template<typename T, usize N>
+usize object_pool<T, N>::release_empty_chunks()
+{
+    usize num_freed = 0u;
+    chunk* c = chunks_;
+    while (c)
+    {
+        chunk* next = c->next;
+        if (is_empty(c))
+        {
+            (c->prev ? c->prev->next : chunks_) = c->next;
+            (c->next ? c->next->prev : oldest_chunk_) = c->prev;
+            allocator_->free(c, chunk_bytes, u8(chunk_alignment));
+            ++num_freed;
+        }
+        c = next;
+    }
+    num_chunks_ -= num_freed;
+    rebuild_free_list();
+    return num_freed;
+}
+
 }
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "aliases.h"
+#include "memory_arena.h"
+
+// The adapters need the C++17 <memory_resource> header. They are left out of builds with
+// an older standard library.
+#if defined(__has_include)
+#if __has_include(<memory_resource>) && ((defined(_MSVC_LANG) && _MSVC_LANG >= 201703L) || __cplusplus >= 201703L)
+#define NLRS_HAS_MEMORY_RESOURCE
+#endif
+#endif
+
+#ifdef NLRS_HAS_MEMORY_RESOURCE
+
+#include <atomic>
+#include <memory_resource>
+
+namespace nlrs
+{
+
+// A std::pmr::memory_resource which allocates from a memory_arena, so that the standard
+// pmr containers and pooled resources can be layered over the arenas:
+//
+//  free_list_arena arena(memory, size);
+//  arena_memory_resource upstream(arena);
+//  std::pmr::unsynchronized_pool_resource pool(&upstream);
+//  std::pmr::vector<int> vec(&pool);
+//
+// Deallocation uses the sized free, since the standard resources always know the size.
+// Unlike the arenas, the resource throws std::bad_alloc when the arena returns nullptr,
+// as the memory_resource interface requires. The alignment can be at most 128 bytes.
+class arena_memory_resource : public std::pmr::memory_resource
+{
+public:
+    explicit arena_memory_resource(memory_arena& arena)
+        : arena_(arena)
+    {}
+    arena_memory_resource(const arena_memory_resource&) = default;
+    arena_memory_resource& operator=(const arena_memory_resource&) = delete;
+    ~arena_memory_resource() = default;
+
+    inline memory_arena& arena() const
+    {
+        return arena_;
+    }
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void  do_deallocate(void* ptr, std::size_t bytes, std::size_t alignment) override;
+    bool  do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+    memory_arena& arena_;
+};
+
+// A memory_arena which allocates from a std::pmr::memory_resource, so that the containers
+// in this library can use the standard resources, for instance a monotonic_buffer_resource.
+//
+// The memory_resource must be given the size of each block when it is deallocated, which
+// free(void*) doesn't know. Each block is therefore preceded by a header recording its size
+// and alignment. Reallocation keeps the block if the new size fits in it, and otherwise
+// moves it to a new block.
+//
+// The arena is as thread safe as the resource it wraps. Allocation failures are reported by
+// returning nullptr.
+class memory_resource_arena : public memory_arena
+{
+public:
+    explicit memory_resource_arena(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+    memory_resource_arena(const memory_resource_arena&) = delete;
+    memory_resource_arena(memory_resource_arena&&) = delete;
+    memory_resource_arena& operator=(const memory_resource_arena&) = delete;
+    memory_resource_arena& operator=(memory_resource_arena&&) = delete;
+    ~memory_resource_arena();
+
+    void* allocate(usize bytes, u8 alignment = 8u)  override;
+    void* reallocate(void* ptr, usize new_size)     override;
+    void  free(void* ptr)                           override;
+    using memory_arena::free;
+#ifdef NLRS_ARENA_STATS
+    arena_stats stats() const                       override;
+#endif
+
+    inline std::pmr::memory_resource* resource() const
+    {
+        return resource_;
+    }
+
+private:
+    struct block_header
+    {
+        usize bytes;
+        usize alignment;
+    };
+
+    // the offset of the returned pointer from the start of the block
+    inline static usize header_offset(usize alignment)
+    {
+        return alignment > sizeof(block_header) ? alignment : sizeof(block_header);
+    }
+
+    inline static block_header* header_of(void* ptr)
+    {
+        return reinterpret_cast<block_header*>(static_cast<u8*>(ptr) - sizeof(block_header));
+    }
+
+    std::pmr::memory_resource*  resource_;
+    std::atomic<usize>          alloc_count_;
+#ifdef NLRS_ARENA_STATS
+    concurrent_arena_stats_recorder stats_;
+#endif
+};
+
+}
+
+#endif
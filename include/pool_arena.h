@@ -0,0 +1,136 @@
+#pragma once
+
+#include "aliases.h"
+#include "memory_arena.h"
+#include "nlrs_assert.h"
+
+namespace nlrs
+{
+
+// A pool of equally sized chunks carved out of a fixed block of memory, for allocating
+// many objects of the same size, such as the nodes of a list or a map.
+//
+// Free chunks are kept in an intrusive singly linked list, so allocating and freeing a
+// chunk is a push or a pop, and the chunks carry no header. The chunks are carved from
+// the block lazily, so construction doesn't touch the memory.
+//
+// Like tlsf_arena, allocate returns nullptr when the pool is exhausted, and also for
+// requests larger than the chunk size, or aligned more strictly than the chunks.
+// Reallocation succeeds in place as long as the new size fits in the chunk, and returns
+// nullptr otherwise, leaving the chunk as it was.
+class pool_arena : public memory_arena
+{
+public:
+    // The chunk size is rounded up to a multiple of the alignment, and to at least the
+    // size of a pointer.
+    pool_arena(void* memory, usize num_bytes, usize chunk_size, u8 chunk_alignment = 8u);
+    pool_arena() = delete;
+    pool_arena(const pool_arena&) = delete;
+    pool_arena(pool_arena&&) = delete;
+    pool_arena& operator=(const pool_arena&) = delete;
+    pool_arena& operator=(pool_arena&&) = delete;
+    ~pool_arena();
+
+    void* allocate(usize bytes, u8 alignment = 8u)  override;
+    void* reallocate(void* ptr, usize new_size)     override;
+    void  free(void* ptr)                           override;
+    // The chunk is found from the pointer alone, so this is the same as free(ptr).
+    void  free(void* ptr, usize bytes, u8 alignment = 8u) override;
+#ifdef NLRS_ARENA_STATS
+    arena_stats stats() const                       override;
+#endif
+
+    inline usize chunk_size() const
+    {
+        return chunk_size_;
+    }
+
+    // The total number of chunks in the pool
+    inline usize capacity() const
+    {
+        return usize(end_ - begin_) / chunk_size_;
+    }
+
+    inline usize num_allocations() const
+    {
+        return alloc_count_;
+    }
+
+    // Returns true if the pointer lies within the pool's chunks.
+    inline bool owns(const void* ptr) const
+    {
+        const u8* p = static_cast<const u8*>(ptr);
+        return p >= begin_ && p < end_;
+    }
+
+private:
+    struct free_chunk
+    {
+        free_chunk* next;
+    };
+
+    u8*         begin_;
+    // the first chunk which hasn't been handed out yet
+    u8*         top_;
+    u8*         end_;
+    usize       chunk_size_;
+    u8          chunk_alignment_;
+    free_chunk* head_;
+    usize       alloc_count_;
+#ifdef NLRS_ARENA_STATS
+    arena_stats_recorder stats_;
+#endif
+};
+
+// These are a couple of instructions each, so they are defined here to allow inlining
+inline void* pool_arena::allocate(usize bytes, u8 alignment)
+{
+    if (bytes == 0u || bytes > chunk_size_ || alignment > chunk_alignment_)
+    {
+        return nullptr;
+    }
+
+    void* ptr = head_;
+    if (head_)
+    {
+        head_ = head_->next;
+    }
+    else if (top_ != end_)
+    {
+        ptr = top_;
+        top_ += chunk_size_;
+    }
+    else
+    {
+        return nullptr;
+    }
+
+    ++alloc_count_;
+    NLRS_ARENA_STATS_RECORD(stats_.on_allocate(bytes, chunk_size_));
+    NLRS_ARENA_STATS_RECORD(stats_.on_high_water(usize(top_ - begin_)));
+    return ptr;
+}
+
+inline void pool_arena::free(void* ptr)
+{
+    if (!ptr)
+    {
+        return;
+    }
+
+    NLRS_ASSERT(owns(ptr) && static_cast<u8*>(ptr) < top_);
+    NLRS_ASSERT(usize(static_cast<u8*>(ptr) - begin_) % chunk_size_ == 0u);
+    NLRS_ASSERT(alloc_count_ > 0u);
+    free_chunk* chunk = static_cast<free_chunk*>(ptr);
+    chunk->next = head_;
+    head_ = chunk;
+    --alloc_count_;
+    NLRS_ARENA_STATS_RECORD(stats_.on_free(chunk_size_));
+}
+
+inline void pool_arena::free(void* ptr, usize, u8)
+{
+    pool_arena::free(ptr);
+}
+
+}
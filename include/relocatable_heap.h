@@ -0,0 +1,212 @@
+#pragma once
+
+#include "aliases.h"
+#include "nlrs_assert.h"
+
+namespace nlrs
+{
+
+// A heap over a fixed block of memory whose allocations are reached through handles
+// instead of pointers, so that the heap is free to move them. Calling defragment slides
+// the live blocks towards the start of the memory, closing the holes left by freed blocks,
+// and does so incrementally: each call moves about a given number of bytes, so that a
+// long-running session can compact its heap a little every frame.
+//
+// A pointer obtained from get is only valid until the next call to defragment. A block
+// which must stay in place for longer, for instance while another thread reads it, can be
+// pinned. Pinned blocks are never moved, and defragment compacts around them.
+//
+// The handles are kept in a table of at most max_handles entries at the start of the
+// memory. A handle carries a generation, so using a handle after its block has been freed
+// is caught by an assertion instead of reaching another allocation.
+//
+// Like tlsf_arena, allocate returns an invalid handle when there is no free block large
+// enough, in which case defragmenting the heap may make room.
+class relocatable_heap
+{
+public:
+    struct handle
+    {
+        u32 index;
+        // odd for a live block, and zero for the invalid handle
+        u32 generation;
+
+        explicit operator bool() const
+        {
+            return generation != 0u;
+        }
+
+        bool operator==(handle rhs) const
+        {
+            return index == rhs.index && generation == rhs.generation;
+        }
+
+        bool operator!=(handle rhs) const
+        {
+            return !(*this == rhs);
+        }
+    };
+
+    // Keeps a block pinned for the lifetime of the scope.
+    class scoped_pin
+    {
+    public:
+        scoped_pin(relocatable_heap& heap, handle h)
+            : heap_(heap),
+            handle_(h),
+            ptr_(heap.pin(h))
+        {}
+        ~scoped_pin()
+        {
+            heap_.unpin(handle_);
+        }
+
+        scoped_pin(const scoped_pin&) = delete;
+        scoped_pin& operator=(const scoped_pin&) = delete;
+
+        void* get() const
+        {
+            return ptr_;
+        }
+
+    private:
+        relocatable_heap&   heap_;
+        handle              handle_;
+        void*               ptr_;
+    };
+
+    const static handle invalid_handle;
+
+    relocatable_heap(void* memory, usize num_bytes, u32 max_handles);
+    relocatable_heap() = delete;
+    relocatable_heap(const relocatable_heap&) = delete;
+    relocatable_heap(relocatable_heap&&) = delete;
+    relocatable_heap& operator=(const relocatable_heap&) = delete;
+    relocatable_heap& operator=(relocatable_heap&&) = delete;
+    ~relocatable_heap();
+
+    // Blocks are aligned to 16 bytes.
+    handle allocate(usize bytes);
+    void free(handle h);
+
+    bool is_valid(handle h) const;
+
+    // The current address of the block, which is invalidated by defragment unless the block
+    // is pinned.
+    inline void* get(handle h) const
+    {
+        return memory_ + entry(h).offset + sizeof(block_header);
+    }
+
+    // The usable size of the block, which is at least the requested size
+    usize size(handle h) const;
+
+    // Pins can nest, and the block stays in place until each pin has been undone.
+    void* pin(handle h);
+    void unpin(handle h);
+    bool is_pinned(handle h) const;
+
+    // Moves live blocks towards the start of the memory, merging the free space between
+    // them, until the next block would take the bytes moved past budget_bytes. The first
+    // block is moved regardless, so that every call makes progress. Each call carries on
+    // where the previous one stopped, without scanning the blocks held back by a pinned block
+    // again. Returns the number of bytes moved, which is zero once the heap is as compact as
+    // the pinned blocks allow.
+    usize defragment(usize budget_bytes);
+
+    inline usize num_allocations() const
+    {
+        return alloc_count_;
+    }
+
+    // The number of bytes available to blocks, excluding the handle table.
+    inline usize capacity() const
+    {
+        return size_;
+    }
+
+    // The number of bytes not in live blocks, including the headers of the free blocks.
+    inline usize free_bytes() const
+    {
+        return size_ - used_bytes_;
+    }
+
+    // The largest block which could currently be allocated
+    usize largest_free_block() const;
+
+private:
+    struct block_header
+    {
+        // the size of the block, including the header
+        usize   size;
+        // the index of the block's handle, or free_index if the block is free
+        u32     handle_index;
+        u32     flags;
+    };
+
+    // A free block also stores its size in its last bytes, so that the block after it can
+    // find its start and merge with it.
+    struct free_block
+    {
+        block_header    header;
+        free_block*     prev;
+        free_block*     next;
+    };
+
+    struct handle_entry
+    {
+        // the offset of the block, or the index of the next free entry
+        usize   offset;
+        u32     generation;
+        u32     pin_count;
+    };
+
+    const static u32 free_index;
+    const static u32 prev_free_flag;
+    const static usize block_alignment;
+    const static usize min_block_size;
+    const static usize num_size_classes{ 64u };
+
+    inline block_header* header_at(usize offset) const
+    {
+        return reinterpret_cast<block_header*>(memory_ + offset);
+    }
+
+    inline const handle_entry& entry(handle h) const
+    {
+        NLRS_ASSERT(is_valid(h));
+        return handles_[h.index];
+    }
+
+    inline handle_entry& entry(handle h)
+    {
+        NLRS_ASSERT(is_valid(h));
+        return handles_[h.index];
+    }
+
+    // Compacts the blocks from the cursor, which is a block boundary, up, for defragment.
+    usize compact_from(usize cursor, usize budget_bytes);
+    // Makes the memory a free block, and marks the block after it.
+    void insert_free_block(usize offset, usize size);
+    void remove_free_block(usize offset);
+    void set_prev_free(usize offset, bool prev_free);
+
+    handle_entry*   handles_;
+    u32             max_handles_;
+    u32             free_handle_;
+    u8*             memory_;
+    usize           size_;
+    // the end of the last block; the memory past it is free, but not in the free lists
+    usize           top_;
+    // every block below this offset is live
+    usize           compacted_;
+    // where the last call to defragment stopped, past the blocks it couldn't compact
+    usize           resume_;
+    // the free blocks by size class, the floor of the log2 of their size
+    u64             free_classes_;
+    free_block*     free_lists_[num_size_classes];
+    usize           used_bytes_;
+    usize           alloc_count_;
+};
+
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "aliases.h"
+#include "memory_arena.h"
+
+#include <atomic>
+#include <mutex>
+
+namespace nlrs
+{
+
+// A thread-safe arena which splits a fixed block of memory into shards, each of which is a
+// free_list_arena of its own. Threads allocate from their home shard, so threads on
+// different shards never contend for the same lock or cache lines.
+//
+// A block freed by a thread other than the one whose shard it came from is pushed onto a
+// lock-free queue owned by the block's shard, without taking any lock. The shard's own
+// thread drains the queue in a single batch the next time it allocates, so a job which
+// allocates a result for the main thread to free doesn't make the two threads contend.
+// Blocks waiting in a queue still count as allocated.
+//
+// Threads are assigned shards round-robin in the order they first use any sharded_arena.
+// If there are more threads than shards, threads share a shard, and the shard's lock keeps
+// them correct. When a shard runs out of memory, allocate returns nullptr, like
+// free_list_arena.
+class sharded_arena final : public memory_arena
+{
+public:
+    const static usize max_shards{ 64u };
+
+    // The memory holds the shards' bookkeeping, and is split evenly between them.
+    sharded_arena(void* memory, usize num_bytes, usize num_shards);
+    sharded_arena() = delete;
+    sharded_arena(const sharded_arena&) = delete;
+    sharded_arena(sharded_arena&&) = delete;
+    sharded_arena& operator=(const sharded_arena&) = delete;
+    sharded_arena& operator=(sharded_arena&&) = delete;
+    // All blocks must have been freed, but may still be waiting in the remote queues
+    ~sharded_arena();
+
+    void* allocate(usize bytes, u8 alignment = 8u)  override;
+    void* reallocate(void* ptr, usize new_size)     override;
+    void  free(void* ptr)                           override;
+    using memory_arena::free;
+#ifdef NLRS_ARENA_STATS
+    // The sum of the shards' stats. The peak and the high water mark are the sums of the
+    // shards' peaks, which is an upper bound of the arena's actual peak.
+    arena_stats stats() const                       override;
+#endif
+
+    inline usize num_shards() const
+    {
+        return num_shards_;
+    }
+
+    // The shard which the calling thread allocates from
+    usize home_shard() const;
+
+    // The shard the block was allocated from
+    usize shard_of(const void* ptr) const;
+
+    // Frees the blocks waiting in every shard's remote queue.
+    void drain_remote_frees();
+
+private:
+    struct remote_block
+    {
+        remote_block* next;
+    };
+
+    // Each shard is on its own cache lines, so that the shards don't false-share.
+    struct alignas(64) shard
+    {
+        shard(void* memory, usize num_bytes);
+
+        std::mutex                  mutex;
+        free_list_arena             arena;
+        // blocks freed by threads of other shards, pushed without taking the lock
+        std::atomic<remote_block*>  remote_frees;
+    };
+
+    // the shard's lock must be held
+    void drain(shard& s);
+    void push_remote(shard& s, void* ptr);
+
+    shard*  shards_;
+    usize   num_shards_;
+    u8*     memory_;
+    // the number of bytes of memory in each shard
+    usize   shard_bytes_;
+};
+
+}
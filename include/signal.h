@@ -64,7 +64,7 @@ public:
     }
 
 private:
-    std::pmr::unordered_map<handle, std::function<void(Args...)>> slots_;
+    pmr::unordered_map<handle, std::function<void(Args...)>> slots_;
     u32 current_id_;
 };
 
@@ -122,7 +122,7 @@ public:
     }
 
 private:
-    std::pmr::unordered_map<handle, std::function<void(void)>> slots_;
+    pmr::unordered_map<handle, std::function<void(void)>> slots_;
     u32 current_id_;
 };
 
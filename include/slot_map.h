@@ -0,0 +1,413 @@
+#pragma once
+
+#include "aliases.h"
+#include "memory_arena.h"
+#include "nlrs_assert.h"
+
+#include <new>
+#include <utility>
+
+namespace nlrs
+{
+
+// A container which hands out handles to its objects instead of pointers, and keeps the
+// objects densely packed, so that iterating over all of them is a walk over a contiguous
+// array.
+//
+// A handle is a 32-bit slot index and a 32-bit generation. The slot holds the position of
+// the object in the dense array, and the generation is bumped each time the slot's object
+// is erased, so a stale handle is detected instead of reaching whatever object took its
+// slot. insert, erase and lookup are O(1); erase moves the last object into the hole.
+//
+// Objects move when other objects are erased and when the container grows, so pointers to
+// them are only valid until the next insert or erase. Objects whose move constructor may
+// throw, or is deleted, are copied instead.
+template<typename T>
+class slot_map
+{
+public:
+    struct handle
+    {
+        u32 index;
+        // odd for a live object, and zero for the invalid handle
+        u32 generation;
+
+        explicit operator bool() const
+        {
+            return generation != 0u;
+        }
+
+        bool operator==(handle rhs) const
+        {
+            return index == rhs.index && generation == rhs.generation;
+        }
+
+        bool operator!=(handle rhs) const
+        {
+            return !(*this == rhs);
+        }
+
+        // The handle as a single integer, which is zero for the invalid handle
+        u64 value() const
+        {
+            return (u64(generation) << 32u) | u64(index);
+        }
+
+        static handle from_value(u64 value)
+        {
+            return handle{ u32(value), u32(value >> 32u) };
+        }
+    };
+
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    slot_map(memory_arena& allocator, usize capacity = 8u);
+    slot_map(slot_map&&);
+    slot_map& operator=(slot_map&&);
+    ~slot_map();
+
+    slot_map() = delete;
+    slot_map(const slot_map&) = delete;
+    slot_map& operator=(const slot_map&) = delete;
+
+    // Returns the invalid handle if the storage can't grow.
+    template<typename... Args>
+    handle emplace(Args&&... args);
+    handle insert(const T& object);
+    handle insert(T&& object);
+    // Erasing a stale handle does nothing, so an object can't be released twice.
+    void erase(handle h);
+    void clear();
+
+    bool contains(handle h) const;
+
+    // Returns nullptr for a stale or invalid handle.
+    T* get(handle h);
+    const T* get(handle h) const;
+
+    // The handle must be valid.
+    T& operator[](handle h);
+    const T& operator[](handle h) const;
+
+    // The handle of the object at a position of the dense array
+    handle handle_at(usize dense_index) const;
+
+    // Returns false, leaving the map as it was, if the allocator runs out of memory.
+    bool reserve(usize new_capacity);
+
+    usize size() const { return size_; }
+    bool empty() const { return size_ == 0u; }
+    usize capacity() const { return capacity_; }
+
+    T* data() { return objects_; }
+    const T* data() const { return objects_; }
+
+    iterator begin() { return objects_; }
+    iterator end() { return objects_ + size_; }
+    const_iterator begin() const { return objects_; }
+    const_iterator end() const { return objects_ + size_; }
+    const_iterator cbegin() const { return objects_; }
+    const_iterator cend() const { return objects_ + size_; }
+
+private:
+    struct slot
+    {
+        // the position of the object, or the index of the next free slot
+        u32 index;
+        u32 generation;
+    };
+
+    const static u32 no_slot = 0xffffffffu;
+
+    void release_storage();
+    u32 acquire_slot();
+    handle place(u32 index);
+
+    memory_arena*   allocator_;
+    T*              objects_;
+    // the slot of each object in the dense array
+    u32*            object_slots_;
+    slot*           slots_;
+    usize           size_;
+    usize           capacity_;
+    // the number of slots which have ever been used; the free ones are in a list
+    usize           num_slots_;
+    u32             free_slot_;
+};
+
+template<typename T>
+slot_map<T>::slot_map(memory_arena& allocator, usize capacity)
+    : allocator_(&allocator),
+    objects_(nullptr),
+    object_slots_(nullptr),
+    slots_(nullptr),
+    size_(0u),
+    capacity_(0u),
+    num_slots_(0u),
+    free_slot_(no_slot)
+{
+    reserve(capacity);
+}
+
+template<typename T>
+slot_map<T>::slot_map(slot_map&& other)
+    : allocator_(other.allocator_),
+    objects_(other.objects_),
+    object_slots_(other.object_slots_),
+    slots_(other.slots_),
+    size_(other.size_),
+    capacity_(other.capacity_),
+    num_slots_(other.num_slots_),
+    free_slot_(other.free_slot_)
+{
+    other.objects_ = nullptr;
+    other.object_slots_ = nullptr;
+    other.slots_ = nullptr;
+    other.size_ = 0u;
+    other.capacity_ = 0u;
+    other.num_slots_ = 0u;
+    other.free_slot_ = no_slot;
+}
+
+template<typename T>
+slot_map<T>& slot_map<T>::operator=(slot_map<T>&& rhs)
+{
+    clear();
+    release_storage();
+
+    allocator_ = rhs.allocator_;
+    objects_ = rhs.objects_;
+    object_slots_ = rhs.object_slots_;
+    slots_ = rhs.slots_;
+    size_ = rhs.size_;
+    capacity_ = rhs.capacity_;
+    num_slots_ = rhs.num_slots_;
+    free_slot_ = rhs.free_slot_;
+
+    rhs.objects_ = nullptr;
+    rhs.object_slots_ = nullptr;
+    rhs.slots_ = nullptr;
+    rhs.size_ = 0u;
+    rhs.capacity_ = 0u;
+    rhs.num_slots_ = 0u;
+    rhs.free_slot_ = no_slot;
+
+    return *this;
+}
+
+template<typename T>
+slot_map<T>::~slot_map()
+{
+    clear();
+    release_storage();
+}
+
+template<typename T>
+void slot_map<T>::release_storage()
+{
+    if (objects_)
+    {
+        allocator_->free(objects_, capacity_ * sizeof(T), u8(alignof(T)));
+        allocator_->free(object_slots_, capacity_ * sizeof(u32), u8(alignof(u32)));
+        allocator_->free(slots_, capacity_ * sizeof(slot), u8(alignof(slot)));
+    }
+    objects_ = nullptr;
+    object_slots_ = nullptr;
+    slots_ = nullptr;
+    capacity_ = 0u;
+}
+
+template<typename T>
+bool slot_map<T>::reserve(usize new_capacity)
+{
+    if (new_capacity <= capacity_)
+    {
+        return true;
+    }
+    NLRS_ASSERT(new_capacity < no_slot);
+
+    T* objects = static_cast<T*>(allocator_->allocate(new_capacity * sizeof(T), u8(alignof(T))));
+    u32* object_slots = static_cast<u32*>(allocator_->allocate(new_capacity * sizeof(u32), u8(alignof(u32))));
+    slot* slots = static_cast<slot*>(allocator_->allocate(new_capacity * sizeof(slot), u8(alignof(slot))));
+    if (!objects || !object_slots || !slots)
+    {
+        if (objects)
+        {
+            allocator_->free(objects, new_capacity * sizeof(T), u8(alignof(T)));
+        }
+        if (object_slots)
+        {
+            allocator_->free(object_slots, new_capacity * sizeof(u32), u8(alignof(u32)));
+        }
+        if (slots)
+        {
+            allocator_->free(slots, new_capacity * sizeof(slot), u8(alignof(slot)));
+        }
+        return false;
+    }
+
+    for (usize i = 0u; i < size_; ++i)
+    {
+        new (objects + i) T(std::move_if_noexcept(objects_[i]));
+        objects_[i].~T();
+        object_slots[i] = object_slots_[i];
+    }
+    for (usize i = 0u; i < num_slots_; ++i)
+    {
+        slots[i] = slots_[i];
+    }
+
+    release_storage();
+    objects_ = objects;
+    object_slots_ = object_slots;
+    slots_ = slots;
+    capacity_ = new_capacity;
+    return true;
+}
+
+template<typename T>
+template<typename... Args>
+typename slot_map<T>::handle slot_map<T>::emplace(Args&&... args)
+{
+    if (size_ == capacity_)
+    {
+        // the arguments may refer to an object, so the new object is made before growing
+        T object{ std::forward<Args>(args)... };
+        if (!reserve(capacity_ == 0u ? 8u : 2u * capacity_))
+        {
+            return handle{ 0u, 0u };
+        }
+        u32 index = acquire_slot();
+        new (objects_ + size_) T(std::move_if_noexcept(object));
+        return place(index);
+    }
+
+    u32 index = acquire_slot();
+    new (objects_ + size_) T{ std::forward<Args>(args)... };
+    return place(index);
+}
+
+template<typename T>
+u32 slot_map<T>::acquire_slot()
+{
+    u32 index = free_slot_;
+    if (index == no_slot)
+    {
+        index = u32(num_slots_++);
+        slots_[index].generation = 0u;
+    }
+    else
+    {
+        free_slot_ = slots_[index].index;
+    }
+    return index;
+}
+
+// Links the object just constructed at the end of the dense array to the slot.
+template<typename T>
+typename slot_map<T>::handle slot_map<T>::place(u32 index)
+{
+    object_slots_[size_] = index;
+    slot& s = slots_[index];
+    s.index = u32(size_);
+    ++s.generation;
+    ++size_;
+
+    return handle{ index, s.generation };
+}
+
+template<typename T>
+typename slot_map<T>::handle slot_map<T>::insert(const T& object)
+{
+    return emplace(object);
+}
+
+template<typename T>
+typename slot_map<T>::handle slot_map<T>::insert(T&& object)
+{
+    return emplace(std::move(object));
+}
+
+template<typename T>
+void slot_map<T>::erase(handle h)
+{
+    if (!contains(h))
+    {
+        return;
+    }
+    slot& s = slots_[h.index];
+    usize position = s.index;
+    usize last = size_ - 1u;
+
+    // fill the hole with the last object, to keep the objects dense
+    objects_[position].~T();
+    if (position != last)
+    {
+        new (objects_ + position) T(std::move_if_noexcept(objects_[last]));
+        objects_[last].~T();
+        object_slots_[position] = object_slots_[last];
+        slots_[object_slots_[position]].index = u32(position);
+    }
+    --size_;
+
+    ++s.generation;
+    s.index = free_slot_;
+    free_slot_ = h.index;
+}
+
+template<typename T>
+void slot_map<T>::clear()
+{
+    for (usize i = 0u; i < size_; ++i)
+    {
+        objects_[i].~T();
+        slot& s = slots_[object_slots_[i]];
+        ++s.generation;
+        s.index = free_slot_;
+        free_slot_ = object_slots_[i];
+    }
+    size_ = 0u;
+}
+
+template<typename T>
+bool slot_map<T>::contains(handle h) const
+{
+    return (h.generation & 1u) && h.index < num_slots_ && slots_[h.index].generation == h.generation;
+}
+
+template<typename T>
+T* slot_map<T>::get(handle h)
+{
+    return contains(h) ? objects_ + slots_[h.index].index : nullptr;
+}
+
+template<typename T>
+const T* slot_map<T>::get(handle h) const
+{
+    return contains(h) ? objects_ + slots_[h.index].index : nullptr;
+}
+
+template<typename T>
+T& slot_map<T>::operator[](handle h)
+{
+    NLRS_ASSERT(contains(h));
+    return objects_[slots_[h.index].index];
+}
+
+template<typename T>
+const T& slot_map<T>::operator[](handle h) const
+{
+    NLRS_ASSERT(contains(h));
+    return objects_[slots_[h.index].index];
+}
+
+template<typename T>
+typename slot_map<T>::handle slot_map<T>::handle_at(usize dense_index) const
+{
+    NLRS_ASSERT(dense_index < size_);
+    u32 index = object_slots_[dense_index];
+    return handle{ index, slots_[index].generation };
+}
+
+}
@@ -0,0 +1,314 @@
+#pragma once
+
+#include "aliases.h"
+#include "array.h"
+#include "memory_arena.h"
+#include "nlrs_assert.h"
+
+#include <cstring>
+#include <initializer_list>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace nlrs
+{
+
+// A dynamic array which stores up to N elements inline, and only allocates from its
+// memory_arena when it grows past that. Like resizable_array, it is meant for the many small
+// lists which usually stay short, but it is still correct when one of them doesn't.
+//
+// Once the elements have spilled to the arena they stay there, until the array is destroyed,
+// so that an array which oscillates around N doesn't allocate over and over. Past N, the
+// capacity doubles when the array runs out of room, and trivially relocatable elements are
+// moved by reallocation, like in array.
+//
+// The array points to its own inline storage, so it is never trivially relocatable itself.
+template<typename T, usize N>
+class small_array
+{
+public:
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    small_array();
+    explicit small_array(memory_arena& allocator);
+    small_array(std::initializer_list<T> list, memory_arena& allocator = system_arena::get_instance());
+    small_array(const small_array&);
+    small_array(small_array&&) noexcept(std::is_nothrow_move_constructible<T>::value);
+    small_array& operator=(const small_array&);
+    small_array& operator=(small_array&&) noexcept(std::is_nothrow_move_constructible<T>::value);
+    ~small_array();
+
+    T&          at(usize index);
+    const T&    at(usize index) const;
+    T&          operator[](usize index);
+    const T&    operator[](usize index) const;
+    T&          back() { return at(size_ - 1u); }
+    const T&    back() const { return at(size_ - 1u); }
+
+    T* data() { return data_; }
+    const T* data() const { return data_; }
+
+    iterator begin() { return data_; }
+    iterator end() { return data_ + size_; }
+    const_iterator begin() const { return data_; }
+    const_iterator end() const { return data_ + size_; }
+    const_iterator cbegin() const { return data_; }
+    const_iterator cend() const { return data_ + size_; }
+
+    // These return the index of the new element, like resizable_array.
+    usize push_back(const T& value);
+    usize push_back(T&& value);
+    template<typename... Args>
+    usize emplace_back(Args&&... args);
+    void pop_back();
+
+    void reserve(usize new_capacity);
+    void clear();
+
+    usize size() const { return size_; }
+    usize capacity() const { return capacity_; }
+    bool empty() const { return size_ == 0u; }
+    // Whether the elements are still in the inline storage.
+    bool is_inline() const { return capacity_ == N; }
+    memory_arena& allocator() const { return *allocator_; }
+
+private:
+    static_assert(N > 0u, "a small_array must have room for at least one element");
+
+    T* inline_data() { return reinterpret_cast<T*>(&inline_[0]); }
+
+    void relocate(usize new_capacity);
+    // Takes other's elements, leaving it empty. This array must be empty and inline.
+    void take(small_array& other);
+    void release_heap();
+
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type inline_[N];
+    T*              data_;
+    usize           size_;
+    usize           capacity_;
+    memory_arena*   allocator_;
+};
+
+template<typename T, usize N>
+small_array<T, N>::small_array()
+    : small_array(system_arena::get_instance())
+{}
+
+template<typename T, usize N>
+small_array<T, N>::small_array(memory_arena& allocator)
+    : data_(inline_data()),
+    size_(0u),
+    capacity_(N),
+    allocator_(&allocator)
+{}
+
+template<typename T, usize N>
+small_array<T, N>::small_array(std::initializer_list<T> list, memory_arena& allocator)
+    : small_array(allocator)
+{
+    reserve(list.size());
+    for (const T& elem : list)
+    {
+        push_back(elem);
+    }
+}
+
+template<typename T, usize N>
+small_array<T, N>::small_array(const small_array& other)
+    : small_array(*other.allocator_)
+{
+    reserve(other.size_);
+    for (const T& elem : other)
+    {
+        push_back(elem);
+    }
+}
+
+template<typename T, usize N>
+small_array<T, N>::small_array(small_array&& other) noexcept(std::is_nothrow_move_constructible<T>::value)
+    : small_array(*other.allocator_)
+{
+    take(other);
+}
+
+template<typename T, usize N>
+small_array<T, N>& small_array<T, N>::operator=(const small_array& rhs)
+{
+    if (this != &rhs)
+    {
+        clear();
+        reserve(rhs.size_);
+        for (const T& elem : rhs)
+        {
+            push_back(elem);
+        }
+    }
+    return *this;
+}
+
+template<typename T, usize N>
+small_array<T, N>& small_array<T, N>::operator=(small_array&& rhs) noexcept(std::is_nothrow_move_constructible<T>::value)
+{
+    if (this != &rhs)
+    {
+        clear();
+        release_heap();
+        allocator_ = rhs.allocator_;
+        take(rhs);
+    }
+    return *this;
+}
+
+template<typename T, usize N>
+small_array<T, N>::~small_array()
+{
+    clear();
+    release_heap();
+}
+
+template<typename T, usize N>
+void small_array<T, N>::take(small_array& other)
+{
+    if (other.is_inline())
+    {
+        for (usize i = 0u; i < other.size_; ++i)
+        {
+            new (data_ + i) T(std::move(other.data_[i]));
+        }
+        size_ = other.size_;
+        other.clear();
+        return;
+    }
+    data_ = other.data_;
+    size_ = other.size_;
+    capacity_ = other.capacity_;
+    other.data_ = other.inline_data();
+    other.size_ = 0u;
+    other.capacity_ = N;
+}
+
+template<typename T, usize N>
+void small_array<T, N>::release_heap()
+{
+    if (!is_inline())
+    {
+        allocator_->free(data_, capacity_ * sizeof(T), u8(alignof(T)));
+        data_ = inline_data();
+        capacity_ = N;
+    }
+}
+
+template<typename T, usize N>
+T& small_array<T, N>::at(usize index)
+{
+    NLRS_ASSERT(index < size_);
+    return data_[index];
+}
+
+template<typename T, usize N>
+const T& small_array<T, N>::at(usize index) const
+{
+    NLRS_ASSERT(index < size_);
+    return data_[index];
+}
+
+template<typename T, usize N>
+T& small_array<T, N>::operator[](usize index)
+{
+    return at(index);
+}
+
+template<typename T, usize N>
+const T& small_array<T, N>::operator[](usize index) const
+{
+    return at(index);
+}
+
+template<typename T, usize N>
+void small_array<T, N>::relocate(usize new_capacity)
+{
+    T* data = nullptr;
+    if (is_trivially_relocatable<T>::value && !is_inline())
+    {
+        data = static_cast<T*>(allocator_->reallocate(data_, new_capacity * sizeof(T)));
+        NLRS_ASSERT(data);
+    }
+    else
+    {
+        data = static_cast<T*>(allocator_->allocate(new_capacity * sizeof(T), u8(alignof(T))));
+        NLRS_ASSERT(data);
+        if (is_trivially_relocatable<T>::value)
+        {
+            std::memcpy(static_cast<void*>(data), static_cast<const void*>(data_), size_ * sizeof(T));
+        }
+        else
+        {
+            for (usize i = 0u; i < size_; ++i)
+            {
+                new (data + i) T(std::move_if_noexcept(data_[i]));
+                data_[i].~T();
+            }
+        }
+        release_heap();
+    }
+    data_ = data;
+    capacity_ = new_capacity;
+}
+
+template<typename T, usize N>
+void small_array<T, N>::reserve(usize new_capacity)
+{
+    if (new_capacity > capacity_)
+    {
+        relocate(new_capacity);
+    }
+}
+
+template<typename T, usize N>
+template<typename... Args>
+usize small_array<T, N>::emplace_back(Args&&... args)
+{
+    if (size_ == capacity_)
+    {
+        // the arguments may refer to an element, so the new element is made before growing
+        T value{ std::forward<Args>(args)... };
+        relocate(2u * capacity_);
+        new (data_ + size_) T(std::move(value));
+        return size_++;
+    }
+    new (data_ + size_) T{ std::forward<Args>(args)... };
+    return size_++;
+}
+
+template<typename T, usize N>
+usize small_array<T, N>::push_back(const T& value)
+{
+    return emplace_back(value);
+}
+
+template<typename T, usize N>
+usize small_array<T, N>::push_back(T&& value)
+{
+    return emplace_back(std::move(value));
+}
+
+template<typename T, usize N>
+void small_array<T, N>::pop_back()
+{
+    NLRS_ASSERT(size_ > 0u);
+    data_[--size_].~T();
+}
+
+template<typename T, usize N>
+void small_array<T, N>::clear()
+{
+    for (usize i = 0u; i < size_; ++i)
+    {
+        data_[i].~T();
+    }
+    size_ = 0u;
+}
+
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "aliases.h"
+#include "memory_arena.h"
+
+namespace nlrs
+{
+
+// Segregated pools for small objects, such as the nodes of node-based containers, with
+// requests larger than max_class_size passed on to a backing arena.
+//
+// Small requests are rounded up to a multiple of their alignment, and of 8 bytes, and
+// served from the size class of exactly that size. Each size class carves chunks out of
+// slabs, which are allocated from the backing arena as needed, and keeps its free chunks
+// in an intrusive list. The chunks carry no header: the sized free finds the size class
+// from the size alone. free(void*) and reallocate have to search the slabs for the one
+// containing the pointer, which takes time linear in the number of slabs, so prefer the
+// sized free, which the allocators in this library use.
+//
+// The alignment isn't known on reallocation, which moves blocks between size classes
+// assuming the default alignment of 8 bytes. Blocks allocated with a larger alignment
+// must not be reallocated.
+//
+// Slabs are only returned to the backing arena when the arena is destroyed. The arena
+// isn't thread-safe.
+class small_object_arena : public memory_arena
+{
+public:
+    const static usize class_granularity{ 8u };
+    const static usize max_class_size{ 256u };
+    const static usize num_size_classes{ max_class_size / class_granularity };
+    // A little under 64 KiB, leaving room for the backing arena's own block header and
+    // alignment padding, so that arenas which round blocks up to a power of two don't
+    // double the slab.
+    const static usize slab_size{ 64u * 1024u - 512u };
+
+    explicit small_object_arena(memory_arena& backing);
+    small_object_arena() = delete;
+    small_object_arena(const small_object_arena&) = delete;
+    small_object_arena(small_object_arena&&) = delete;
+    small_object_arena& operator=(const small_object_arena&) = delete;
+    small_object_arena& operator=(small_object_arena&&) = delete;
+    // Returns the slabs to the backing arena
+    ~small_object_arena();
+
+    void* allocate(usize bytes, u8 alignment = 8u)  override;
+    void* reallocate(void* ptr, usize new_size)     override;
+    void  free(void* ptr)                           override;
+    // Small blocks are returned to their size class without searching the slabs.
+    void  free(void* ptr, usize bytes, u8 alignment = 8u) override;
+#ifdef NLRS_ARENA_STATS
+    // Only the small blocks are counted. The slabs and the large blocks show up in the
+    // backing arena's stats. The free memory is that left in the slabs.
+    arena_stats stats() const                       override;
+#endif
+
+    inline usize num_allocations() const
+    {
+        return alloc_count_;
+    }
+
+    inline usize num_slabs() const
+    {
+        return num_slabs_;
+    }
+
+private:
+    struct free_chunk
+    {
+        free_chunk* next;
+    };
+
+    struct slab_header
+    {
+        slab_header*    next;
+        u32             size_class;
+    };
+
+    // Slabs are aligned to the largest alignment a memory_arena supports, so that a chunk
+    // whose size is a multiple of the alignment is itself aligned.
+    const static u8 slab_alignment{ 128u };
+    const static usize slab_header_size{ slab_alignment };
+
+    struct size_class
+    {
+        free_chunk* head;
+        // the part of the latest slab which hasn't been carved into chunks yet
+        u8*         top;
+        u8*         end;
+    };
+
+    inline static usize class_size(u32 size_class)
+    {
+        return (usize(size_class) + 1u) * class_granularity;
+    }
+
+    // the size of the chunk which serves the request
+    inline static usize rounded_size(usize bytes, u8 alignment)
+    {
+        usize granularity = alignment > class_granularity ? usize(alignment) : class_granularity;
+        return (bytes + granularity - 1u) & ~(granularity - 1u);
+    }
+
+    inline static bool is_small(usize bytes, u8 alignment)
+    {
+        return rounded_size(bytes, alignment) <= max_class_size;
+    }
+
+    inline static u32 size_class_of(usize bytes, u8 alignment)
+    {
+        return u32(rounded_size(bytes, alignment) / class_granularity) - 1u;
+    }
+
+    void* allocate_small(u32 size_class);
+    void  free_small(void* ptr, u32 size_class);
+    // Returns nullptr if the pointer isn't in any of the slabs
+    slab_header* find_slab(void* ptr) const;
+
+    memory_arena&   backing_;
+    size_class      classes_[num_size_classes];
+    slab_header*    slabs_;
+    usize           num_slabs_;
+    usize           alloc_count_;
+#ifdef NLRS_ARENA_STATS
+    arena_stats_recorder stats_;
+    // the bytes in the free lists and the uncarved parts of the slabs
+    usize           free_bytes_;
+#endif
+};
+
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "aliases.h"
+#include "memory_arena.h"
+
+namespace nlrs
+{
+
+// A double-ended stack allocator over a fixed block of memory. The bottom stack grows
+// upwards from the start of the block, and the top stack grows downwards from the end.
+// Typically long-lived data is allocated from one end, and short-lived data from the other.
+//
+// Each allocation is preceded by a small header, which stores the size of the allocation
+// and the previous top of its stack. Allocations must be freed in LIFO order within each
+// stack: only the most recent allocation of a stack can be freed or grown. Freeing or
+// growing anything else is an assertion failure.
+//
+// The most recent allocation of the bottom stack is resized in place on reallocate, so a
+// buffer<T> which is the last allocation grows without copying. The most recent allocation
+// of the top stack is moved downwards within the arena. Shrinking any other allocation
+// leaves it as it is, and in release builds growing one returns nullptr.
+//
+// The memory_arena interface allocates from the bottom stack. Use top() to get a
+// memory_arena which allocates from the top stack. Like linear_arena, allocate returns
+// nullptr when the two stacks would overlap, and so does reallocate, leaving the old
+// allocation as it was.
+class stack_arena : public memory_arena
+{
+public:
+    enum class end
+    {
+        bottom,
+        top
+    };
+
+    using marker = usize;
+
+    stack_arena(void* memory, usize num_bytes);
+    stack_arena() = delete;
+    stack_arena(const stack_arena&) = delete;
+    stack_arena(stack_arena&&) = delete;
+    stack_arena& operator=(const stack_arena&) = delete;
+    stack_arena& operator=(stack_arena&&) = delete;
+    ~stack_arena() = default;
+
+    void* allocate(usize bytes, u8 alignment = 8u)  override;
+    void* reallocate(void* ptr, usize new_size)     override;
+    // The pointer may belong to either stack.
+    void  free(void* ptr)                           override;
+    using memory_arena::free;
+#ifdef NLRS_ARENA_STATS
+    // The statistics cover both stacks.
+    arena_stats stats() const                       override;
+#endif
+
+    void* allocate(end e, usize bytes, u8 alignment = 8u);
+
+    // A memory_arena adapter which allocates from the top stack of this arena.
+    inline memory_arena& top()
+    {
+        return top_end_;
+    }
+
+    // Returns a marker to the current top of the given stack. Rewinding to the marker
+    // releases everything allocated from that stack after the marker was taken.
+    marker get_marker(end e) const;
+    void rewind(end e, marker m);
+
+    inline usize bytes_free() const
+    {
+        return top_ - bottom_;
+    }
+
+private:
+    struct header
+    {
+        // the offset of the top of the stack before this allocation was made
+        usize prev_offset;
+        usize size;
+    };
+
+    class top_end : public memory_arena
+    {
+    public:
+        explicit top_end(stack_arena& parent)
+            : parent_(parent)
+        {}
+
+        void* allocate(usize bytes, u8 alignment = 8u) override
+        {
+            return parent_.allocate(end::top, bytes, alignment);
+        }
+
+        void* reallocate(void* ptr, usize new_size) override
+        {
+            return parent_.reallocate(ptr, new_size);
+        }
+
+        void free(void* ptr) override
+        {
+            parent_.free(ptr);
+        }
+
+#ifdef NLRS_ARENA_STATS
+        arena_stats stats() const override
+        {
+            return parent_.stats();
+        }
+#endif
+
+    private:
+        stack_arena& parent_;
+    };
+
+    inline header* header_of(void* ptr) const
+    {
+        return static_cast<header*>(ptr) - 1u;
+    }
+
+    bool is_in_bottom_stack(void* ptr) const;
+    bool is_topmost(void* ptr) const;
+
+    inline usize bytes_used() const
+    {
+        return bottom_ + (size_ - top_);
+    }
+
+    u8*         arena_;
+    // bottom_ is the offset of the end of the bottom stack, top_ is the offset of the
+    // start of the top stack
+    usize       bottom_;
+    usize       top_;
+    const usize size_;
+    top_end     top_end_;
+#ifdef NLRS_ARENA_STATS
+    arena_stats_recorder stats_;
+#endif
+};
+
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "aliases.h"
+#include "memory_arena.h"
+
+#include <type_traits>
+
+namespace nlrs
+{
+
+// An allocator which is bound to a concrete arena type at compile time, for the hot
+// container loops where the virtual call made by polymorphic_allocator shows up.
+//
+// The arena's functions are called by their qualified names, so the calls are resolved
+// statically and can be inlined when the arena defines them in its header, as
+// linear_arena does. This means that overrides in classes further derived from Arena
+// are bypassed: the Arena type must be the actual type of the arena.
+//
+//  linear_arena frame_arena(memory, size);
+//  pmr::arena_vector<int, linear_arena> temp{ static_allocator<int, linear_arena>(frame_arena) };
+//
+// Containers using different arena types can't share memory, so use polymorphic_allocator
+// where that is needed.
+template<class T, class Arena>
+class static_allocator
+{
+public:
+    static_assert(std::is_base_of<memory_arena, Arena>::value, "Arena must be a memory_arena");
+
+    template<class U, class A> friend class static_allocator;
+    using value_type = T;
+    using arena_type = Arena;
+
+    using pointer = T*;
+    using const_pointer = const T*;
+
+    template<class U>
+    struct rebind
+    {
+        using other = static_allocator<U, Arena>;
+    };
+
+    using propagate_on_container_copy_assignment = std::false_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    explicit static_allocator(Arena& arena)
+        : arena_(&arena)
+    {}
+    static_allocator(const static_allocator&) = default;
+    static_allocator& operator=(const static_allocator&) = default;
+    static_allocator(static_allocator&&) = default;
+    static_allocator& operator=(static_allocator&&) = default;
+    ~static_allocator() = default;
+
+    template<class U>
+    static_allocator(const static_allocator<U, Arena>& other)
+        : arena_(other.arena_)
+    {}
+
+    inline T* allocate(usize n)
+    {
+        return static_cast<T*>(arena_->Arena::allocate(sizeof(T) * n, alignof(T)));
+    }
+
+    inline void deallocate(T* ptr, usize n)
+    {
+        arena_->Arena::free(ptr, sizeof(T) * n, alignof(T));
+    }
+
+    inline Arena& arena() const
+    {
+        return *arena_;
+    }
+
+    template<class U>
+    bool operator==(const static_allocator<U, Arena>& rhs) const
+    {
+        return arena_ == rhs.arena_;
+    }
+
+    template<class U>
+    bool operator!=(const static_allocator<U, Arena>& rhs) const
+    {
+        return arena_ != rhs.arena_;
+    }
+
+private:
+    Arena* arena_;
+};
+
+}
@@ -1,18 +1,27 @@
 #pragma once
 
 #include "../memory_arena.h"
+#include "../static_allocator.h"
 #include <string>
 
-namespace std
+namespace nlrs
 {
 namespace pmr
 {
 
 template <class CharT, class Traits = std::char_traits<CharT>>
-using basic_string = std::basic_string< CharT, Traits, nlrs::polymorphic_allocator<CharT>>;
+using basic_string = std::basic_string< CharT, Traits, polymorphic_allocator<CharT>>;
 
 using string = basic_string<char>;
 using wstring = basic_string<wchar_t>;
 
+template <class CharT, class Arena, class Traits = std::char_traits<CharT>>
+using arena_basic_string = std::basic_string<CharT, Traits, static_allocator<CharT, Arena>>;
+
+template<class Arena>
+using arena_string = arena_basic_string<char, Arena>;
+template<class Arena>
+using arena_wstring = arena_basic_string<wchar_t, Arena>;
+
 }
 }
@@ -1,15 +1,19 @@
 #pragma once
 
 #include "../memory_arena.h"
+#include "../static_allocator.h"
 #include <unordered_map>
 
-namespace std
+namespace nlrs
 {
 namespace pmr
 {
 
 template<class K, class V>
-using unordered_map = std::unordered_map<K, V, std::hash<K>, std::equal_to<K>, nlrs::polymorphic_allocator<std::pair<const K, V>>>;
+using unordered_map = std::unordered_map<K, V, std::hash<K>, std::equal_to<K>, polymorphic_allocator<std::pair<const K, V>>>;
+
+template<class K, class V, class Arena>
+using arena_unordered_map = std::unordered_map<K, V, std::hash<K>, std::equal_to<K>, static_allocator<std::pair<const K, V>, Arena>>;
 
 }
 }
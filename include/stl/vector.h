@@ -1,15 +1,19 @@
 #pragma once
 
 #include "../memory_arena.h"
+#include "../static_allocator.h"
 #include <vector>
 
-namespace std
+namespace nlrs
 {
 namespace pmr
 {
 
 template<class T>
-using vector = std::vector<T, nlrs::polymorphic_allocator<T>>;
+using vector = std::vector<T, polymorphic_allocator<T>>;
+
+template<class T, class Arena>
+using arena_vector = std::vector<T, static_allocator<T, Arena>>;
 
 }
 }
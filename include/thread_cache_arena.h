@@ -0,0 +1,85 @@
+#pragma once
+
+#include "aliases.h"
+#include "memory_arena.h"
+
+#include <mutex>
+
+namespace nlrs
+{
+
+namespace detail
+{
+struct thread_cache;
+struct thread_cache_list;
+}
+
+// A thread-safe front end for any memory_arena.
+//
+// Small allocations are rounded up to a power-of-two size class. Each thread keeps a
+// magazine of free blocks for every size class, so most allocations and frees only touch
+// thread-local data. When a magazine runs empty, it is refilled with a batch of blocks
+// from the backing arena, and when it overflows, a batch of blocks is flushed back. The
+// backing arena is only ever accessed while holding a single lock, so it doesn't need to
+// be thread-safe itself. Large and over-aligned allocations go directly to the backing arena.
+//
+// Blocks can be freed from any thread, not just the one which allocated them. Sized
+// frees find the size class without touching the block's header, so a block which is
+// reallocated to a size in a different class is always moved.
+//
+// The arena must outlive the threads which use it, or the threads have to call
+// flush_thread_cache() before the arena is destroyed. When a thread exits, its cached
+// blocks are returned to the backing arena.
+class thread_cache_arena final : public memory_arena
+{
+public:
+    const static usize min_class_size{ 16u };
+    const static usize num_size_classes{ 9u };
+    const static usize max_class_size{ min_class_size << (num_size_classes - 1u) };
+    const static usize magazine_size{ 64u };
+    const static usize batch_size{ magazine_size / 2u };
+
+    explicit thread_cache_arena(memory_arena& backing);
+    thread_cache_arena() = delete;
+    thread_cache_arena(const thread_cache_arena&) = delete;
+    thread_cache_arena(thread_cache_arena&&) = delete;
+    thread_cache_arena& operator=(const thread_cache_arena&) = delete;
+    thread_cache_arena& operator=(thread_cache_arena&&) = delete;
+    // Returns the cached blocks of every thread to the backing arena
+    ~thread_cache_arena();
+
+    void* allocate(usize bytes, u8 alignment = 8u)  override;
+    void* reallocate(void* ptr, usize new_size)     override;
+    void  free(void* ptr)                           override;
+    // Small blocks are returned to the cache without reading their header.
+    void  free(void* ptr, usize bytes, u8 alignment = 8u) override;
+#ifdef NLRS_ARENA_STATS
+    // Blocks sitting in the thread caches count as in use. The free memory is that of the
+    // backing arena.
+    arena_stats stats() const                       override;
+#endif
+
+    // Returns the calling thread's cached blocks to the backing arena.
+    void flush_thread_cache();
+
+private:
+    friend struct detail::thread_cache_list;
+
+    detail::thread_cache* get_thread_cache();
+    void refill(detail::thread_cache& cache, u32 size_class);
+    void flush(detail::thread_cache& cache, u32 size_class, usize count);
+    // Returns a small block to the calling thread's cache
+    void cache_block(void* ptr, u32 size_class);
+    // Flushes all magazines, and detaches the cache from this arena
+    void release_cache(detail::thread_cache* cache);
+
+    memory_arena&           backing_;
+    mutable std::mutex      mutex_;
+    // all the thread caches of this arena, guarded by mutex_
+    detail::thread_cache*   caches_;
+#ifdef NLRS_ARENA_STATS
+    concurrent_arena_stats_recorder stats_;
+#endif
+};
+
+}
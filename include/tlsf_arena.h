@@ -0,0 +1,83 @@
+#pragma once
+
+#include "aliases.h"
+#include "memory_arena.h"
+
+namespace nlrs
+{
+
+// An implementation of the Two-Level Segregated Fit allocator, as described in
+// "TLSF: a New Dynamic Memory Allocator for Real-Time Systems" by Masmano et al.
+//
+// Free blocks are segregated into lists by size. The first level divides the sizes into
+// power-of-two ranges, and the second level subdivides each range linearly into
+// 2^sl_index_count_log2 lists. Bitmaps for both levels record which lists are non-empty.
+// Both finding a fitting free block and merging a freed block with its physical neighbours
+// take a bounded number of instructions, independent of the number of blocks.
+//
+// Each block carries a one-word header containing its size. The last word of a free
+// block is used as a pointer back to it from the physically following block.
+//
+// Like free_list_arena, allocate returns nullptr when there is no free block large enough
+// for the request.
+class tlsf_arena : public memory_arena
+{
+public:
+    tlsf_arena(void* memory, usize num_bytes);
+    tlsf_arena() = delete;
+    tlsf_arena(const tlsf_arena&) = delete;
+    tlsf_arena(tlsf_arena&&) = delete;
+    tlsf_arena& operator=(const tlsf_arena&) = delete;
+    tlsf_arena& operator=(tlsf_arena&&) = delete;
+    ~tlsf_arena();
+
+    void* allocate(usize bytes, u8 alignment = 8u)  override;
+    void* reallocate(void* ptr, usize new_size)     override;
+    void  free(void* ptr)                           override;
+    using memory_arena::free;
+#ifdef NLRS_ARENA_STATS
+    arena_stats stats() const                       override;
+#endif
+
+    inline unsigned int num_allocations() const
+    {
+        return (unsigned int)alloc_count_;
+    }
+
+    // The number of usable bytes in the block, which is at least the requested size.
+    usize block_size(void* ptr) const;
+
+private:
+    struct block_header;
+
+    const static u32 align_size_log2{ 3u };
+    const static u32 align_size{ 1u << align_size_log2 };
+    const static u32 sl_index_count_log2{ 5u };
+    const static u32 sl_index_count{ 1u << sl_index_count_log2 };
+    const static u32 fl_index_shift{ sl_index_count_log2 + align_size_log2 };
+    const static u32 fl_index_max{ 32u };
+    const static u32 fl_index_count{ fl_index_max - fl_index_shift + 1u };
+    const static usize small_block_size{ usize(1u) << fl_index_shift };
+
+    void insert_free_block(block_header* block);
+    void remove_free_block(block_header* block);
+    block_header* locate_free_block(usize size);
+    block_header* merge_prev(block_header* block);
+    block_header* merge_next(block_header* block);
+    block_header* trim_free_leading(block_header* block, usize size);
+    void trim_free(block_header* block, usize size);
+    void trim_used(block_header* block, usize size);
+    // Marks the block as used and trims it to size. The requested size is only used for
+    // the statistics.
+    void* prepare_used(block_header* block, usize size, usize requested_bytes);
+
+    int             alloc_count_;
+    u32             fl_bitmap_;
+    u32             sl_bitmap_[fl_index_count];
+    block_header*   blocks_[fl_index_count][sl_index_count];
+#ifdef NLRS_ARENA_STATS
+    arena_stats_recorder stats_;
+#endif
+};
+
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "aliases.h"
+#include "memory_arena.h"
+
+namespace nlrs
+{
+
+// A free_list_arena over a reserved range of virtual address space, which grows on demand.
+//
+// The whole range is reserved up front, but no physical memory is committed to it. Pages
+// are committed in chunks of commit_granularity bytes as the top of the used region
+// advances, so the arena only costs as much memory as it actually uses. Since the range
+// never moves, pointers into the arena stay valid as it grows. If the range can't be
+// reserved, or its first chunk can't be committed, the constructor aborts with a message.
+//
+// Calling trim() releases the free memory at the top of the used region, and decommits
+// the pages after it, returning them to the operating system.
+class virtual_arena : public free_list_arena
+{
+public:
+    const static usize default_commit_granularity{ 64u * 1024u };
+
+    explicit virtual_arena(usize reserve_bytes, usize commit_granularity = default_commit_granularity);
+    virtual_arena() = delete;
+    virtual_arena(const virtual_arena&) = delete;
+    virtual_arena(virtual_arena&&) = delete;
+    virtual_arena& operator=(const virtual_arena&) = delete;
+    virtual_arena& operator=(virtual_arena&&) = delete;
+    ~virtual_arena();
+
+    // Decommits the pages which are no longer used at the top of the arena. Returns the
+    // number of bytes decommitted.
+    usize trim();
+
+    inline usize committed_bytes() const
+    {
+        return committed_;
+    }
+
+    inline usize reserved_bytes() const
+    {
+        return reserved_;
+    }
+
+protected:
+    usize grow(usize required_size) override;
+
+private:
+    struct reservation
+    {
+        u8*     base;
+        usize   size;
+        usize   granularity;
+    };
+
+    static reservation reserve(usize reserve_bytes, usize commit_granularity);
+
+    virtual_arena(const reservation& r);
+
+    u8*         base_;
+    usize       reserved_;
+    usize       committed_;
+    usize       granularity_;
+};
+
+}
@@ -0,0 +1,188 @@
+#include "arena_trace.h"
+#include "nlrs_assert.h"
+
+namespace nlrs
+{
+
+/***
+ *       ___                   ___              ___
+ *      / _ \___ _______  ____/ (_)__  ___ _   / _ | _______ ___  ___ _
+ *     / , _/ -_) __/ _ \/ __/ _  / / _ \/ _ `/  / __ |/ __/ -_) _ \/ _ `/
+ *    /_/|_|\__/\__/\___/_/  \_,_/_/_//_/\_, /  /_/ |_/_/  \__/_//_/\_,_/
+ *                                      /___/
+ */
+
+const u32 trace_file_header::magic_value;
+const u32 trace_file_header::current_version;
+const usize recording_arena::buffer_capacity;
+
+recording_arena::recording_arena(memory_arena& backing, const char* path)
+    : backing_(backing),
+    file_(std::fopen(path, "wb")),
+    mutex_(),
+    start_(clock::now()),
+    ids_(),
+    next_id_(0u),
+    buffer_()
+{
+    if (file_)
+    {
+        trace_file_header header{ trace_file_header::magic_value, trace_file_header::current_version };
+        if (std::fwrite(&header, sizeof(header), 1u, file_) != 1u)
+        {
+            std::fclose(file_);
+            file_ = nullptr;
+        }
+    }
+    buffer_.reserve(buffer_capacity);
+}
+
+recording_arena::~recording_arena()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    NLRS_ASSERT(ids_.empty());
+    if (file_)
+    {
+        write_buffer();
+        std::fclose(file_);
+    }
+}
+
+void recording_arena::record(trace_op op, u32 id, usize size, u8 alignment)
+{
+    if (!file_)
+    {
+        return;
+    }
+
+    u64 time = u64(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start_).count());
+    buffer_.push_back(trace_event{ time, u64(size), id, op, alignment, 0u });
+    if (buffer_.size() == buffer_capacity)
+    {
+        write_buffer();
+    }
+}
+
+void recording_arena::write_buffer()
+{
+    if (!buffer_.empty())
+    {
+        std::fwrite(buffer_.data(), sizeof(trace_event), buffer_.size(), file_);
+        buffer_.clear();
+    }
+}
+
+void recording_arena::flush()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (file_)
+    {
+        write_buffer();
+        std::fflush(file_);
+    }
+}
+
+void* recording_arena::allocate(usize bytes, u8 alignment)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    void* ptr = backing_.allocate(bytes, alignment);
+    if (ptr)
+    {
+        u32 id = next_id_++;
+        ids_[ptr] = id;
+        record(trace_op::allocate, id, bytes, alignment);
+    }
+    return ptr;
+}
+
+void* recording_arena::reallocate(void* ptr, usize new_size)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    void* new_ptr = backing_.reallocate(ptr, new_size);
+    auto it = ids_.find(ptr);
+    // blocks allocated before the recording started have no id, and go unrecorded
+    if (new_ptr && it != ids_.end())
+    {
+        u32 id = it->second;
+        if (new_ptr != ptr)
+        {
+            ids_.erase(it);
+            ids_[new_ptr] = id;
+        }
+        record(trace_op::reallocate, id, new_size, 0u);
+    }
+    return new_ptr;
+}
+
+void recording_arena::free(void* ptr)
+{
+    if (!ptr)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = ids_.find(ptr);
+    if (it != ids_.end())
+    {
+        record(trace_op::free, it->second, 0u, 0u);
+        ids_.erase(it);
+    }
+    backing_.free(ptr);
+}
+
+void recording_arena::free(void* ptr, usize bytes, u8 alignment)
+{
+    if (!ptr)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = ids_.find(ptr);
+    if (it != ids_.end())
+    {
+        record(trace_op::free, it->second, 0u, 0u);
+        ids_.erase(it);
+    }
+    backing_.free(ptr, bytes, alignment);
+}
+
+#ifdef NLRS_ARENA_STATS
+arena_stats recording_arena::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return backing_.stats();
+}
+#endif
+
+bool read_arena_trace(const char* path, std::vector<trace_event>& events)
+{
+    std::FILE* file = std::fopen(path, "rb");
+    if (!file)
+    {
+        return false;
+    }
+
+    trace_file_header header;
+    if (std::fread(&header, sizeof(header), 1u, file) != 1u ||
+        header.magic != trace_file_header::magic_value ||
+        header.version != trace_file_header::current_version)
+    {
+        std::fclose(file);
+        return false;
+    }
+
+    events.clear();
+    trace_event chunk[1024];
+    usize count = 0u;
+    while ((count = std::fread(chunk, sizeof(trace_event), 1024u, file)) != 0u)
+    {
+        events.insert(events.end(), chunk, chunk + count);
+    }
+
+    std::fclose(file);
+    return true;
+}
+
+}
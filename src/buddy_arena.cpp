@@ -0,0 +1,229 @@
+#include "buddy_arena.h"
+#include "bit_math.h"
+#include "nlrs_assert.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace nlrs
+{
+
+/***
+ *       ___           __   __       ___
+ *      / _ )__ _____/ /__/ /_ __  / _ | _______ ___  ___ _
+ *     / _  / // / _  / _  / // / / __ |/ __/ -_) _ \/ _ `/
+ *    /____/\_,_/\_,_/\_,_/\_, / /_/ |_/_/  \__/_//_/\_,_/
+ *                        /___/
+ */
+
+const usize buddy_arena::max_orders;
+const u8 buddy_arena::free_bit;
+const u8 buddy_arena::order_mask;
+
+namespace
+{
+
+// The largest alignment a memory_arena supports. Aligning the start of the memory to it
+// means that every block is aligned to its size, up to this alignment.
+const uptr base_alignment = 128u;
+
+}
+
+buddy_arena::buddy_arena(void* memory, usize num_bytes, usize min_block_size)
+    : memory_(nullptr),
+    size_(0u),
+    table_(nullptr),
+    min_order_(0u),
+    free_orders_(0u),
+    free_lists_{ nullptr },
+    free_bytes_(0u),
+    alloc_count_(0u)
+{
+    NLRS_ASSERT(memory);
+    NLRS_ASSERT((min_block_size & (min_block_size - 1u)) == 0u);
+    NLRS_ASSERT(min_block_size >= sizeof(free_block));
+    min_order_ = find_last_set(min_block_size);
+
+    uptr start = reinterpret_cast<uptr>(memory);
+    uptr aligned = (start + base_alignment - 1u) & ~(base_alignment - 1u);
+    NLRS_ASSERT(usize(aligned - start) < num_bytes);
+    usize available = num_bytes - usize(aligned - start);
+
+    // each min_block_size bytes of blocks need one byte in the table
+    usize num_units = available / (min_block_size + 1u);
+    NLRS_ASSERT(num_units > 0u);
+    memory_ = reinterpret_cast<u8*>(aligned);
+    size_ = num_units * min_block_size;
+    table_ = memory_ + size_;
+    std::memset(table_, 0, num_units);
+
+    // Split the memory into the largest blocks possible, following the binary
+    // representation of its size. The buddy of each of these blocks would extend past the
+    // end of the memory, so they are never merged.
+    usize offset = 0u;
+    for (u32 order = find_last_set(size_) + 1u; order-- > min_order_;)
+    {
+        usize block_size = usize(1u) << order;
+        if (size_ & block_size)
+        {
+            insert_free_block(offset, order);
+            offset += block_size;
+        }
+    }
+    free_bytes_ = size_;
+}
+
+buddy_arena::~buddy_arena()
+{
+    NLRS_ASSERT(alloc_count_ == 0u);
+}
+
+void buddy_arena::insert_free_block(usize offset, u32 order)
+{
+    free_block* block = reinterpret_cast<free_block*>(memory_ + offset);
+    free_block* head = free_lists_[order];
+    block->prev = nullptr;
+    block->next = head;
+    if (head)
+    {
+        head->prev = block;
+    }
+    free_lists_[order] = block;
+    free_orders_ |= u64(1u) << order;
+    table_entry(offset) = u8(free_bit | order);
+}
+
+void buddy_arena::remove_free_block(usize offset, u32 order)
+{
+    free_block* block = reinterpret_cast<free_block*>(memory_ + offset);
+    if (block->prev)
+    {
+        block->prev->next = block->next;
+    }
+    else
+    {
+        free_lists_[order] = block->next;
+        if (!block->next)
+        {
+            free_orders_ &= ~(u64(1u) << order);
+        }
+    }
+    if (block->next)
+    {
+        block->next->prev = block->prev;
+    }
+    table_entry(offset) = u8(order);
+}
+
+void* buddy_arena::allocate(usize bytes, u8 alignment)
+{
+    NLRS_ASSERT((alignment & (alignment - 1u)) == 0u);
+    if (bytes == 0u || bytes > size_)
+    {
+        return nullptr;
+    }
+
+    // the block is aligned to its size, so it is made at least as large as the alignment
+    const usize block_bytes = std::max(bytes, usize(alignment));
+    const u32 order = std::max(min_order_, find_last_set(next_power_of_two(block_bytes)));
+    const u64 candidates = free_orders_ & ~((u64(1u) << order) - 1u);
+    if (candidates == 0u)
+    {
+        return nullptr;
+    }
+
+    // take the smallest free block which is large enough, and split it down to size
+    u32 block_order = find_first_set(candidates);
+    usize offset = offset_of(free_lists_[block_order]);
+    remove_free_block(offset, block_order);
+    while (block_order > order)
+    {
+        --block_order;
+        insert_free_block(offset + (usize(1u) << block_order), block_order);
+    }
+    table_entry(offset) = u8(order);
+
+    const usize size = usize(1u) << order;
+    free_bytes_ -= size;
+    ++alloc_count_;
+    NLRS_ARENA_STATS_RECORD(stats_.on_allocate(bytes, size));
+    NLRS_ARENA_STATS_RECORD(stats_.on_high_water(offset + size));
+    return memory_ + offset;
+}
+
+void* buddy_arena::reallocate(void* ptr, usize new_size)
+{
+    NLRS_ASSERT(ptr);
+    NLRS_ASSERT(new_size != 0u);
+
+    const usize old_size = block_size(ptr);
+    if (new_size <= old_size)
+    {
+        return ptr;
+    }
+
+    void* new_ptr = allocate(new_size);
+    if (new_ptr)
+    {
+        std::memcpy(new_ptr, ptr, old_size);
+        free(ptr);
+    }
+    return new_ptr;
+}
+
+void buddy_arena::free(void* ptr)
+{
+    if (!ptr)
+    {
+        return;
+    }
+
+    NLRS_ASSERT(ptr >= memory_ && ptr < memory_ + size_);
+    usize offset = offset_of(ptr);
+    u8 entry = table_entry(offset);
+    NLRS_ASSERT(!(entry & free_bit));
+    NLRS_ASSERT(alloc_count_ > 0u);
+    u32 order = entry & order_mask;
+    NLRS_ASSERT((offset & ((usize(1u) << order) - 1u)) == 0u);
+
+    const usize size = usize(1u) << order;
+    free_bytes_ += size;
+    --alloc_count_;
+    NLRS_ARENA_STATS_RECORD(stats_.on_free(size));
+
+    // merge with the buddy for as long as it is free and of the same order
+    while (true)
+    {
+        usize buddy = offset ^ (usize(1u) << order);
+        if (buddy + (usize(1u) << order) > size_ || table_entry(buddy) != u8(free_bit | order))
+        {
+            break;
+        }
+        remove_free_block(buddy, order);
+        offset = std::min(offset, buddy);
+        ++order;
+    }
+    insert_free_block(offset, order);
+}
+
+usize buddy_arena::block_size(void* ptr) const
+{
+    NLRS_ASSERT(ptr >= memory_ && ptr < memory_ + size_);
+    u8 entry = table_entry(offset_of(ptr));
+    NLRS_ASSERT(!(entry & free_bit));
+    return usize(1u) << (entry & order_mask);
+}
+
+usize buddy_arena::largest_free_block() const
+{
+    return free_orders_ ? usize(1u) << find_last_set(free_orders_) : 0u;
+}
+
+#ifdef NLRS_ARENA_STATS
+arena_stats buddy_arena::stats() const
+{
+    return stats_.snapshot(free_bytes_, largest_free_block());
+}
+#endif
+
+}
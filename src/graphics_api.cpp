@@ -3,7 +3,7 @@
 #include "configuration.h"
 #include "graphics_api.h"
 #include "log.h"
-#include "object_pool.h"
+#include "slot_map.h"
 #include "sdl_window.h"
 #include "SDL_video.h"
 
@@ -46,7 +46,7 @@ struct GlAttribute
     const void* offset;
 };
 
-using GlDescriptor = nlrs::resizable_array<GlAttribute, 6>;
+using GlDescriptor = nlrs::small_array<GlAttribute, 6>;
 
 struct PipelineObject
 {
@@ -59,9 +59,12 @@ struct PipelineObject
     nlrs::blend_function blendFunction;
 };
 
+using PipelineMap = nlrs::slot_map<PipelineObject>;
+using DescriptorMap = nlrs::slot_map<GlDescriptor>;
+
 struct RenderPass
 {
-    const PipelineObject* currentPipeline;
+    nlrs::pipeline_handle currentPipeline;
     GLint previousProgram;
     GLint previousVertexArrayObject;
     bool active;
@@ -77,19 +80,18 @@ static const GlBufferObject& asGlBufferObject(const nlrs::buffer_handle& info)
     return (const GlBufferObject&)info;
 }
 
-static PipelineObject& asPipelineObject(nlrs::pipeline_handle info)
+static PipelineMap::handle asPipelineHandle(nlrs::pipeline_handle info)
 {
-    return *reinterpret_cast<PipelineObject*>(info);
+    return PipelineMap::handle::from_value(info);
 }
 
-static GlDescriptor& asDescriptorObject(nlrs::descriptor_handle info)
+static DescriptorMap::handle asDescriptorHandle(nlrs::descriptor_handle info)
 {
-    return *reinterpret_cast<GlDescriptor*>(info);
+    return DescriptorMap::handle::from_value(info);
 }
 
-static void applyDescriptor(nlrs::descriptor_handle info)
+static void applyDescriptor(const GlDescriptor& descriptor)
 {
-    const GlDescriptor& descriptor = asDescriptorObject(info);
     for (auto& attrib : descriptor)
     {
         glEnableVertexAttribArray(attrib.index);
@@ -359,17 +361,17 @@ namespace nlrs
 struct graphics_api::RenderState
 {
     SDL_GLContext context;
-    object_pool<PipelineObject, max_pipelines> pipelines;
-    object_pool<GlDescriptor, max_descriptors> descriptors;
-    std::pmr::unordered_map<buffer_handle, u32> boundUniformBuffers;
+    PipelineMap pipelines;
+    DescriptorMap descriptors;
+    pmr::unordered_map<buffer_handle, u32> boundUniformBuffers;
     RenderPass renderPass;
     u32 currentUniformBinding;
     u32 dummyVao;
 
     RenderState(memory_arena& allocator)
         : context(nullptr),
-        pipelines(allocator),
-        descriptors(allocator),
+        pipelines(allocator, initial_pipeline_capacity),
+        descriptors(allocator, initial_descriptor_capacity),
         boundUniformBuffers(),
         renderPass{ 0 },
         currentUniformBinding(0u),
@@ -513,14 +515,20 @@ descriptor_handle graphics_api::make_descriptor(const descriptor_options& attrib
         stride += asByteSize(attrib.type());
     }
 
-    GlDescriptor* descriptor = state_->descriptors.create();
+    DescriptorMap::handle handle = state_->descriptors.emplace();
+    if (!handle)
+    {
+        LOG_ERROR << "Renderer> Out of memory for descriptors";
+        return invalid_descriptor;
+    }
+    GlDescriptor& descriptor = state_->descriptors[handle];
 
     uptr offset = 0u;
     for (const auto& attrib : attributes)
     {
         if (attrib.used())
         {
-            descriptor->emplace_back(
+            descriptor.emplace_back(
                 attrib.location(),                          // index
                 asGlAttributeElementCount(attrib.type()),   // elements
                 asGlattribute_type(attrib.type()),           // type
@@ -532,15 +540,21 @@ descriptor_handle graphics_api::make_descriptor(const descriptor_options& attrib
         offset += asByteSize(attrib.type());
     }
 
-    return reinterpret_cast<uptr>(descriptor);
+    return handle.value();
 }
 
 void graphics_api::release_descriptor(descriptor_handle info)
 {
-    state_->descriptors.release(&asDescriptorObject(info));
+    if (info == invalid_descriptor)
+    {
+        LOG_DEBUG << "Renderer> Attempted to release invalid descriptor";
+        return;
+    }
+
+    state_->descriptors.erase(asDescriptorHandle(info));
 }
 
-shader_handle graphics_api::make_shader(const std::pmr::vector<shader_stage>& stages)
+shader_handle graphics_api::make_shader(const pmr::vector<shader_stage>& stages)
 {
     u32 program = glCreateProgram();
 
@@ -641,13 +655,11 @@ void graphics_api::release_shader(shader_handle program)
 pipeline_handle graphics_api::make_pipeline(const pipeline_options& opts)
 {
     // TODO: give PipelineObject a constructor for PipelineOptions
-    PipelineObject* obj = state_->pipelines.create(
+    PipelineMap::handle handle = state_->pipelines.emplace(
         opts.shader, opts.depth_test_enabled, opts.culling_enabled,
         opts.scissor_test_enabled, opts.blend_enabled, opts.depth_comparison_func, opts.blend_func);
 
-    NLRS_ASSERT(obj != nullptr);
-
-    return reinterpret_cast<uptr>(obj);
+    return handle.value();
 }
 
 void graphics_api::release_pipeline(pipeline_handle info)
@@ -658,16 +670,15 @@ void graphics_api::release_pipeline(pipeline_handle info)
         return;
     }
 
-    PipelineObject* obj = reinterpret_cast<PipelineObject*>(info);
-    state_->pipelines.release(obj);
+    state_->pipelines.erase(asPipelineHandle(info));
 }
 
 void graphics_api::begin_pass(pipeline_handle info)
 {
-    const PipelineObject& pipeline = asPipelineObject(info);
+    const PipelineObject& pipeline = state_->pipelines[asPipelineHandle(info)];
 
     state_->renderPass.active = true;
-    state_->renderPass.currentPipeline = &pipeline;
+    state_->renderPass.currentPipeline = info;
     glGetIntegerv(GL_CURRENT_PROGRAM, &state_->renderPass.previousProgram);
     NLRS_ASSERT(state_->renderPass.previousProgram >= 0);
     glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &state_->renderPass.previousVertexArrayObject);
@@ -696,7 +707,7 @@ void graphics_api::apply_draw_state(const draw_state& state)
     // we may want to render objects that are used for shared shader storage,
     // for instance
     glBindBuffer(GL_ARRAY_BUFFER, obj.buffer);
-    applyDescriptor(state.descriptor);
+    applyDescriptor(state_->descriptors[asDescriptorHandle(state.descriptor)]);
     glDrawArrays(asGlDrawMode(state.mode), 0, state.index_count);
 }
 
@@ -708,7 +719,7 @@ void graphics_api::apply_indexed_draw_state(const draw_state& state, buffer_hand
     const GlBufferObject& indices = asGlBufferObject(ihandle);
     glBindBuffer(GL_ARRAY_BUFFER, verts.buffer);
     glBindBuffer(indices.target, indices.buffer);
-    applyDescriptor(state.descriptor);
+    applyDescriptor(state_->descriptors[asDescriptorHandle(state.descriptor)]);
     glDrawElements(asGlDrawMode(state.mode), state.index_count, asGlIndexType(itype), nullptr);
 }
 
@@ -0,0 +1,77 @@
+#include "linear_arena.h"
+#include "nlrs_assert.h"
+#include "bit_math.h"
+#include <algorithm>
+#include <cstring>
+
+namespace nlrs
+{
+
+/***
+ *       __   _                    ___   ____              __
+ *      / /  (_)__  ___ ___ _____ / _ | / / /__  _______ _/ /____  ____
+ *     / /__/ / _ \/ -_) _ `/ __// __ |/ / / _ \/ __/ _ `/ __/ _ \/ __/
+ *    /____/_/_//_/\__/\_,_/_/  /_/ |_/_/_/\___/\__/\_,_/\__/\___/_/
+ *
+ */
+
+linear_arena::linear_arena(void* memory, usize num_bytes)
+    : arena_(static_cast<u8*>(memory)),
+    offset_(0u),
+    size_(num_bytes),
+    last_(nullptr)
+{}
+
+void* linear_arena::reallocate(void* ptr, usize new_size)
+{
+    NLRS_ASSERT(ptr);
+    NLRS_ASSERT(new_size != 0u);
+
+    u8* p = static_cast<u8*>(ptr);
+    NLRS_ASSERT(p >= arena_ && p < arena_ + offset_);
+
+    // the most recent allocation can simply be resized
+    if (p == last_)
+    {
+        usize new_offset = usize(p - arena_) + new_size;
+        if (new_offset > size_)
+        {
+            return nullptr;
+        }
+        NLRS_ARENA_STATS_RECORD(stats_.on_resize(offset_, new_offset));
+        NLRS_ARENA_STATS_RECORD(stats_.on_high_water(new_offset));
+        offset_ = new_offset;
+        return ptr;
+    }
+
+    // The size of the old allocation is unknown, but it can't extend past the current
+    // top of the arena. The new allocation is placed above the top, so the ranges don't overlap.
+    usize old_size_bound = usize(arena_ + offset_ - p);
+    void* new_ptr = allocate(new_size, alignment_of_address(ptr));
+    if (!new_ptr)
+    {
+        return nullptr;
+    }
+    std::memcpy(new_ptr, ptr, std::min(old_size_bound, new_size));
+    return new_ptr;
+}
+
+void linear_arena::rewind(marker m)
+{
+    NLRS_ASSERT(m <= offset_);
+    offset_ = m;
+    NLRS_ARENA_STATS_RECORD(stats_.on_rewind(m));
+    if (last_ && last_ >= arena_ + m)
+    {
+        last_ = nullptr;
+    }
+}
+
+#ifdef NLRS_ARENA_STATS
+arena_stats linear_arena::stats() const
+{
+    return stats_.snapshot(size_ - offset_, size_ - offset_);
+}
+#endif
+
+}
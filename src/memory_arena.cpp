@@ -1,9 +1,19 @@
 #include "memory_arena.h"
 #include "nlrs_assert.h"
 #include "bit_math.h"
+#include "configuration.h"
 #include <algorithm>
+#include <cstddef>
 #include <cstdlib>
 #include <cstdint>
+#include <cstring>
+
+#if NLRS_PLATFORM == NLRS_POSIX
+#include <sys/mman.h>
+#elif NLRS_PLATFORM == NLRS_WIN32
+#define NOMINMAX
+#include <windows.h>
+#endif
 
 namespace
 {
@@ -32,6 +42,89 @@ nlrs::u8 align_address_forward(void* addr, nlrs::u8 alignment)
 namespace nlrs
 {
 
+namespace
+{
+
+// Precedes every allocation made by the system_arena
+struct system_header
+{
+    // the number of usable bytes after the header
+    usize   capacity;
+    // the number of bytes from the start of the underlying allocation to the user's memory
+    u32     offset;
+    u16     alignment;
+    u16     kind;
+};
+
+enum system_allocation_kind : u16
+{
+    // malloc'd, with the user's memory right after the header
+    heap,
+    // malloc'd with extra room for aligning the user's memory
+    aligned_heap,
+    // mapped directly from the operating system
+    mapped
+};
+
+const usize system_header_bytes = sizeof(system_header);
+
+system_header* system_header_of(void* ptr)
+{
+    return static_cast<system_header*>(ptr) - 1u;
+}
+
+uptr align_up(uptr address, usize alignment)
+{
+    return (address + (alignment - 1u)) & ~uptr(alignment - 1u);
+}
+
+void* map_pages(usize bytes)
+{
+#if NLRS_PLATFORM == NLRS_POSIX
+    // Map an extra huge page, so that the start of the mapping can be aligned to a huge
+    // page boundary. The excess at both ends is unmapped.
+    const usize align = system_arena::huge_page_size;
+    u8* memory = static_cast<u8*>(
+        mmap(nullptr, bytes + align, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    if (memory == MAP_FAILED)
+    {
+        return nullptr;
+    }
+    u8* aligned = reinterpret_cast<u8*>(align_up(reinterpret_cast<uptr>(memory), align));
+    usize head = usize(aligned - memory);
+    if (head)
+    {
+        munmap(memory, head);
+    }
+    if (align - head)
+    {
+        munmap(aligned + bytes, align - head);
+    }
+#ifdef MADV_HUGEPAGE
+    madvise(aligned, bytes, MADV_HUGEPAGE);
+#endif
+    return aligned;
+#elif NLRS_PLATFORM == NLRS_WIN32
+    // Large pages need the SeLockMemoryPrivilege, so regular pages are used here
+    return VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+    return std::malloc(bytes);
+#endif
+}
+
+void unmap_pages(void* memory, usize bytes)
+{
+#if NLRS_PLATFORM == NLRS_POSIX
+    munmap(memory, bytes);
+#elif NLRS_PLATFORM == NLRS_WIN32
+    VirtualFree(memory, 0, MEM_RELEASE);
+#else
+    std::free(memory);
+#endif
+}
+
+}
+
 /***
  *       ____         __            ___   ____              __
  *      / __/_ _____ / /____ __ _  / _ | / / /__  _______ _/ /____  ____
@@ -40,6 +133,9 @@ namespace nlrs
  *        /___/
  */
 
+const usize system_arena::huge_page_size;
+const usize system_arena::huge_page_threshold;
+
 system_arena::~system_arena()
 {
     NLRS_ASSERT(alloc_count_ == 0);
@@ -54,32 +150,124 @@ system_arena& system_arena::get_instance()
 
 void* system_arena::allocate(usize bytes, u8 alignment)
 {
-    alloc_count_++;
+    NLRS_ASSERT((alignment & (alignment - 1u)) == 0u);
+    if (bytes == 0u)
+    {
+        return nullptr;
+    }
 
-    // TODO: figure out how to get aligned_alloc working
-     //return std::aligned_alloc(bytes);
+    u8* memory = nullptr;
+    usize offset = system_header_bytes;
+    usize capacity = bytes;
+    u16 kind = heap;
 
-    return std::malloc(bytes);
+    if (bytes >= huge_page_threshold)
+    {
+        // the offset is smaller than a page, so the mapping stays page aligned
+        offset = std::max(usize(alignment), system_header_bytes);
+        usize length = usize(align_up(offset + bytes, huge_page_size));
+        memory = static_cast<u8*>(map_pages(length));
+        capacity = length - offset;
+        kind = mapped;
+    }
+    // malloc's memory is suitably aligned for any fundamental type, and the header
+    // is a multiple of that alignment
+    else if (alignment <= alignof(std::max_align_t) && system_header_bytes % alignof(std::max_align_t) == 0u)
+    {
+        memory = static_cast<u8*>(std::malloc(offset + bytes));
+    }
+    else
+    {
+        memory = static_cast<u8*>(std::malloc(system_header_bytes + alignment + bytes));
+        if (memory)
+        {
+            offset = usize(align_up(reinterpret_cast<uptr>(memory) + system_header_bytes, alignment) -
+                reinterpret_cast<uptr>(memory));
+        }
+        kind = aligned_heap;
+    }
+
+    if (!memory)
+    {
+        return nullptr;
+    }
+
+    alloc_count_.fetch_add(1, std::memory_order_relaxed);
+    NLRS_ARENA_STATS_RECORD(stats_.on_allocate(bytes, offset + capacity));
+
+    system_header* hdr = system_header_of(memory + offset);
+    hdr->capacity = capacity;
+    hdr->offset = u32(offset);
+    hdr->alignment = alignment;
+    hdr->kind = kind;
+    return memory + offset;
 }
 
 void* system_arena::reallocate(void* ptr, usize bytes)
 {
     NLRS_ASSERT(ptr);
-    return std::realloc(ptr, bytes);
+    NLRS_ASSERT(bytes != 0u);
+
+    system_header* hdr = system_header_of(ptr);
+
+    // realloc keeps the user's memory right after the header, so the alignment is kept
+    if (hdr->kind == heap && bytes < huge_page_threshold)
+    {
+#ifdef NLRS_ARENA_STATS
+        usize old_bytes = hdr->offset + hdr->capacity;
+#endif
+        u8* memory = static_cast<u8*>(std::realloc(static_cast<u8*>(ptr) - hdr->offset, hdr->offset + bytes));
+        if (!memory)
+        {
+            return nullptr;
+        }
+        NLRS_ARENA_STATS_RECORD(stats_.on_resize(old_bytes, system_header_bytes + bytes));
+        system_header_of(memory + system_header_bytes)->capacity = bytes;
+        return memory + system_header_bytes;
+    }
+
+    if (hdr->kind == mapped && bytes <= hdr->capacity)
+    {
+        return ptr;
+    }
+
+    void* new_ptr = allocate(bytes, u8(hdr->alignment));
+    if (new_ptr)
+    {
+        std::memcpy(new_ptr, ptr, std::min(bytes, hdr->capacity));
+        free(ptr);
+    }
+    return new_ptr;
 }
 
 void system_arena::free(void* ptr)
 {
-    alloc_count_--;
-    std::free(ptr);
+    if (!ptr)
+    {
+        return;
+    }
+
+    system_header* hdr = system_header_of(ptr);
+    u8* memory = static_cast<u8*>(ptr) - hdr->offset;
+    NLRS_ARENA_STATS_RECORD(stats_.on_free(hdr->offset + hdr->capacity));
+    if (hdr->kind == mapped)
+    {
+        unmap_pages(memory, hdr->offset + hdr->capacity);
+    }
+    else
+    {
+        std::free(memory);
+    }
+
+    NLRS_ASSERT(alloc_count_ > 0);
+    alloc_count_.fetch_sub(1, std::memory_order_relaxed);
 }
 
-#ifdef NLRS_DEBUG
-#define mark_alloc_bytes(memory, num_bytes) std::memset(memory, 0xa5, num_bytes)
-#define mark_free_bytes(memory, num_bytes) std::memset(memory, 0xee, num_bytes)
-#else
-#define mark_alloc_bytes(memory, bytes)
-#define mark_free_bytes(memory, bytes)
+#ifdef NLRS_ARENA_STATS
+arena_stats system_arena::stats() const
+{
+    return stats_.snapshot(0u, 0u);
+}
 #endif
 
 #define BEEFCAFE 0xfecaefbe
@@ -92,22 +280,65 @@ void system_arena::free(void* ptr)
  *
  */
 
-free_list_arena::free_list_arena(void* memory, usize numBytes)
+template<typename P>
+basic_free_list_arena<P>::basic_free_list_arena(void* memory, usize numBytes)
     : alloc_count_(0),
     free_list_size_(0u),
     arena_(memory),
     offset_(0u),
     size_(numBytes),
-    free_list_head_(nullptr)
-{}
+    size_class_bits_(0u),
+    size_classes_{ nullptr }
+{
+    NLRS_ASSERT(size_ >= num_tag_bytes);
+    // the boundary tags are whole words
+    NLRS_ASSERT(reinterpret_cast<uptr>(memory) % alignof(usize) == 0u);
+    // the sentinel at the top of the used region
+    *static_cast<usize*>(arena_) = tag_allocated | tag_prev_allocated;
+}
 
-free_list_arena::~free_list_arena()
+template<typename P>
+basic_free_list_arena<P>::~basic_free_list_arena()
 {
     NLRS_ASSERT(alloc_count_ == 0);
 }
 
-void* free_list_arena::annotate_memory(void* memory, usize block_size, u8 alignment)
+template<typename P>
+usize basic_free_list_arena<P>::block_overhead(u8 alignment)
+{
+    if (P::guard_blocks)
+    {
+        return num_tag_bytes + num_header_bytes + num_guard_bytes + alignment;
+    }
+    // the user's memory directly follows the tag, unless it needs a padding word
+    return alignment <= num_tag_bytes ? num_tag_bytes : 2u * num_tag_bytes + alignment;
+}
+
+template<typename P>
+void* basic_free_list_arena<P>::annotate_memory(void* memory, usize block_size, u8 alignment)
 {
+    // skip the boundary tag, which the caller has written
+    memory = static_cast<u8*>(memory) + num_tag_bytes;
+    block_size -= num_tag_bytes;
+
+    if (!P::guard_blocks)
+    {
+        u8* user = static_cast<u8*>(memory);
+        if (alignment > num_tag_bytes)
+        {
+            user += num_tag_bytes;
+            user += align_address_forward(user, alignment);
+            usize offset = usize(user - static_cast<u8*>(memory)) + num_tag_bytes;
+            *(reinterpret_cast<usize*>(user) - 1u) =
+                tag_padding | (usize(alignment) << padding_alignment_shift) | (offset << padding_offset_shift);
+        }
+        if (P::fill_memory)
+        {
+            std::memset(user, 0xa5, block_size - usize(user - static_cast<u8*>(memory)));
+        }
+        return user;
+    }
+
     u8 align_offset = align_address_forward((static_cast<u8*>(memory) + guard_byte + num_header_bytes), alignment);
 
     // given a block of memory, write the magic number at the beginning & end of the block
@@ -122,173 +353,383 @@ void* free_list_arena::annotate_memory(void* memory, usize block_size, u8 alignm
 
     // write the size of the block in memory
     header* hdr = reinterpret_cast<header*>(reinterpret_cast<u8*>(guard_mem) + align_offset);
-    hdr->size = block_size;
+    hdr->size = block_size + num_tag_bytes;
     hdr->offset = align_offset;
     hdr->alignment = alignment;
     // advance past the header
     hdr += 1u;
-    mark_alloc_bytes(hdr, block_size - num_guard_bytes - num_header_bytes - align_offset);
+    if (P::fill_memory)
+    {
+        std::memset(hdr, 0xa5, block_size - num_guard_bytes - num_header_bytes - align_offset);
+    }
 
     return hdr;
 }
 
+template<typename P>
+u8* basic_free_list_arena<P>::block_start_of(void* ptr)
+{
+    if (P::guard_blocks)
+    {
+        header* hdr = static_cast<header*>(ptr) - 1u;
+        return reinterpret_cast<u8*>(hdr) - hdr->offset - guard_byte - num_tag_bytes;
+    }
+    // the word before the user's memory is either the block's tag, or a padding word
+    usize word = *(static_cast<usize*>(ptr) - 1u);
+    if (word & tag_padding)
+    {
+        return static_cast<u8*>(ptr) - (word >> padding_offset_shift);
+    }
+    return static_cast<u8*>(ptr) - num_tag_bytes;
+}
+
+template<typename P>
+u8 basic_free_list_arena<P>::alignment_of(void* ptr)
+{
+    if (P::guard_blocks)
+    {
+        return (static_cast<header*>(ptr) - 1u)->alignment;
+    }
+    usize word = *(static_cast<usize*>(ptr) - 1u);
+    if (word & tag_padding)
+    {
+        return u8(word >> padding_alignment_shift);
+    }
+    return u8(num_tag_bytes);
+}
+
+template<typename P>
+usize basic_free_list_arena<P>::capacity_of(void* ptr, u8* block_start, usize block_size)
+{
+    usize capacity = block_size - usize(static_cast<u8*>(ptr) - block_start);
+    return P::guard_blocks ? capacity - guard_byte : capacity;
+}
+
 // TODO:
 // WTF, no idea why this needs to be here while the others can be initialized in the class declaration
-const usize free_list_arena::min_block_size = sizeof(free_list_arena::free_block);
+// Free blocks need room for the footer in addition to the free_block struct.
+template<typename P>
+const usize basic_free_list_arena<P>::min_block_size = usize(next_power_of_two(sizeof(free_block) + sizeof(usize)));
+
+template<typename P>
+void basic_free_list_arena<P>::insert_into_size_class(free_block* block)
+{
+    u32 size_class = find_last_set(tag_size(block->tag));
+    block->prev_in_class = nullptr;
+    block->next_in_class = size_classes_[size_class];
+    if (block->next_in_class)
+    {
+        block->next_in_class->prev_in_class = block;
+    }
+    size_classes_[size_class] = block;
+    size_class_bits_ |= u64(1u) << size_class;
+}
+
+template<typename P>
+void basic_free_list_arena<P>::remove_from_size_class(free_block* block)
+{
+    u32 size_class = find_last_set(tag_size(block->tag));
+    if (block->prev_in_class)
+    {
+        block->prev_in_class->next_in_class = block->next_in_class;
+    }
+    else
+    {
+        size_classes_[size_class] = block->next_in_class;
+        if (!block->next_in_class)
+        {
+            size_class_bits_ &= ~(u64(1u) << size_class);
+        }
+    }
+    if (block->next_in_class)
+    {
+        block->next_in_class->prev_in_class = block->prev_in_class;
+    }
+}
 
-void* free_list_arena::allocate(usize num_requested_bytes, u8 alignment)
+template<typename P>
+usize basic_free_list_arena<P>::split_block(u8* block, usize block_size, usize used_size)
+{
+    NLRS_ASSERT(used_size <= block_size);
+    usize rest = block_size - used_size;
+    if (rest < min_block_size)
+    {
+        *reinterpret_cast<usize*>(block + block_size) |= tag_prev_allocated;
+        return block_size;
+    }
+
+    // the block following the rest is already marked as having a free predecessor
+    free_block* rest_block = reinterpret_cast<free_block*>(block + used_size);
+    rest_block->tag = rest | tag_prev_allocated;
+    *reinterpret_cast<usize*>(block + block_size - num_tag_bytes) = rest;
+    insert_into_size_class(rest_block);
+    ++free_list_size_;
+
+    return used_size;
+}
+
+template<typename P>
+void* basic_free_list_arena<P>::allocate(usize num_requested_bytes, u8 alignment)
 {
     if (num_requested_bytes == 0u)
     {
         return nullptr;
     }
 
-    usize block_size = num_requested_bytes;
-    // we need space for the header, as well as the guard bytes. Inflate the block size accordingly
-    block_size += num_header_bytes + num_guard_bytes + alignment;
+    // we need space for the tag, as well as the header and the guard bytes if the policy
+    // asks for them. Inflate the block size accordingly
+    usize block_size = num_requested_bytes + block_overhead(alignment);
     block_size = std::max(min_block_size, block_size);
 
     // we want all blocks to be powers of tywo in size to reduce fragmentation
     // the extra memory could be used in a realloc, for instance
 
     block_size = usize(next_power_of_two(block_size));
-    NLRS_ASSERT(block_size >= sizeof(free_block));
-    NLRS_ASSERT(block_size - num_header_bytes - num_guard_bytes >= num_requested_bytes);
-
-    NLRS_ASSERT(block_size < size_ - offset_);
+    NLRS_ASSERT(block_size >= min_block_size);
 
     ++alloc_count_;
 
-    // fetch the memory from the free list if possible
-    free_block* cur_block = free_list_head_;
-    free_block* prev_block = nullptr;
-    while (cur_block)
+    // fetch the memory from the smallest non-empty size class which is at least as large
+    // as the block. The block size already accounts for the worst-case alignment offset,
+    // so any block in such a class fits.
+    u32 size_class = find_last_set(block_size);
+    u64 candidates = size_class_bits_ & ~((u64(1u) << size_class) - 1u);
+    if (candidates)
     {
-        // TODO: this is not totally optimum, as it's done again in prepareMemory_
-        u8 alignOffset = align_address_forward((u8*)cur_block + guard_byte + num_header_bytes, alignment);
-        if (cur_block->size < block_size + usize(alignOffset))
-        {
-            prev_block = cur_block;
-            cur_block = cur_block->next;
-            continue;
-        }
-        if (prev_block)
-        {
-            prev_block->next = cur_block->next;
-        }
-        else
-        {
-            free_list_head_ = free_list_head_->next;
-        }
-
+        free_block* block = size_classes_[find_first_set(candidates)];
+        remove_from_size_class(block);
         --free_list_size_;
 
-        //TODO:
-        // If the rest of the block is large enough, then return it back to the free list!
-        void* memory = cur_block;
-        usize size = cur_block->size;
-        return annotate_memory(memory, size, alignment);
+        // If the rest of the block is large enough, then it is returned back to the free list
+        usize size = split_block(reinterpret_cast<u8*>(block), tag_size(block->tag), block_size);
+        // the block preceding a free block is always allocated, since free blocks get merged
+        block->tag = size | tag_allocated | tag_prev_allocated;
+        NLRS_ARENA_STATS_RECORD(stats_.on_allocate(num_requested_bytes, size));
+        return annotate_memory(block, size, alignment);
     }
 
-    void* mem = static_cast<u8*>(arena_) + offset_;
+    // leave room for the sentinel tag after the block
+    if (block_size + num_tag_bytes > size_ - offset_)
+    {
+        size_ = grow(offset_ + block_size + num_tag_bytes);
+        if (block_size + num_tag_bytes > size_ - offset_)
+        {
+            --alloc_count_;
+            return nullptr;
+        }
+    }
+
+    u8* mem = static_cast<u8*>(arena_) + offset_;
+    usize prev_allocated = *reinterpret_cast<usize*>(mem) & tag_prev_allocated;
+    *reinterpret_cast<usize*>(mem) = block_size | tag_allocated | prev_allocated;
     offset_ += block_size;
+    *reinterpret_cast<usize*>(mem + block_size) = tag_allocated | tag_prev_allocated;
+    NLRS_ARENA_STATS_RECORD(stats_.on_allocate(num_requested_bytes, block_size));
+    NLRS_ARENA_STATS_RECORD(stats_.on_high_water(offset_ + num_tag_bytes));
     return annotate_memory(mem, block_size, alignment);
 }
 
-void* free_list_arena::reallocate(void* ptr, usize newSize)
+template<typename P>
+void* basic_free_list_arena<P>::reallocate(void* ptr, usize newSize)
 {
     NLRS_ASSERT(ptr);
     NLRS_ASSERT(newSize != 0u);
 
-    header* hdr = reinterpret_cast<header*>(ptr) - 1u;
+    u8* block_start = block_start_of(ptr);
+    usize block_size = tag_size(*reinterpret_cast<usize*>(block_start));
+    usize capacity = capacity_of(ptr, block_start, block_size);
 
-    if (hdr->size - num_guard_bytes - num_header_bytes - hdr->offset >= newSize)
+    if (capacity >= newSize)
     {
         return ptr;
     }
 
-    void* new_ptr = allocate(newSize, hdr->alignment);
-    std::memcpy(new_ptr, ptr, hdr->size - num_guard_bytes - num_header_bytes - hdr->offset);
-    free(ptr);
-    return new_ptr;
-}
+    // try to grow the block in place, without copying
+    usize new_block_size = usize(next_power_of_two(block_size - capacity + newSize));
+    u8* block_end = block_start + block_size;
+    usize next_tag = *reinterpret_cast<usize*>(block_end);
+    bool grown = false;
 
-void free_list_arena::free(void* ptr)
-{
-    if (!ptr)
+    // the block is followed by a large enough free block
+    if (!(next_tag & tag_allocated) && block_size + tag_size(next_tag) >= new_block_size)
     {
-        return;
+        remove_from_size_class(reinterpret_cast<free_block*>(block_end));
+        --free_list_size_;
+        new_block_size = split_block(block_start, block_size + tag_size(next_tag), new_block_size);
+        grown = true;
+    }
+    // the block is at the top of the used region, and there is still room after it
+    else if (block_end == static_cast<u8*>(arena_) + offset_)
+    {
+        usize required_size = offset_ + new_block_size - block_size + num_tag_bytes;
+        if (required_size > size_)
+        {
+            size_ = grow(required_size);
+        }
+        if (required_size <= size_)
+        {
+            offset_ += new_block_size - block_size;
+            *reinterpret_cast<usize*>(block_start + new_block_size) = tag_allocated | tag_prev_allocated;
+            grown = true;
+        }
     }
 
-    header* hdr = static_cast<header*>(ptr) - 1u;
-    usize block_size = hdr->size;
-    NLRS_ASSERT(block_size >= sizeof(free_block));
-
-    u32* guard_ptr = (u32*)((u8*)(hdr)-hdr->offset - guard_byte);
-
-    NLRS_ASSERT(*guard_ptr == BEEFCAFE);
-    NLRS_ASSERT(*(guard_ptr + block_size / 4u - 1u) == BEEFCAFE);
-    mark_free_bytes(guard_ptr, block_size);
-
-    // the following algorithm adds the newly freed block into the free list
-    // it tries to merge adjacent free blocks into a larger block
-    uptr block_start = reinterpret_cast<uptr>(guard_ptr);
-    uptr block_end = block_start + block_size;
-    free_block* cur_block = free_list_head_;
-    free_block* prev_block = nullptr;
-    while (cur_block != nullptr)
-    {
-        if (reinterpret_cast<uptr>(cur_block) >= block_end)
+    if (grown)
+    {
+        usize* tag = reinterpret_cast<usize*>(block_start);
+        *tag = new_block_size | (*tag & tag_flags);
+        NLRS_ARENA_STATS_RECORD(stats_.on_resize(block_size, new_block_size));
+        NLRS_ARENA_STATS_RECORD(stats_.on_high_water(offset_ + num_tag_bytes));
+        if (P::guard_blocks)
         {
-            break;
+            (static_cast<header*>(ptr) - 1u)->size = new_block_size;
+            // move the trailing guard to the new end of the block
+            u32* guard_mem = reinterpret_cast<u32*>(block_start + new_block_size) - 1u;
+            *guard_mem = BEEFCAFE;
         }
-        prev_block = cur_block;
-        cur_block = cur_block->next;
+        if (P::fill_memory)
+        {
+            std::memset(static_cast<u8*>(ptr) + capacity, 0xa5, new_block_size - block_size);
+        }
+        return ptr;
     }
 
-    // free_list_head_ was null or free_list_head_ is beoynd the end of the block that 
-    // we're freeing
-    if (prev_block == nullptr)
+    void* new_ptr = allocate(newSize, alignment_of(ptr));
+    if (new_ptr)
     {
-        prev_block = reinterpret_cast<free_block*>(block_start);
-        prev_block->size = block_size;
-        prev_block->next = free_list_head_;
-        free_list_head_ = prev_block;
+        std::memcpy(new_ptr, ptr, capacity);
+        free(ptr);
+    }
+    return new_ptr;
+}
 
-        ++free_list_size_;
+template<typename P>
+usize basic_free_list_arena<P>::grow(usize)
+{
+    return size_;
+}
+
+template<typename P>
+usize basic_free_list_arena<P>::trim_top()
+{
+    // the sentinel tag tells whether the last block is free
+    u8* top = static_cast<u8*>(arena_) + offset_;
+    if (!(*reinterpret_cast<usize*>(top) & tag_prev_allocated))
+    {
+        usize last_size = *(reinterpret_cast<usize*>(top) - 1u);
+        remove_from_size_class(reinterpret_cast<free_block*>(top - last_size));
+        NLRS_ASSERT(free_list_size_ != 0u);
+        --free_list_size_;
+        offset_ -= last_size;
+        // free blocks are never adjacent, so the block before the last one is allocated
+        *reinterpret_cast<usize*>(top - last_size) = tag_allocated | tag_prev_allocated;
     }
-    // prev_block is adjacent to the block being freed
-    else if (reinterpret_cast<uptr>(prev_block) + prev_block->size == block_start)
+    return offset_;
+}
+
+template<typename P>
+void basic_free_list_arena<P>::shrink(usize size)
+{
+    NLRS_ASSERT(size >= offset_ + num_tag_bytes);
+    NLRS_ASSERT(size <= size_);
+    size_ = size;
+}
+
+template<typename P>
+void basic_free_list_arena<P>::free(void* ptr)
+{
+    if (!ptr)
     {
-        prev_block->size += block_size;
+        return;
     }
-    // insert a new block in between cur_block and prev_block
-    // set the new block as prev_block in preparation to check if the following
-    // block is adjacent to the new block
-    else
+
+    u8* block_start = block_start_of(ptr);
+    usize tag = *reinterpret_cast<usize*>(block_start);
+    usize block_size = tag_size(tag);
+    NLRS_ASSERT(block_size >= min_block_size);
+    NLRS_ASSERT(tag & tag_allocated);
+
+    if (P::guard_blocks)
+    {
+        header* hdr = static_cast<header*>(ptr) - 1u;
+        u32* guard_ptr = reinterpret_cast<u32*>(block_start + num_tag_bytes);
+        NLRS_ASSERT(*guard_ptr == BEEFCAFE);
+        NLRS_ASSERT(*(guard_ptr + (block_size - num_tag_bytes) / 4u - 1u) == BEEFCAFE);
+        NLRS_ASSERT(hdr->size == block_size);
+        (void)hdr;
+        (void)guard_ptr;
+    }
+    if (P::fill_memory)
     {
-        free_block* new_block = reinterpret_cast<free_block*>(block_start);
-        new_block->next = prev_block->next;
-        new_block->size = block_size;
-        prev_block->next = new_block;
-        prev_block = new_block;
+        std::memset(block_start, 0xee, block_size);
+    }
+    NLRS_ARENA_STATS_RECORD(stats_.on_free(block_size));
+
+    // the following algorithm adds the newly freed block into the free list
+    // the physical neighbours are found using the boundary tags, and merged if they are free
+    u8* block_end = block_start + block_size;
 
-        ++free_list_size_;
+    // the previous block is free, its size is stored in the word just before this block
+    if (!(tag & tag_prev_allocated))
+    {
+        usize prev_size = *(reinterpret_cast<usize*>(block_start) - 1u);
+        free_block* prev_block = reinterpret_cast<free_block*>(block_start - prev_size);
+        NLRS_ASSERT(tag_size(prev_block->tag) == prev_size);
+        remove_from_size_class(prev_block);
+        NLRS_ASSERT(free_list_size_ != 0u);
+        --free_list_size_;
+        block_start -= prev_size;
+        block_size += prev_size;
     }
 
-    // check if cur_block is adjacent to the previous block
-    // the previous block is either a merged block, or a new block
-    if (cur_block != nullptr && reinterpret_cast<uptr>(cur_block) == block_end)
+    // the next block is either a real block, or the sentinel at the top of the used region
+    usize* next_tag = reinterpret_cast<usize*>(block_end);
+    if (!(*next_tag & tag_allocated))
     {
-        // we merge cur_block into prev_block
-        prev_block->size += cur_block->size;
-        prev_block->next = cur_block->next;
+        usize next_size = tag_size(*next_tag);
+        remove_from_size_class(reinterpret_cast<free_block*>(block_end));
         NLRS_ASSERT(free_list_size_ != 0u);
         --free_list_size_;
+        block_size += next_size;
     }
+    else
+    {
+        *next_tag &= ~tag_prev_allocated;
+    }
+
+    // free blocks are never adjacent to each other, so the previous block is allocated
+    free_block* new_block = reinterpret_cast<free_block*>(block_start);
+    new_block->tag = block_size | tag_prev_allocated;
+    *reinterpret_cast<usize*>(block_start + block_size - num_tag_bytes) = block_size;
+    insert_into_size_class(new_block);
+    ++free_list_size_;
 
     NLRS_ASSERT(alloc_count_ > 0);
     --alloc_count_;
 }
 
+#ifdef NLRS_ARENA_STATS
+template<typename P>
+arena_stats basic_free_list_arena<P>::stats() const
+{
+    // the space above the sentinel tag can still be handed out
+    usize top_bytes = size_ - offset_ - num_tag_bytes;
+    usize free_bytes = top_bytes;
+    usize largest_free_block = top_bytes;
+    for (u32 size_class = 0u; size_class < num_size_classes; ++size_class)
+    {
+        for (const free_block* block = size_classes_[size_class]; block; block = block->next_in_class)
+        {
+            usize size = tag_size(block->tag);
+            free_bytes += size;
+            largest_free_block = std::max(largest_free_block, size);
+        }
+    }
+    return stats_.snapshot(free_bytes, largest_free_block);
+}
+#endif
+
+template class basic_free_list_arena<free_list_debug_policy>;
+template class basic_free_list_arena<free_list_release_policy>;
+
 }
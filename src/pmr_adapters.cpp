@@ -0,0 +1,141 @@
+#include "pmr_adapters.h"
+
+#ifdef NLRS_HAS_MEMORY_RESOURCE
+
+#include "nlrs_assert.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace nlrs
+{
+
+/***
+ *       ___                        __  ___                           ___
+ *      / _ | _______ ___  ___ _   /  |/  /__ __ _  ___  ______ __  / _ \___ ___ ___  __ _________ ___
+ *     / __ |/ __/ -_) _ \/ _ `/  / /|_/ / -_)  ' \/ _ \/ __/ // / / , _/ -_|_-</ _ \/ // / __/ __/ -_)
+ *    /_/ |_/_/  \__/_//_/\_,_/  /_/  /_/\__/_/_/_/\___/_/  \_, / /_/|_|\__/___/\___/\_,_/_/  \__/\__/
+ *                                                         /___/
+ */
+
+void* arena_memory_resource::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+    NLRS_ASSERT(alignment <= 128u);
+    // the arenas return nullptr for empty requests, but a resource must return a block
+    void* ptr = arena_.allocate(std::max(bytes, std::size_t(1u)), u8(alignment));
+    if (!ptr)
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void arena_memory_resource::do_deallocate(void* ptr, std::size_t bytes, std::size_t alignment)
+{
+    arena_.free(ptr, std::max(bytes, std::size_t(1u)), u8(alignment));
+}
+
+bool arena_memory_resource::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+    if (this == &other)
+    {
+        return true;
+    }
+    const arena_memory_resource* resource = dynamic_cast<const arena_memory_resource*>(&other);
+    return resource && &resource->arena_ == &arena_;
+}
+
+/***
+ *       __  ___                           ___                               ___
+ *      /  |/  /__ __ _  ___  ______ __  / _ \___ ___ ___  __ _________ ___  / _ | _______ ___  ___ _
+ *     / /|_/ / -_)  ' \/ _ \/ __/ // / / , _/ -_|_-</ _ \/ // / __/ __/ -_)/ __ |/ __/ -_) _ \/ _ `/
+ *    /_/  /_/\__/_/_/_/\___/_/  \_, / /_/|_|\__/___/\___/\_,_/_/  \__/\__//_/ |_/_/  \__/_//_/\_,_/
+ *                              /___/
+ */
+
+memory_resource_arena::memory_resource_arena(std::pmr::memory_resource* resource)
+    : resource_(resource),
+    alloc_count_(0u)
+{
+    NLRS_ASSERT(resource_);
+}
+
+memory_resource_arena::~memory_resource_arena()
+{
+    NLRS_ASSERT(alloc_count_ == 0u);
+}
+
+void* memory_resource_arena::allocate(usize bytes, u8 alignment)
+{
+    NLRS_ASSERT((alignment & (alignment - 1u)) == 0u);
+    if (bytes == 0u)
+    {
+        return nullptr;
+    }
+
+    const usize block_alignment = std::max(usize(alignment), alignof(block_header));
+    const usize offset = header_offset(alignment);
+    void* block = nullptr;
+    try
+    {
+        block = resource_->allocate(offset + bytes, block_alignment);
+    }
+    catch (const std::bad_alloc&)
+    {
+        return nullptr;
+    }
+
+    void* ptr = static_cast<u8*>(block) + offset;
+    *header_of(ptr) = block_header{ bytes, block_alignment };
+    alloc_count_.fetch_add(1u, std::memory_order_relaxed);
+    NLRS_ARENA_STATS_RECORD(stats_.on_allocate(bytes, offset + bytes));
+    return ptr;
+}
+
+void* memory_resource_arena::reallocate(void* ptr, usize new_size)
+{
+    NLRS_ASSERT(ptr);
+    NLRS_ASSERT(new_size != 0u);
+
+    const block_header header = *header_of(ptr);
+    if (new_size <= header.bytes)
+    {
+        return ptr;
+    }
+
+    void* new_ptr = allocate(new_size, u8(header.alignment));
+    if (new_ptr)
+    {
+        std::memcpy(new_ptr, ptr, header.bytes);
+        free(ptr);
+    }
+    return new_ptr;
+}
+
+void memory_resource_arena::free(void* ptr)
+{
+    if (!ptr)
+    {
+        return;
+    }
+
+    NLRS_ASSERT(alloc_count_ > 0u);
+    const block_header header = *header_of(ptr);
+    const usize offset = header_offset(header.alignment);
+    resource_->deallocate(static_cast<u8*>(ptr) - offset, offset + header.bytes, header.alignment);
+    alloc_count_.fetch_sub(1u, std::memory_order_relaxed);
+    NLRS_ARENA_STATS_RECORD(stats_.on_free(offset + header.bytes));
+}
+
+#ifdef NLRS_ARENA_STATS
+arena_stats memory_resource_arena::stats() const
+{
+    // the resource doesn't tell how much memory it has left
+    return stats_.snapshot(0u, 0u);
+}
+#endif
+
+}
+
+#endif
@@ -0,0 +1,66 @@
+#include "pool_arena.h"
+#include "nlrs_assert.h"
+
+namespace nlrs
+{
+
+/***
+ *       ___             __   ___
+ *      / _ \___  ___  / /  / _ | _______ ___  ___ _
+ *     / ___/ _ \/ _ \/ /  / __ |/ __/ -_) _ \/ _ `/
+ *    /_/   \___/\___/_/  /_/ |_/_/  \__/_//_/\_,_/
+ *
+ */
+
+pool_arena::pool_arena(void* memory, usize num_bytes, usize chunk_size, u8 chunk_alignment)
+    : begin_(nullptr),
+    top_(nullptr),
+    end_(nullptr),
+    chunk_size_(0u),
+    chunk_alignment_(chunk_alignment),
+    head_(nullptr),
+    alloc_count_(0u)
+{
+    NLRS_ASSERT(memory);
+    NLRS_ASSERT(chunk_size != 0u);
+    NLRS_ASSERT((chunk_alignment & (chunk_alignment - 1u)) == 0u);
+    NLRS_ASSERT(chunk_alignment >= alignof(free_chunk));
+
+    chunk_size = chunk_size < sizeof(free_chunk) ? sizeof(free_chunk) : chunk_size;
+    chunk_size_ = (chunk_size + chunk_alignment - 1u) & ~usize(chunk_alignment - 1u);
+
+    uptr start = reinterpret_cast<uptr>(memory);
+    uptr aligned = (start + chunk_alignment - 1u) & ~uptr(chunk_alignment - 1u);
+    usize usable = num_bytes > usize(aligned - start) ? num_bytes - usize(aligned - start) : 0u;
+
+    begin_ = reinterpret_cast<u8*>(aligned);
+    top_ = begin_;
+    end_ = begin_ + (usable / chunk_size_) * chunk_size_;
+}
+
+pool_arena::~pool_arena()
+{
+    NLRS_ASSERT(alloc_count_ == 0u);
+}
+
+void* pool_arena::reallocate(void* ptr, usize new_size)
+{
+    NLRS_ASSERT(ptr);
+    NLRS_ASSERT(new_size != 0u);
+    NLRS_ASSERT(owns(ptr));
+    return new_size <= chunk_size_ ? ptr : nullptr;
+}
+
+#ifdef NLRS_ARENA_STATS
+arena_stats pool_arena::stats() const
+{
+    usize free_chunks = usize(end_ - top_) / chunk_size_;
+    for (const free_chunk* chunk = head_; chunk; chunk = chunk->next)
+    {
+        ++free_chunks;
+    }
+    return stats_.snapshot(free_chunks * chunk_size_, free_chunks ? chunk_size_ : 0u);
+}
+#endif
+
+}
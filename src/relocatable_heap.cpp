@@ -0,0 +1,374 @@
+#include "relocatable_heap.h"
+#include "bit_math.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace nlrs
+{
+
+/***
+ *       ___      __             __       __   __      __ __
+ *      / _ \___ / /__  _______ _/ /____ _/ /  / /__   / // /__ ___ ____
+ *     / , _/ -_) / _ \/ __/ _ `/ __/ _ `/ _ \/ / -_) / _  / -_) _ `/ _ \
+ *    /_/|_|\__/_/\___/\__/\_,_/\__/\_,_/_.__/_/\__/ /_//_/\__/\_,_/ .__/
+ *                                                                /_/
+ */
+
+const relocatable_heap::handle relocatable_heap::invalid_handle{ 0u, 0u };
+const u32 relocatable_heap::free_index{ 0xffffffffu };
+const u32 relocatable_heap::prev_free_flag{ 1u };
+const usize relocatable_heap::block_alignment{ 16u };
+// room for the free list links and the size at the end of a free block
+const usize relocatable_heap::min_block_size{ 48u };
+const usize relocatable_heap::num_size_classes;
+
+// A handle entry's generation is odd while its block is live, and even while the entry is
+// free, so allocating and freeing the block each increment it.
+//
+// Free blocks are always merged with their free neighbours, so a free block is never next
+// to another free block, or to the top.
+
+relocatable_heap::relocatable_heap(void* memory, usize num_bytes, u32 max_handles)
+    : handles_(nullptr),
+    max_handles_(max_handles),
+    free_handle_(0u),
+    memory_(nullptr),
+    size_(0u),
+    top_(0u),
+    compacted_(0u),
+    resume_(0u),
+    free_classes_(0u),
+    free_lists_{ nullptr },
+    used_bytes_(0u),
+    alloc_count_(0u)
+{
+    NLRS_ASSERT(memory);
+    NLRS_ASSERT(max_handles > 0u && max_handles < free_index);
+
+    uptr start = reinterpret_cast<uptr>(memory);
+    uptr end = start + num_bytes;
+    uptr table_start = (start + alignof(handle_entry) - 1u) & ~uptr(alignof(handle_entry) - 1u);
+    uptr heap_start = table_start + max_handles * sizeof(handle_entry);
+    heap_start = (heap_start + block_alignment - 1u) & ~uptr(block_alignment - 1u);
+    NLRS_ASSERT(heap_start + min_block_size <= end);
+
+    handles_ = reinterpret_cast<handle_entry*>(table_start);
+    memory_ = reinterpret_cast<u8*>(heap_start);
+    size_ = usize(end - heap_start) & ~(block_alignment - 1u);
+
+    for (u32 i = 0u; i < max_handles; ++i)
+    {
+        handles_[i].offset = i + 1u < max_handles ? i + 1u : free_index;
+        handles_[i].generation = 0u;
+        handles_[i].pin_count = 0u;
+    }
+}
+
+relocatable_heap::~relocatable_heap()
+{
+    NLRS_ASSERT(alloc_count_ == 0u);
+}
+
+void relocatable_heap::set_prev_free(usize offset, bool prev_free)
+{
+    if (offset < top_)
+    {
+        block_header* header = header_at(offset);
+        header->flags = prev_free ? header->flags | prev_free_flag : header->flags & ~prev_free_flag;
+    }
+}
+
+void relocatable_heap::insert_free_block(usize offset, usize size)
+{
+    NLRS_ASSERT(size >= min_block_size);
+    free_block* block = reinterpret_cast<free_block*>(memory_ + offset);
+    block->header.size = size;
+    block->header.handle_index = free_index;
+    block->header.flags = 0u;
+    *reinterpret_cast<usize*>(memory_ + offset + size - sizeof(usize)) = size;
+
+    u32 size_class = find_last_set(size);
+    free_block* head = free_lists_[size_class];
+    block->prev = nullptr;
+    block->next = head;
+    if (head)
+    {
+        head->prev = block;
+    }
+    free_lists_[size_class] = block;
+    free_classes_ |= u64(1u) << size_class;
+
+    set_prev_free(offset + size, true);
+}
+
+void relocatable_heap::remove_free_block(usize offset)
+{
+    free_block* block = reinterpret_cast<free_block*>(memory_ + offset);
+    u32 size_class = find_last_set(block->header.size);
+    if (block->prev)
+    {
+        block->prev->next = block->next;
+    }
+    else
+    {
+        free_lists_[size_class] = block->next;
+        if (!block->next)
+        {
+            free_classes_ &= ~(u64(1u) << size_class);
+        }
+    }
+    if (block->next)
+    {
+        block->next->prev = block->prev;
+    }
+}
+
+relocatable_heap::handle relocatable_heap::allocate(usize bytes)
+{
+    if (bytes == 0u || bytes > size_ || free_handle_ == free_index)
+    {
+        return invalid_handle;
+    }
+
+    usize size = (bytes + sizeof(block_header) + block_alignment - 1u) & ~(block_alignment - 1u);
+    size = std::max(size, min_block_size);
+
+    // The first fit in the block's own size class, or else any block of a larger class, and
+    // then the untouched memory at the top.
+    u32 size_class = find_last_set(size);
+    free_block* block = free_lists_[size_class];
+    while (block && block->header.size < size)
+    {
+        block = block->next;
+    }
+    const u64 larger_classes = free_classes_ & ~((u64(2u) << size_class) - 1u);
+    if (!block && larger_classes)
+    {
+        block = free_lists_[find_first_set(larger_classes)];
+    }
+
+    usize offset = 0u;
+    if (block)
+    {
+        offset = usize(reinterpret_cast<u8*>(block) - memory_);
+        usize block_size = block->header.size;
+        remove_free_block(offset);
+        if (block_size - size >= min_block_size)
+        {
+            insert_free_block(offset + size, block_size - size);
+        }
+        else
+        {
+            size = block_size;
+            set_prev_free(offset + size, false);
+        }
+    }
+    else if (size <= size_ - top_)
+    {
+        offset = top_;
+        top_ += size;
+    }
+    else
+    {
+        return invalid_handle;
+    }
+
+    u32 index = free_handle_;
+    handle_entry& e = handles_[index];
+    free_handle_ = u32(e.offset);
+    e.offset = offset;
+    e.pin_count = 0u;
+    ++e.generation;
+
+    block_header* header = header_at(offset);
+    header->size = size;
+    header->handle_index = index;
+    header->flags = 0u;
+    used_bytes_ += size;
+    ++alloc_count_;
+
+    return handle{ index, e.generation };
+}
+
+void relocatable_heap::free(handle h)
+{
+    handle_entry& e = entry(h);
+    NLRS_ASSERT(e.pin_count == 0u);
+    NLRS_ASSERT(alloc_count_ > 0u);
+
+    usize offset = e.offset;
+    block_header* header = header_at(offset);
+    usize size = header->size;
+    bool prev_free = (header->flags & prev_free_flag) != 0u;
+    used_bytes_ -= size;
+    --alloc_count_;
+
+    ++e.generation;
+    e.offset = free_handle_;
+    free_handle_ = h.index;
+
+    // merge with the neighbours which are free, and with the top
+    usize next = offset + size;
+    if (next < top_ && header_at(next)->handle_index == free_index)
+    {
+        size += header_at(next)->size;
+        remove_free_block(next);
+    }
+    if (prev_free)
+    {
+        usize prev_size = *reinterpret_cast<usize*>(memory_ + offset - sizeof(usize));
+        offset -= prev_size;
+        size += prev_size;
+        remove_free_block(offset);
+    }
+    if (offset + size == top_)
+    {
+        top_ = offset;
+    }
+    else
+    {
+        insert_free_block(offset, size);
+    }
+    compacted_ = std::min(compacted_, offset);
+    // the block defragment was to resume from may have been merged into this one
+    if (resume_ > offset && resume_ <= offset + size)
+    {
+        resume_ = offset;
+    }
+}
+
+bool relocatable_heap::is_valid(handle h) const
+{
+    return (h.generation & 1u) && h.index < max_handles_ && handles_[h.index].generation == h.generation;
+}
+
+usize relocatable_heap::size(handle h) const
+{
+    return header_at(entry(h).offset)->size - sizeof(block_header);
+}
+
+void* relocatable_heap::pin(handle h)
+{
+    handle_entry& e = entry(h);
+    ++e.pin_count;
+    return memory_ + e.offset + sizeof(block_header);
+}
+
+void relocatable_heap::unpin(handle h)
+{
+    handle_entry& e = entry(h);
+    NLRS_ASSERT(e.pin_count > 0u);
+    --e.pin_count;
+}
+
+bool relocatable_heap::is_pinned(handle h) const
+{
+    return entry(h).pin_count > 0u;
+}
+
+usize relocatable_heap::defragment(usize budget_bytes)
+{
+    // Carry on past the blocks which the previous call couldn't compact, rather than scanning
+    // them again. A call which finds nothing to move from there starts over from the compacted
+    // blocks, since the pinned blocks holding the rest back may have been unpinned since.
+    usize start = std::max(compacted_, resume_);
+    usize moved = compact_from(start, budget_bytes);
+    if (moved == 0u && start != compacted_)
+    {
+        moved = compact_from(compacted_, budget_bytes);
+    }
+    return moved;
+}
+
+usize relocatable_heap::compact_from(usize cursor, usize budget_bytes)
+{
+    usize moved = 0u;
+    // whether every block below the cursor is live, which stops being true past a pinned block
+    bool compact = cursor == compacted_;
+
+    while (cursor < top_)
+    {
+        if (header_at(cursor)->handle_index != free_index)
+        {
+            cursor += header_at(cursor)->size;
+            if (compact)
+            {
+                compacted_ = cursor;
+            }
+            continue;
+        }
+
+        // Take the run of free blocks starting at the cursor out of the free list, and slide
+        // the live blocks behind it down, one at a time, until the gap hits a pinned block or
+        // the budget runs out.
+        usize gap_start = cursor;
+        usize gap_end = cursor;
+        while (true)
+        {
+            while (gap_end < top_ && header_at(gap_end)->handle_index == free_index)
+            {
+                usize size = header_at(gap_end)->size;
+                remove_free_block(gap_end);
+                gap_end += size;
+            }
+            if (gap_end == top_)
+            {
+                top_ = gap_start;
+                if (compact)
+                {
+                    compacted_ = top_;
+                }
+                resume_ = compacted_;
+                return moved;
+            }
+
+            block_header* header = header_at(gap_end);
+            handle_entry& e = handles_[header->handle_index];
+            usize size = header->size;
+            if (e.pin_count > 0u)
+            {
+                insert_free_block(gap_start, gap_end - gap_start);
+                compact = false;
+                cursor = gap_end + size;
+                break;
+            }
+            // the first block is moved whatever its size, so that every call makes progress
+            if (moved != 0u && moved + size > budget_bytes)
+            {
+                insert_free_block(gap_start, gap_end - gap_start);
+                resume_ = gap_start;
+                return moved;
+            }
+
+            std::memmove(memory_ + gap_start, header, size);
+            header_at(gap_start)->flags = 0u;
+            e.offset = gap_start;
+            moved += size;
+            gap_start += size;
+            gap_end += size;
+            if (compact)
+            {
+                compacted_ = gap_start;
+            }
+        }
+    }
+
+    resume_ = compacted_;
+    return moved;
+}
+
+usize relocatable_heap::largest_free_block() const
+{
+    usize largest = size_ - top_;
+    if (free_classes_)
+    {
+        for (const free_block* block = free_lists_[find_last_set(free_classes_)]; block; block = block->next)
+        {
+            largest = std::max(largest, block->header.size);
+        }
+    }
+    return largest > sizeof(block_header) ? largest - sizeof(block_header) : 0u;
+}
+
+}
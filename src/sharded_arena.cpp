@@ -0,0 +1,210 @@
+#include "sharded_arena.h"
+#include "nlrs_assert.h"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace nlrs
+{
+
+namespace
+{
+
+std::atomic<u32> next_thread_index{ 0u };
+
+// The index of the calling thread, in the order in which the threads first asked for it
+u32 thread_index()
+{
+    thread_local u32 index = next_thread_index.fetch_add(1u, std::memory_order_relaxed);
+    return index;
+}
+
+}
+
+/***
+ *       ______               __       __  ___
+ *      / __/ /  ___ _______/ /__ ___/ / / _ | _______ ___  ___ _
+ *     _\ \/ _ \/ _ `/ __/ _  / -_) _  / / __ |/ __/ -_) _ \/ _ `/
+ *    /___/_//_/\_,_/_/  \_,_/\__/\_,_/ /_/ |_/_/  \__/_//_/\_,_/
+ *
+ */
+
+const usize sharded_arena::max_shards;
+
+sharded_arena::shard::shard(void* memory, usize num_bytes)
+    : mutex(),
+    arena(memory, num_bytes),
+    remote_frees(nullptr)
+{}
+
+sharded_arena::sharded_arena(void* memory, usize num_bytes, usize num_shards)
+    : shards_(nullptr),
+    num_shards_(num_shards),
+    memory_(nullptr),
+    shard_bytes_(0u)
+{
+    NLRS_ASSERT(memory);
+    NLRS_ASSERT(num_shards > 0u && num_shards <= max_shards);
+
+    // the shards themselves are placed at the start of the memory
+    uptr start = reinterpret_cast<uptr>(memory);
+    uptr shards_start = (start + alignof(shard) - 1u) & ~uptr(alignof(shard) - 1u);
+    uptr memory_start = shards_start + num_shards * sizeof(shard);
+    NLRS_ASSERT(memory_start < start + num_bytes);
+
+    shards_ = reinterpret_cast<shard*>(shards_start);
+    memory_ = reinterpret_cast<u8*>(memory_start);
+    shard_bytes_ = ((start + num_bytes - memory_start) / num_shards) & ~usize(15u);
+    NLRS_ASSERT(shard_bytes_ > 0u);
+
+    for (usize i = 0u; i < num_shards_; ++i)
+    {
+        new (&shards_[i]) shard(memory_ + i * shard_bytes_, shard_bytes_);
+    }
+}
+
+sharded_arena::~sharded_arena()
+{
+    drain_remote_frees();
+    for (usize i = 0u; i < num_shards_; ++i)
+    {
+        shards_[i].~shard();
+    }
+}
+
+usize sharded_arena::home_shard() const
+{
+    return usize(thread_index()) % num_shards_;
+}
+
+usize sharded_arena::shard_of(const void* ptr) const
+{
+    const u8* p = static_cast<const u8*>(ptr);
+    NLRS_ASSERT(p >= memory_ && p < memory_ + num_shards_ * shard_bytes_);
+    return usize(p - memory_) / shard_bytes_;
+}
+
+void sharded_arena::drain(shard& s)
+{
+    remote_block* block = s.remote_frees.exchange(nullptr, std::memory_order_acquire);
+    while (block)
+    {
+        remote_block* next = block->next;
+        s.arena.free(block);
+        block = next;
+    }
+}
+
+void sharded_arena::push_remote(shard& s, void* ptr)
+{
+    remote_block* block = static_cast<remote_block*>(ptr);
+    block->next = s.remote_frees.load(std::memory_order_relaxed);
+    while (!s.remote_frees.compare_exchange_weak(block->next, block, std::memory_order_release, std::memory_order_relaxed))
+    {}
+}
+
+void sharded_arena::drain_remote_frees()
+{
+    for (usize i = 0u; i < num_shards_; ++i)
+    {
+        std::lock_guard<std::mutex> lock(shards_[i].mutex);
+        drain(shards_[i]);
+    }
+}
+
+void* sharded_arena::allocate(usize bytes, u8 alignment)
+{
+    shard& s = shards_[home_shard()];
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (s.remote_frees.load(std::memory_order_relaxed))
+    {
+        drain(s);
+    }
+    return s.arena.allocate(bytes, alignment);
+}
+
+void* sharded_arena::reallocate(void* ptr, usize new_size)
+{
+    NLRS_ASSERT(ptr);
+    NLRS_ASSERT(new_size != 0u);
+
+    usize home = home_shard();
+    usize owner = shard_of(ptr);
+    if (owner == home)
+    {
+        std::lock_guard<std::mutex> lock(shards_[home].mutex);
+        return shards_[home].arena.reallocate(ptr, new_size);
+    }
+
+    // The block belongs to another thread's shard, so it is moved to this one. The owner
+    // rewrites the block's tag when it frees or splits a neighbouring block, so the block's
+    // alignment and size, and the copy, are read under the owner's lock.
+    u8 alignment;
+    usize old_size;
+    {
+        std::lock_guard<std::mutex> lock(shards_[owner].mutex);
+        alignment = shards_[owner].arena.alignment(ptr);
+        old_size = shards_[owner].arena.usable_size(ptr);
+    }
+    void* new_ptr = allocate(new_size, alignment);
+    if (new_ptr)
+    {
+        {
+            std::lock_guard<std::mutex> lock(shards_[owner].mutex);
+            std::memcpy(new_ptr, ptr, std::min(old_size, new_size));
+        }
+        push_remote(shards_[owner], ptr);
+    }
+    return new_ptr;
+}
+
+void sharded_arena::free(void* ptr)
+{
+    if (!ptr)
+    {
+        return;
+    }
+
+    usize home = home_shard();
+    usize owner = shard_of(ptr);
+    if (owner == home)
+    {
+        std::lock_guard<std::mutex> lock(shards_[home].mutex);
+        shards_[home].arena.free(ptr);
+    }
+    else
+    {
+        push_remote(shards_[owner], ptr);
+    }
+}
+
+#ifdef NLRS_ARENA_STATS
+arena_stats sharded_arena::stats() const
+{
+    arena_stats total{};
+    for (usize i = 0u; i < num_shards_; ++i)
+    {
+        arena_stats s;
+        {
+            std::lock_guard<std::mutex> lock(shards_[i].mutex);
+            s = shards_[i].arena.stats();
+        }
+        total.num_allocations += s.num_allocations;
+        total.total_allocations += s.total_allocations;
+        total.bytes_in_use += s.bytes_in_use;
+        total.peak_bytes_in_use += s.peak_bytes_in_use;
+        total.high_water_mark += s.high_water_mark;
+        total.free_bytes += s.free_bytes;
+        total.largest_free_block = std::max(total.largest_free_block, s.largest_free_block);
+        for (usize b = 0u; b < arena_stats::num_size_buckets; ++b)
+        {
+            total.size_histogram[b] += s.size_histogram[b];
+            total.waste_histogram[b] += s.waste_histogram[b];
+        }
+    }
+    return total;
+}
+#endif
+
+}
@@ -0,0 +1,228 @@
+#include "small_object_arena.h"
+#include "nlrs_assert.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace nlrs
+{
+
+/***
+ *       ____           ____  ____  __     _         __  ___
+ *      / __/_ _  ___ _/ / / / __ \/ /    (_)__ ____/ /_/ _ | _______ ___  ___ _
+ *     _\ \/  ' \/ _ `/ / / / /_/ / _ \  / / -_) __/ __/ __ |/ __/ -_) _ \/ _ `/
+ *    /___/_/_/_/\_,_/_/_/  \____/_.__/_/ /\__/\__/\__/_/ |_/_/  \__/_//_/\_,_/
+ *                                   |___/
+ */
+
+const usize small_object_arena::class_granularity;
+const usize small_object_arena::max_class_size;
+const usize small_object_arena::num_size_classes;
+const usize small_object_arena::slab_size;
+const u8 small_object_arena::slab_alignment;
+const usize small_object_arena::slab_header_size;
+
+small_object_arena::small_object_arena(memory_arena& backing)
+    : backing_(backing),
+    classes_{},
+    slabs_(nullptr),
+    num_slabs_(0u),
+    alloc_count_(0u)
+#ifdef NLRS_ARENA_STATS
+    ,
+    stats_(),
+    free_bytes_(0u)
+#endif
+{
+    static_assert(sizeof(slab_header) <= slab_header_size, "the slab header must fit in front of the chunks");
+}
+
+small_object_arena::~small_object_arena()
+{
+    NLRS_ASSERT(alloc_count_ == 0u);
+    while (slabs_)
+    {
+        slab_header* next = slabs_->next;
+        backing_.free(slabs_, slab_size, slab_alignment);
+        slabs_ = next;
+    }
+}
+
+void* small_object_arena::allocate_small(u32 size_class)
+{
+    small_object_arena::size_class& sc = classes_[size_class];
+    const usize chunk_size = class_size(size_class);
+
+    void* ptr = sc.head;
+    if (sc.head)
+    {
+        sc.head = sc.head->next;
+    }
+    else
+    {
+        if (usize(sc.end - sc.top) < chunk_size)
+        {
+            void* memory = backing_.allocate(slab_size, slab_alignment);
+            if (!memory)
+            {
+                return nullptr;
+            }
+            slab_header* slab = static_cast<slab_header*>(memory);
+            slab->next = slabs_;
+            slab->size_class = size_class;
+            slabs_ = slab;
+            ++num_slabs_;
+
+            // the remainder of the previous slab is too small for a chunk, and stays unused
+            NLRS_ARENA_STATS_RECORD(free_bytes_ -= usize(sc.end - sc.top));
+            sc.top = static_cast<u8*>(memory) + slab_header_size;
+            sc.end = sc.top + ((slab_size - slab_header_size) / chunk_size) * chunk_size;
+            NLRS_ARENA_STATS_RECORD(free_bytes_ += usize(sc.end - sc.top));
+        }
+        ptr = sc.top;
+        sc.top += chunk_size;
+    }
+
+    ++alloc_count_;
+    NLRS_ARENA_STATS_RECORD(free_bytes_ -= chunk_size);
+    return ptr;
+}
+
+void small_object_arena::free_small(void* ptr, u32 size_class)
+{
+    NLRS_ASSERT(alloc_count_ > 0u);
+    free_chunk* chunk = static_cast<free_chunk*>(ptr);
+    chunk->next = classes_[size_class].head;
+    classes_[size_class].head = chunk;
+    --alloc_count_;
+    NLRS_ARENA_STATS_RECORD(free_bytes_ += class_size(size_class));
+    NLRS_ARENA_STATS_RECORD(stats_.on_free(class_size(size_class)));
+}
+
+small_object_arena::slab_header* small_object_arena::find_slab(void* ptr) const
+{
+    const u8* p = static_cast<const u8*>(ptr);
+    for (slab_header* slab = slabs_; slab; slab = slab->next)
+    {
+        const u8* start = reinterpret_cast<const u8*>(slab);
+        if (p >= start && p < start + slab_size)
+        {
+            return slab;
+        }
+    }
+    return nullptr;
+}
+
+void* small_object_arena::allocate(usize bytes, u8 alignment)
+{
+    NLRS_ASSERT((alignment & (alignment - 1u)) == 0u);
+    if (bytes == 0u)
+    {
+        return nullptr;
+    }
+
+    if (!is_small(bytes, alignment))
+    {
+        return backing_.allocate(bytes, alignment);
+    }
+
+    u32 size_class = size_class_of(bytes, alignment);
+    void* ptr = allocate_small(size_class);
+    if (ptr)
+    {
+        NLRS_ARENA_STATS_RECORD(stats_.on_allocate(bytes, class_size(size_class)));
+    }
+    return ptr;
+}
+
+void* small_object_arena::reallocate(void* ptr, usize new_size)
+{
+    NLRS_ASSERT(ptr);
+    NLRS_ASSERT(new_size != 0u);
+
+    slab_header* slab = find_slab(ptr);
+    if (!slab)
+    {
+        if (!is_small(new_size, 8u))
+        {
+            return backing_.reallocate(ptr, new_size);
+        }
+        // The block would be freed as a small block from now on, so it has to move. The
+        // backing arena's block is larger than the new size.
+        void* new_ptr = allocate(new_size);
+        if (new_ptr)
+        {
+            std::memcpy(new_ptr, ptr, new_size);
+            backing_.free(ptr);
+        }
+        return new_ptr;
+    }
+
+    const u32 old_class = slab->size_class;
+    if (is_small(new_size, 8u) && size_class_of(new_size, 8u) == old_class)
+    {
+        return ptr;
+    }
+
+    void* new_ptr = allocate(new_size);
+    if (new_ptr)
+    {
+        std::memcpy(new_ptr, ptr, std::min(class_size(old_class), new_size));
+        free_small(ptr, old_class);
+    }
+    return new_ptr;
+}
+
+void small_object_arena::free(void* ptr)
+{
+    if (!ptr)
+    {
+        return;
+    }
+
+    slab_header* slab = find_slab(ptr);
+    if (slab)
+    {
+        free_small(ptr, slab->size_class);
+    }
+    else
+    {
+        backing_.free(ptr);
+    }
+}
+
+void small_object_arena::free(void* ptr, usize bytes, u8 alignment)
+{
+    if (!ptr)
+    {
+        return;
+    }
+
+    if (!is_small(bytes, alignment))
+    {
+        backing_.free(ptr, bytes, alignment);
+        return;
+    }
+
+    u32 size_class = size_class_of(bytes, alignment);
+    NLRS_ASSERT(find_slab(ptr) && find_slab(ptr)->size_class == size_class);
+    free_small(ptr, size_class);
+}
+
+#ifdef NLRS_ARENA_STATS
+arena_stats small_object_arena::stats() const
+{
+    usize largest = 0u;
+    for (u32 i = 0u; i < num_size_classes; ++i)
+    {
+        const size_class& sc = classes_[i];
+        if (sc.head || usize(sc.end - sc.top) >= class_size(i))
+        {
+            largest = class_size(i);
+        }
+    }
+    return stats_.snapshot(free_bytes_, largest);
+}
+#endif
+
+}
@@ -0,0 +1,222 @@
+#include "stack_arena.h"
+#include "nlrs_assert.h"
+#include "bit_math.h"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+
+nlrs::uptr align_up(nlrs::uptr address, nlrs::usize alignment)
+{
+    NLRS_ASSERT((alignment & (alignment - 1u)) == 0u);
+    return (address + (alignment - 1u)) & ~nlrs::uptr(alignment - 1u);
+}
+
+nlrs::uptr align_down(nlrs::uptr address, nlrs::usize alignment)
+{
+    NLRS_ASSERT((alignment & (alignment - 1u)) == 0u);
+    return address & ~nlrs::uptr(alignment - 1u);
+}
+
+}
+
+namespace nlrs
+{
+
+/***
+ *       ______           __    ___   ____              __
+ *      / __/ /____ _____/ /__ / _ | / / /__  _______ _/ /____  ____
+ *     _\ \/ __/ _ `/ __/  '_// __ |/ / / _ \/ __/ _ `/ __/ _ \/ __/
+ *    /___/\__/\_,_/\__/_/\_\/_/ |_/_/_/\___/\__/\_,_/\__/\___/_/
+ *
+ */
+
+stack_arena::stack_arena(void* memory, usize num_bytes)
+    : arena_(static_cast<u8*>(memory)),
+    bottom_(0u),
+    top_(num_bytes),
+    size_(num_bytes),
+    top_end_(*this)
+{}
+
+void* stack_arena::allocate(usize bytes, u8 alignment)
+{
+    return allocate(end::bottom, bytes, alignment);
+}
+
+void* stack_arena::allocate(end e, usize bytes, u8 alignment)
+{
+    if (bytes == 0u)
+    {
+        return nullptr;
+    }
+
+#ifdef NLRS_ARENA_STATS
+    usize used_before = bytes_used();
+#endif
+
+    // the header must be aligned too
+    usize align = std::max(usize(alignment), alignof(header));
+    uptr base = reinterpret_cast<uptr>(arena_);
+    uptr ptr = 0u;
+
+    if (e == end::bottom)
+    {
+        ptr = align_up(base + bottom_ + sizeof(header), align);
+        if (ptr > base + top_ || bytes > base + top_ - ptr)
+        {
+            return nullptr;
+        }
+        header* hdr = header_of(reinterpret_cast<void*>(ptr));
+        hdr->prev_offset = bottom_;
+        hdr->size = bytes;
+        bottom_ = usize(ptr + bytes - base);
+    }
+    else
+    {
+        if (bytes + sizeof(header) > top_ - bottom_)
+        {
+            return nullptr;
+        }
+        ptr = align_down(base + top_ - bytes, align);
+        if (ptr < base + bottom_ + sizeof(header))
+        {
+            return nullptr;
+        }
+        header* hdr = header_of(reinterpret_cast<void*>(ptr));
+        hdr->prev_offset = top_;
+        hdr->size = bytes;
+        top_ = usize(ptr - sizeof(header) - base);
+    }
+
+    NLRS_ARENA_STATS_RECORD(stats_.on_allocate(bytes, bytes_used() - used_before));
+    return reinterpret_cast<void*>(ptr);
+}
+
+bool stack_arena::is_in_bottom_stack(void* ptr) const
+{
+    u8* p = static_cast<u8*>(ptr);
+    NLRS_ASSERT(p >= arena_ && p < arena_ + size_);
+    return p < arena_ + bottom_;
+}
+
+bool stack_arena::is_topmost(void* ptr) const
+{
+    const header* hdr = header_of(ptr);
+    if (is_in_bottom_stack(ptr))
+    {
+        return static_cast<u8*>(ptr) + hdr->size == arena_ + bottom_;
+    }
+    return reinterpret_cast<const u8*>(hdr) == arena_ + top_;
+}
+
+void* stack_arena::reallocate(void* ptr, usize new_size)
+{
+    NLRS_ASSERT(ptr);
+    NLRS_ASSERT(new_size != 0u);
+
+    header* hdr = header_of(ptr);
+    usize old_size = hdr->size;
+    bool bottom = is_in_bottom_stack(ptr);
+    if (!is_topmost(ptr))
+    {
+        // only the most recent allocation of a stack may grow
+        NLRS_ASSERT(new_size <= old_size);
+        return new_size <= old_size ? ptr : nullptr;
+    }
+
+#ifdef NLRS_ARENA_STATS
+    usize used_before = bytes_used();
+#endif
+    uptr base = reinterpret_cast<uptr>(arena_);
+
+    if (bottom)
+    {
+        // the allocation is simply extended towards the top stack
+        usize offset = usize(static_cast<u8*>(ptr) - arena_);
+        if (new_size > top_ - offset)
+        {
+            return nullptr;
+        }
+        hdr->size = new_size;
+        bottom_ = offset + new_size;
+        NLRS_ARENA_STATS_RECORD(stats_.on_resize(used_before, bytes_used()));
+        return ptr;
+    }
+
+    // The top stack grows downwards, so the allocation is moved down to make room at its
+    // end. The alignment of the original allocation isn't stored.
+    usize alignment = alignment_of_address(ptr);
+    usize prev_offset = hdr->prev_offset;
+    if (new_size + sizeof(header) > prev_offset - bottom_)
+    {
+        return nullptr;
+    }
+    uptr new_ptr = align_down(base + prev_offset - new_size, std::max(alignment, alignof(header)));
+    if (new_ptr < base + bottom_ + sizeof(header))
+    {
+        return nullptr;
+    }
+    std::memmove(reinterpret_cast<void*>(new_ptr), ptr, std::min(old_size, new_size));
+    header* new_hdr = header_of(reinterpret_cast<void*>(new_ptr));
+    new_hdr->prev_offset = prev_offset;
+    new_hdr->size = new_size;
+    top_ = usize(new_ptr - sizeof(header) - base);
+    NLRS_ARENA_STATS_RECORD(stats_.on_resize(used_before, bytes_used()));
+    return reinterpret_cast<void*>(new_ptr);
+}
+
+void stack_arena::free(void* ptr)
+{
+    if (!ptr)
+    {
+        return;
+    }
+
+    // allocations have to be freed in LIFO order
+    NLRS_ASSERT(is_topmost(ptr));
+
+    header* hdr = header_of(ptr);
+#ifdef NLRS_ARENA_STATS
+    usize used_before = bytes_used();
+#endif
+    if (is_in_bottom_stack(ptr))
+    {
+        bottom_ = hdr->prev_offset;
+    }
+    else
+    {
+        top_ = hdr->prev_offset;
+    }
+    NLRS_ARENA_STATS_RECORD(stats_.on_free(used_before - bytes_used()));
+}
+
+stack_arena::marker stack_arena::get_marker(end e) const
+{
+    return e == end::bottom ? bottom_ : top_;
+}
+
+void stack_arena::rewind(end e, marker m)
+{
+    if (e == end::bottom)
+    {
+        NLRS_ASSERT(m <= bottom_);
+        bottom_ = m;
+    }
+    else
+    {
+        NLRS_ASSERT(m >= top_ && m <= size_);
+        top_ = m;
+    }
+    NLRS_ARENA_STATS_RECORD(stats_.on_rewind(bytes_used()));
+}
+
+#ifdef NLRS_ARENA_STATS
+arena_stats stack_arena::stats() const
+{
+    return stats_.snapshot(bytes_free(), bytes_free());
+}
+#endif
+
+}
@@ -0,0 +1,360 @@
+#include "thread_cache_arena.h"
+#include "nlrs_assert.h"
+#include "bit_math.h"
+#include <algorithm>
+#include <cstring>
+
+namespace nlrs
+{
+namespace detail
+{
+
+struct magazine
+{
+    usize count;
+    void* blocks[thread_cache_arena::magazine_size];
+};
+
+struct thread_cache
+{
+    // null, if the arena has been destroyed
+    thread_cache_arena* owner;
+    // the caches of the same arena, guarded by the arena's lock
+    thread_cache*       next_in_arena;
+    thread_cache*       prev_in_arena;
+    // the caches of the same thread
+    thread_cache*       next_in_thread;
+    magazine            magazines[thread_cache_arena::num_size_classes];
+};
+
+// Owns the caches of one thread, and returns them to their arenas when the thread exits.
+struct thread_cache_list
+{
+    ~thread_cache_list()
+    {
+        while (head)
+        {
+            thread_cache* cache = head;
+            head = cache->next_in_thread;
+            if (cache->owner)
+            {
+                cache->owner->release_cache(cache);
+            }
+            delete cache;
+        }
+    }
+
+    thread_cache* head{ nullptr };
+};
+
+}
+
+namespace
+{
+
+thread_local detail::thread_cache_list thread_caches;
+
+// Every block is preceded by a header. Blocks from the size classes are always 16-byte
+// aligned, and the header of a direct allocation is padded to the requested alignment.
+struct block_header
+{
+    u32     size_class;
+    // the number of bytes from the start of the backing allocation to the user's memory
+    u32     offset;
+    // the number of usable bytes in the block
+    usize   size;
+};
+
+const u32 direct_class = ~0u;
+const usize class_alignment = 16u;
+
+static_assert(sizeof(block_header) == class_alignment, "the block header must not break the class alignment");
+
+block_header* header_of(void* ptr)
+{
+    return static_cast<block_header*>(ptr) - 1u;
+}
+
+usize class_size(u32 size_class)
+{
+    return thread_cache_arena::min_class_size << size_class;
+}
+
+u32 size_class_of(usize bytes)
+{
+    return find_last_set(next_power_of_two(std::max(bytes, thread_cache_arena::min_class_size))) -
+        find_last_set(thread_cache_arena::min_class_size);
+}
+
+bool is_small(usize bytes, u8 alignment)
+{
+    return bytes <= thread_cache_arena::max_class_size && alignment <= class_alignment;
+}
+
+// The arena's lock must be held.
+void free_cached_blocks(memory_arena& backing, detail::thread_cache& cache)
+{
+    for (u32 size_class = 0u; size_class < thread_cache_arena::num_size_classes; ++size_class)
+    {
+        detail::magazine& mag = cache.magazines[size_class];
+        for (usize i = 0u; i < mag.count; ++i)
+        {
+            backing.free(header_of(mag.blocks[i]), class_size(size_class) + sizeof(block_header), u8(class_alignment));
+        }
+        mag.count = 0u;
+    }
+}
+
+}
+
+/***
+ *     ________                 _______           __        ___
+ *    /_  __/ /  _______ ___ __/ / ___/__ _______/ /  ___  / _ | _______ ___  ___ _
+ *     / / / _ \/ __/ -_) _ `/ _  / /__/ _ `/ __/ _ \/ -_)/ __ |/ __/ -_) _ \/ _ `/
+ *    /_/ /_//_/_/  \__/\_,_/\_,_/\___/\_,_/\__/_//_/\__//_/ |_/_/  \__/_//_/\_,_/
+ *
+ */
+
+const usize thread_cache_arena::min_class_size;
+const usize thread_cache_arena::num_size_classes;
+const usize thread_cache_arena::max_class_size;
+const usize thread_cache_arena::magazine_size;
+const usize thread_cache_arena::batch_size;
+
+thread_cache_arena::thread_cache_arena(memory_arena& backing)
+    : backing_(backing),
+    mutex_(),
+    caches_(nullptr)
+{}
+
+thread_cache_arena::~thread_cache_arena()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (detail::thread_cache* cache = caches_; cache; cache = cache->next_in_arena)
+    {
+        free_cached_blocks(backing_, *cache);
+        cache->owner = nullptr;
+    }
+}
+
+detail::thread_cache* thread_cache_arena::get_thread_cache()
+{
+    for (detail::thread_cache* cache = thread_caches.head; cache; cache = cache->next_in_thread)
+    {
+        if (cache->owner == this)
+        {
+            return cache;
+        }
+    }
+
+    detail::thread_cache* cache = new detail::thread_cache();
+    cache->owner = this;
+    cache->prev_in_arena = nullptr;
+    cache->next_in_thread = thread_caches.head;
+    thread_caches.head = cache;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    cache->next_in_arena = caches_;
+    if (caches_)
+    {
+        caches_->prev_in_arena = cache;
+    }
+    caches_ = cache;
+
+    return cache;
+}
+
+void thread_cache_arena::refill(detail::thread_cache& cache, u32 size_class)
+{
+    detail::magazine& mag = cache.magazines[size_class];
+    usize bytes = class_size(size_class) + sizeof(block_header);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (mag.count < batch_size)
+    {
+        block_header* hdr = static_cast<block_header*>(backing_.allocate(bytes, u8(class_alignment)));
+        if (!hdr)
+        {
+            break;
+        }
+        hdr->size_class = size_class;
+        hdr->offset = u32(sizeof(block_header));
+        hdr->size = class_size(size_class);
+        mag.blocks[mag.count++] = hdr + 1u;
+    }
+}
+
+void thread_cache_arena::flush(detail::thread_cache& cache, u32 size_class, usize count)
+{
+    detail::magazine& mag = cache.magazines[size_class];
+    NLRS_ASSERT(count <= mag.count);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (usize i = 0u; i < count; ++i)
+    {
+        backing_.free(header_of(mag.blocks[--mag.count]), class_size(size_class) + sizeof(block_header), u8(class_alignment));
+    }
+}
+
+void thread_cache_arena::release_cache(detail::thread_cache* cache)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_cached_blocks(backing_, *cache);
+
+    if (cache->prev_in_arena)
+    {
+        cache->prev_in_arena->next_in_arena = cache->next_in_arena;
+    }
+    else
+    {
+        caches_ = cache->next_in_arena;
+    }
+    if (cache->next_in_arena)
+    {
+        cache->next_in_arena->prev_in_arena = cache->prev_in_arena;
+    }
+    cache->owner = nullptr;
+}
+
+void thread_cache_arena::flush_thread_cache()
+{
+    detail::thread_cache* cache = get_thread_cache();
+    std::lock_guard<std::mutex> lock(mutex_);
+    free_cached_blocks(backing_, *cache);
+}
+
+void* thread_cache_arena::allocate(usize bytes, u8 alignment)
+{
+    NLRS_ASSERT((alignment & (alignment - 1u)) == 0u);
+    if (bytes == 0u)
+    {
+        return nullptr;
+    }
+
+    if (is_small(bytes, alignment))
+    {
+        u32 size_class = size_class_of(bytes);
+        detail::thread_cache* cache = get_thread_cache();
+        detail::magazine& mag = cache->magazines[size_class];
+        if (mag.count == 0u)
+        {
+            refill(*cache, size_class);
+            if (mag.count == 0u)
+            {
+                return nullptr;
+            }
+        }
+        NLRS_ARENA_STATS_RECORD(stats_.on_allocate(bytes, class_size(size_class) + sizeof(block_header)));
+        return mag.blocks[--mag.count];
+    }
+
+    // the header is padded so that the user's memory has the requested alignment
+    usize offset = std::max(usize(alignment), sizeof(block_header));
+    u8* memory = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        memory = static_cast<u8*>(backing_.allocate(bytes + offset, alignment));
+    }
+    if (!memory)
+    {
+        return nullptr;
+    }
+    block_header* hdr = header_of(memory + offset);
+    hdr->size_class = direct_class;
+    hdr->offset = u32(offset);
+    hdr->size = bytes;
+    NLRS_ARENA_STATS_RECORD(stats_.on_allocate(bytes, bytes + offset));
+    return memory + offset;
+}
+
+void* thread_cache_arena::reallocate(void* ptr, usize new_size)
+{
+    NLRS_ASSERT(ptr);
+    NLRS_ASSERT(new_size != 0u);
+
+    // A sized free must find the block in the size class of its latest size. Direct
+    // allocations stay direct as long as they are large or over-aligned.
+    block_header* hdr = header_of(ptr);
+    if (hdr->size_class == direct_class)
+    {
+        bool over_aligned = hdr->offset > class_alignment;
+        if (new_size <= hdr->size && (new_size > max_class_size || over_aligned))
+        {
+            return ptr;
+        }
+    }
+    else if (new_size <= max_class_size && size_class_of(new_size) == hdr->size_class)
+    {
+        return ptr;
+    }
+
+    // the offset of a direct allocation is at least the original alignment
+    u8 alignment = u8(std::min(usize(hdr->offset), usize(128u)));
+    void* new_ptr = allocate(new_size, alignment);
+    if (new_ptr)
+    {
+        std::memcpy(new_ptr, ptr, std::min(hdr->size, new_size));
+        free(ptr);
+    }
+    return new_ptr;
+}
+
+void thread_cache_arena::free(void* ptr)
+{
+    if (!ptr)
+    {
+        return;
+    }
+
+    block_header* hdr = header_of(ptr);
+    NLRS_ARENA_STATS_RECORD(stats_.on_free(hdr->size + (hdr->size_class == direct_class ? hdr->offset : sizeof(block_header))));
+    if (hdr->size_class == direct_class)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        backing_.free(static_cast<u8*>(ptr) - hdr->offset);
+        return;
+    }
+
+    cache_block(ptr, hdr->size_class);
+}
+
+void thread_cache_arena::free(void* ptr, usize bytes, u8 alignment)
+{
+    if (!ptr || !is_small(bytes, alignment))
+    {
+        // direct allocations need their header to find the start of the backing allocation
+        free(ptr);
+        return;
+    }
+
+    u32 size_class = size_class_of(bytes);
+    NLRS_ASSERT(header_of(ptr)->size_class == size_class);
+    NLRS_ARENA_STATS_RECORD(stats_.on_free(class_size(size_class) + sizeof(block_header)));
+    cache_block(ptr, size_class);
+}
+
+void thread_cache_arena::cache_block(void* ptr, u32 size_class)
+{
+    NLRS_ASSERT(size_class < num_size_classes);
+    detail::thread_cache* cache = get_thread_cache();
+    detail::magazine& mag = cache->magazines[size_class];
+    if (mag.count == magazine_size)
+    {
+        flush(*cache, size_class, batch_size);
+    }
+    mag.blocks[mag.count++] = ptr;
+}
+
+#ifdef NLRS_ARENA_STATS
+arena_stats thread_cache_arena::stats() const
+{
+    arena_stats backing_stats;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        backing_stats = backing_.stats();
+    }
+    return stats_.snapshot(backing_stats.free_bytes, backing_stats.largest_free_block);
+}
+#endif
+
+}
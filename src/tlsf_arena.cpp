@@ -0,0 +1,498 @@
+#include "tlsf_arena.h"
+#include "nlrs_assert.h"
+#include "bit_math.h"
+#include <algorithm>
+#include <cstring>
+
+namespace nlrs
+{
+
+// The prev_phys_block field is stored in the last word of the previous block, and is only
+// valid if the previous block is free. The next_free and prev_free fields are only valid
+// if this block is free, and overlap with the start of the user's memory otherwise.
+struct tlsf_arena::block_header
+{
+    block_header*   prev_phys_block;
+    // the size of the usable memory in the block, with the flags in the lowest bits
+    usize           size;
+    block_header*   next_free;
+    block_header*   prev_free;
+
+    const static usize free_bit{ 1u };
+    const static usize prev_free_bit{ 2u };
+
+    // only the size field is overhead, prev_phys_block belongs to the previous block
+    const static usize overhead{ sizeof(usize) };
+    // the user's memory starts right after the size field
+    const static usize start_offset{ sizeof(block_header*) + sizeof(usize) };
+    // a free block must have room for the free list pointers and the next block's
+    // prev_phys_block field
+    const static usize size_min{ sizeof(block_header*) * 3u };
+
+    usize block_size() const { return size & ~(free_bit | prev_free_bit); }
+    void set_size(usize s) { size = s | (size & (free_bit | prev_free_bit)); }
+    bool is_last() const { return block_size() == 0u; }
+
+    bool is_free() const { return (size & free_bit) != 0u; }
+    void set_free() { size |= free_bit; }
+    void set_used() { size &= ~free_bit; }
+
+    bool is_prev_free() const { return (size & prev_free_bit) != 0u; }
+    void set_prev_free() { size |= prev_free_bit; }
+    void set_prev_used() { size &= ~prev_free_bit; }
+
+    void* to_ptr() { return reinterpret_cast<u8*>(this) + start_offset; }
+
+    static block_header* from_ptr(void* ptr)
+    {
+        return reinterpret_cast<block_header*>(static_cast<u8*>(ptr) - start_offset);
+    }
+
+    block_header* next()
+    {
+        NLRS_ASSERT(!is_last());
+        return reinterpret_cast<block_header*>(static_cast<u8*>(to_ptr()) + block_size() - overhead);
+    }
+
+    block_header* link_next()
+    {
+        block_header* n = next();
+        n->prev_phys_block = this;
+        return n;
+    }
+
+    void mark_as_free()
+    {
+        block_header* n = link_next();
+        n->set_prev_free();
+        set_free();
+    }
+
+    void mark_as_used()
+    {
+        next()->set_prev_used();
+        set_used();
+    }
+
+    bool can_split(usize s) const
+    {
+        return block_size() >= sizeof(block_header) + s;
+    }
+
+    // Splits the block so that it has the given size, and returns the rest as a new free block.
+    block_header* split(usize s)
+    {
+        block_header* remaining = reinterpret_cast<block_header*>(static_cast<u8*>(to_ptr()) + s - overhead);
+        usize remaining_size = block_size() - (s + overhead);
+        NLRS_ASSERT(remaining_size >= size_min);
+        remaining->size = remaining_size;
+        set_size(s);
+        remaining->mark_as_free();
+        return remaining;
+    }
+
+    // Merges the following block into this one.
+    block_header* absorb(block_header* block)
+    {
+        NLRS_ASSERT(!is_last());
+        size += block->block_size() + overhead;
+        link_next();
+        return this;
+    }
+};
+
+namespace
+{
+
+usize align_up(usize x, usize alignment)
+{
+    NLRS_ASSERT((alignment & (alignment - 1u)) == 0u);
+    return (x + (alignment - 1u)) & ~(alignment - 1u);
+}
+
+usize align_down(usize x, usize alignment)
+{
+    NLRS_ASSERT((alignment & (alignment - 1u)) == 0u);
+    return x - (x & (alignment - 1u));
+}
+
+u8* align_ptr(u8* ptr, usize alignment)
+{
+    return reinterpret_cast<u8*>(align_up(reinterpret_cast<uptr>(ptr), alignment));
+}
+
+}
+
+/***
+ *      ________   ______  ___   ____              __
+ *     /_  __/ /  / __/ / / _ | / / /__  _______ _/ /____  ____
+ *      / / / /___\ \/ _/ / __ |/ / / _ \/ __/ _ `/ __/ _ \/ __/
+ *     /_/ /____/___/_/  /_/ |_/_/_/\___/\__/\_,_/\__/\___/_/
+ *
+ */
+
+namespace
+{
+
+// Rounds the requested size up to the block granularity. Returns 0 if the request is
+// too large to be served.
+usize adjust_request_size(usize size, usize alignment, usize max_size)
+{
+    if (size == 0u)
+    {
+        return 0u;
+    }
+    usize aligned = align_up(size, alignment);
+    if (aligned >= max_size)
+    {
+        return 0u;
+    }
+    return std::max(aligned, usize(sizeof(usize) * 3u));
+}
+
+}
+
+tlsf_arena::tlsf_arena(void* memory, usize num_bytes)
+    : alloc_count_(0),
+    fl_bitmap_(0u),
+    sl_bitmap_{ 0u },
+    blocks_{ { nullptr } }
+{
+    NLRS_ASSERT(reinterpret_cast<uptr>(memory) % align_size == 0u);
+
+    // the pool consists of one large free block, followed by a zero-sized sentinel block
+    usize pool_bytes = align_down(num_bytes - 2u * block_header::overhead, align_size);
+    NLRS_ASSERT(pool_bytes >= block_header::size_min);
+    NLRS_ASSERT(pool_bytes < (usize(1u) << fl_index_max));
+
+    // the first block's prev_phys_block field lies before the pool, but it is never
+    // accessed, because the previous block is marked as used
+    block_header* block = reinterpret_cast<block_header*>(static_cast<u8*>(memory) - block_header::overhead);
+    block->size = pool_bytes;
+    block->set_free();
+    block->set_prev_used();
+    insert_free_block(block);
+
+    block_header* sentinel = block->link_next();
+    sentinel->size = 0u;
+    sentinel->set_used();
+    sentinel->set_prev_free();
+}
+
+tlsf_arena::~tlsf_arena()
+{
+    NLRS_ASSERT(alloc_count_ == 0);
+}
+
+namespace
+{
+
+void mapping_insert(usize size, u32& fl, u32& sl, u32 sl_count_log2, u32 fl_shift, usize small_size)
+{
+    if (size < small_size)
+    {
+        // small blocks are stored in the first list, which is subdivided linearly
+        fl = 0u;
+        sl = u32(size / (small_size >> sl_count_log2));
+    }
+    else
+    {
+        fl = find_last_set(size);
+        sl = u32(size >> (fl - sl_count_log2)) ^ (1u << sl_count_log2);
+        fl -= (fl_shift - 1u);
+    }
+}
+
+}
+
+void tlsf_arena::insert_free_block(block_header* block)
+{
+    u32 fl, sl;
+    mapping_insert(block->block_size(), fl, sl, sl_index_count_log2, fl_index_shift, small_block_size);
+
+    block_header* current = blocks_[fl][sl];
+    block->next_free = current;
+    block->prev_free = nullptr;
+    if (current)
+    {
+        current->prev_free = block;
+    }
+    blocks_[fl][sl] = block;
+    fl_bitmap_ |= 1u << fl;
+    sl_bitmap_[fl] |= 1u << sl;
+}
+
+void tlsf_arena::remove_free_block(block_header* block)
+{
+    u32 fl, sl;
+    mapping_insert(block->block_size(), fl, sl, sl_index_count_log2, fl_index_shift, small_block_size);
+
+    if (block->prev_free)
+    {
+        block->prev_free->next_free = block->next_free;
+    }
+    else
+    {
+        blocks_[fl][sl] = block->next_free;
+        if (!block->next_free)
+        {
+            sl_bitmap_[fl] &= ~(1u << sl);
+            if (!sl_bitmap_[fl])
+            {
+                fl_bitmap_ &= ~(1u << fl);
+            }
+        }
+    }
+    if (block->next_free)
+    {
+        block->next_free->prev_free = block->prev_free;
+    }
+}
+
+tlsf_arena::block_header* tlsf_arena::locate_free_block(usize size)
+{
+    if (!size)
+    {
+        return nullptr;
+    }
+
+    const usize requested = size;
+    // round the size up to the next list, so that any block in the list found is large enough
+    if (size >= small_block_size)
+    {
+        usize round = (usize(1u) << (find_last_set(size) - sl_index_count_log2)) - 1u;
+        size += round;
+    }
+
+    u32 fl, sl;
+    mapping_insert(size, fl, sl, sl_index_count_log2, fl_index_shift, small_block_size);
+    if (fl >= fl_index_count)
+    {
+        return nullptr;
+    }
+
+    // first search for a non-empty list in the same first-level range, then in the
+    // larger first-level ranges
+    u32 sl_map = sl_bitmap_[fl] & (~0u << sl);
+    if (!sl_map)
+    {
+        u32 fl_map = fl + 1u < 32u ? fl_bitmap_ & (~0u << (fl + 1u)) : 0u;
+        if (!fl_map)
+        {
+            return nullptr;
+        }
+        fl = find_first_set(fl_map);
+        sl_map = sl_bitmap_[fl];
+    }
+    sl = find_first_set(sl_map);
+
+    block_header* block = blocks_[fl][sl];
+    NLRS_ASSERT(block && block->block_size() >= requested);
+    (void)requested;
+    remove_free_block(block);
+    return block;
+}
+
+tlsf_arena::block_header* tlsf_arena::merge_prev(block_header* block)
+{
+    if (block->is_prev_free())
+    {
+        block_header* prev = block->prev_phys_block;
+        NLRS_ASSERT(prev->is_free());
+        remove_free_block(prev);
+        block = prev->absorb(block);
+    }
+    return block;
+}
+
+tlsf_arena::block_header* tlsf_arena::merge_next(block_header* block)
+{
+    block_header* next = block->next();
+    if (next->is_free())
+    {
+        NLRS_ASSERT(!block->is_last());
+        remove_free_block(next);
+        block = block->absorb(next);
+    }
+    return block;
+}
+
+tlsf_arena::block_header* tlsf_arena::trim_free_leading(block_header* block, usize size)
+{
+    block_header* remaining = block;
+    if (block->can_split(size))
+    {
+        // the leading part is returned to the free lists
+        remaining = block->split(size - block_header::overhead);
+        remaining->set_prev_free();
+        block->link_next();
+        insert_free_block(block);
+    }
+    return remaining;
+}
+
+void tlsf_arena::trim_free(block_header* block, usize size)
+{
+    NLRS_ASSERT(block->is_free());
+    if (block->can_split(size))
+    {
+        block_header* remaining = block->split(size);
+        block->link_next();
+        remaining->set_prev_free();
+        insert_free_block(remaining);
+    }
+}
+
+void tlsf_arena::trim_used(block_header* block, usize size)
+{
+    NLRS_ASSERT(!block->is_free());
+    if (block->can_split(size))
+    {
+        block_header* remaining = block->split(size);
+        remaining->set_prev_used();
+        remaining = merge_next(remaining);
+        insert_free_block(remaining);
+    }
+}
+
+void* tlsf_arena::prepare_used(block_header* block, usize size, usize requested_bytes)
+{
+    if (!block)
+    {
+        return nullptr;
+    }
+    trim_free(block, size);
+    block->mark_as_used();
+    ++alloc_count_;
+    NLRS_ARENA_STATS_RECORD(stats_.on_allocate(requested_bytes, block->block_size() + block_header::overhead));
+    (void)requested_bytes;
+    return block->to_ptr();
+}
+
+void* tlsf_arena::allocate(usize bytes, u8 alignment)
+{
+    NLRS_ASSERT((alignment & (alignment - 1u)) == 0u);
+    const usize max_size = usize(1u) << fl_index_max;
+
+    usize adjusted = adjust_request_size(bytes, align_size, max_size);
+    if (!adjusted)
+    {
+        return nullptr;
+    }
+
+    if (alignment <= align_size)
+    {
+        return prepare_used(locate_free_block(adjusted), adjusted, bytes);
+    }
+
+    // For larger alignments, search for a block large enough to hold the aligned memory,
+    // and a leading gap large enough to be split off as a free block of its own.
+    const usize gap_minimum = sizeof(block_header);
+    usize size_with_gap = adjust_request_size(adjusted + alignment + gap_minimum, alignment, max_size);
+    block_header* block = locate_free_block(size_with_gap);
+    if (!block)
+    {
+        return nullptr;
+    }
+
+    u8* ptr = static_cast<u8*>(block->to_ptr());
+    u8* aligned = align_ptr(ptr, alignment);
+    usize gap = usize(aligned - ptr);
+    if (gap && gap < gap_minimum)
+    {
+        usize gap_remain = gap_minimum - gap;
+        usize offset = std::max(gap_remain, usize(alignment));
+        aligned = align_ptr(aligned + offset, alignment);
+        gap = usize(aligned - ptr);
+    }
+    if (gap)
+    {
+        NLRS_ASSERT(gap >= gap_minimum);
+        block = trim_free_leading(block, gap);
+    }
+
+    return prepare_used(block, adjusted, bytes);
+}
+
+void* tlsf_arena::reallocate(void* ptr, usize new_size)
+{
+    NLRS_ASSERT(ptr);
+    NLRS_ASSERT(new_size != 0u);
+
+    block_header* block = block_header::from_ptr(ptr);
+    NLRS_ASSERT(!block->is_free());
+
+    usize current_size = block->block_size();
+    usize adjusted = adjust_request_size(new_size, align_size, usize(1u) << fl_index_max);
+    if (adjusted <= current_size)
+    {
+        return ptr;
+    }
+
+    // grow into the next block if it is free and large enough
+    block_header* next = block->next();
+    usize combined = current_size + next->block_size() + block_header::overhead;
+    if (next->is_free() && adjusted <= combined)
+    {
+        merge_next(block);
+        block->mark_as_used();
+        trim_used(block, adjusted);
+        NLRS_ARENA_STATS_RECORD(stats_.on_resize(current_size, block->block_size()));
+        return ptr;
+    }
+
+    // the alignment of the original allocation isn't stored
+    void* new_ptr = allocate(new_size, alignment_of_address(ptr));
+    if (new_ptr)
+    {
+        std::memcpy(new_ptr, ptr, current_size);
+        free(ptr);
+    }
+    return new_ptr;
+}
+
+void tlsf_arena::free(void* ptr)
+{
+    if (!ptr)
+    {
+        return;
+    }
+
+    block_header* block = block_header::from_ptr(ptr);
+    NLRS_ASSERT(!block->is_free());
+    NLRS_ARENA_STATS_RECORD(stats_.on_free(block->block_size() + block_header::overhead));
+    block->mark_as_free();
+    block = merge_prev(block);
+    block = merge_next(block);
+    insert_free_block(block);
+
+    NLRS_ASSERT(alloc_count_ > 0);
+    --alloc_count_;
+}
+
+usize tlsf_arena::block_size(void* ptr) const
+{
+    return block_header::from_ptr(ptr)->block_size();
+}
+
+#ifdef NLRS_ARENA_STATS
+arena_stats tlsf_arena::stats() const
+{
+    usize free_bytes = 0u;
+    usize largest_free_block = 0u;
+    for (u32 fl = 0u; fl < fl_index_count; ++fl)
+    {
+        for (u32 sl = 0u; sl < sl_index_count; ++sl)
+        {
+            for (const block_header* block = blocks_[fl][sl]; block; block = block->next_free)
+            {
+                free_bytes += block->block_size();
+                largest_free_block = std::max(largest_free_block, block->block_size());
+            }
+        }
+    }
+    return stats_.snapshot(free_bytes, largest_free_block);
+}
+#endif
+
+}
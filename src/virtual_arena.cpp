@@ -0,0 +1,178 @@
+#include "virtual_arena.h"
+#include "configuration.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+#if NLRS_PLATFORM == NLRS_POSIX
+#include <sys/mman.h>
+#include <unistd.h>
+#elif NLRS_PLATFORM == NLRS_WIN32
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+namespace
+{
+
+nlrs::usize page_size()
+{
+#if NLRS_PLATFORM == NLRS_POSIX
+    return nlrs::usize(sysconf(_SC_PAGESIZE));
+#elif NLRS_PLATFORM == NLRS_WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return nlrs::usize(info.dwPageSize);
+#else
+    return 4096u;
+#endif
+}
+
+nlrs::usize round_up(nlrs::usize n, nlrs::usize multiple)
+{
+    return ((n + multiple - 1u) / multiple) * multiple;
+}
+
+void* reserve_pages(nlrs::usize bytes)
+{
+#if NLRS_PLATFORM == NLRS_POSIX
+    void* memory = mmap(nullptr, bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    return memory == MAP_FAILED ? nullptr : memory;
+#elif NLRS_PLATFORM == NLRS_WIN32
+    return VirtualAlloc(nullptr, bytes, MEM_RESERVE, PAGE_NOACCESS);
+#else
+    // no virtual memory API, so the arena can't reserve its range
+    (void)bytes;
+    return nullptr;
+#endif
+}
+
+bool commit_pages(void* memory, nlrs::usize bytes)
+{
+#if NLRS_PLATFORM == NLRS_POSIX
+    return mprotect(memory, bytes, PROT_READ | PROT_WRITE) == 0;
+#elif NLRS_PLATFORM == NLRS_WIN32
+    return VirtualAlloc(memory, bytes, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+#else
+    (void)memory;
+    (void)bytes;
+    return false;
+#endif
+}
+
+void decommit_pages(void* memory, nlrs::usize bytes)
+{
+#if NLRS_PLATFORM == NLRS_POSIX
+    // MADV_DONTNEED drops the physical pages, and mprotect makes the range inaccessible again
+    madvise(memory, bytes, MADV_DONTNEED);
+    mprotect(memory, bytes, PROT_NONE);
+#elif NLRS_PLATFORM == NLRS_WIN32
+    VirtualFree(memory, bytes, MEM_DECOMMIT);
+#else
+    (void)memory;
+    (void)bytes;
+#endif
+}
+
+void release_pages(void* memory, nlrs::usize bytes)
+{
+#if NLRS_PLATFORM == NLRS_POSIX
+    munmap(memory, bytes);
+#elif NLRS_PLATFORM == NLRS_WIN32
+    VirtualFree(memory, 0, MEM_RELEASE);
+#else
+    (void)memory;
+    (void)bytes;
+#endif
+}
+
+}
+
+namespace nlrs
+{
+
+/***
+ *     _   ___     __           __  ___   ____              __
+ *    | | / (_)___/ /___ _____ / / / _ | / / /__  _______ _/ /____  ____
+ *    | |/ / / __/ __/ // / _ `/ / / __ |/ / / _ \/ __/ _ `/ __/ _ \/ __/
+ *    |___/_/_/  \__/\_,_/\_,_/_/ /_/ |_/_/_/\___/\__/\_,_/\__/\___/_/
+ *
+ */
+
+const usize virtual_arena::default_commit_granularity;
+
+virtual_arena::reservation virtual_arena::reserve(usize reserve_bytes, usize commit_granularity)
+{
+    reservation r;
+    r.granularity = round_up(std::max(commit_granularity, usize(1u)), page_size());
+    r.size = round_up(reserve_bytes, r.granularity);
+    r.base = static_cast<u8*>(reserve_pages(r.size));
+    if (!r.base)
+    {
+        std::fprintf(stderr, "virtual_arena: failed to reserve %zu bytes of address space\n", r.size);
+        std::abort();
+    }
+
+    // The first chunk is committed right away, since the arena writes its sentinel tag there.
+    // Without it there is no arena to construct, so this is fatal too.
+    if (!commit_pages(r.base, r.granularity))
+    {
+        std::fprintf(stderr, "virtual_arena: failed to commit the first %zu bytes\n", r.granularity);
+        std::abort();
+    }
+
+    return r;
+}
+
+virtual_arena::virtual_arena(usize reserve_bytes, usize commit_granularity)
+    : virtual_arena(reserve(reserve_bytes, commit_granularity))
+{}
+
+virtual_arena::virtual_arena(const reservation& r)
+    : free_list_arena(r.base, r.granularity),
+    base_(r.base),
+    reserved_(r.size),
+    committed_(r.granularity),
+    granularity_(r.granularity)
+{}
+
+virtual_arena::~virtual_arena()
+{
+    release_pages(base_, reserved_);
+}
+
+usize virtual_arena::grow(usize required_size)
+{
+    if (required_size <= committed_)
+    {
+        return committed_;
+    }
+
+    usize new_committed = std::min(round_up(required_size, granularity_), reserved_);
+    if (new_committed < required_size || !commit_pages(base_ + committed_, new_committed - committed_))
+    {
+        return committed_;
+    }
+    committed_ = new_committed;
+    return committed_;
+}
+
+usize virtual_arena::trim()
+{
+    usize top = trim_top();
+
+    // the sentinel tag at the top must stay committed
+    usize keep = std::max(round_up(top + sizeof(usize), granularity_), granularity_);
+    if (keep >= committed_)
+    {
+        return 0u;
+    }
+
+    usize decommitted = committed_ - keep;
+    decommit_pages(base_ + keep, decommitted);
+    committed_ = keep;
+    shrink(committed_);
+    return decommitted;
+}
+
+}
@@ -0,0 +1,185 @@
+#include "aliases.h"
+#include "arena_stats.h"
+#include "linear_arena.h"
+#include "memory_arena.h"
+#include "stack_arena.h"
+#include "tlsf_arena.h"
+#include "UnitTest++/UnitTest++.h"
+
+#include <thread>
+#include <vector>
+
+namespace nlrs
+{
+
+SUITE(arena_stats_test)
+{
+    TEST(requests_are_bucketed_by_power_of_two)
+    {
+        CHECK_EQUAL(0u, arena_stats::size_bucket(1u));
+        CHECK_EQUAL(3u, arena_stats::size_bucket(8u));
+        CHECK_EQUAL(3u, arena_stats::size_bucket(15u));
+        CHECK_EQUAL(4u, arena_stats::size_bucket(16u));
+        CHECK_EQUAL(arena_stats::num_size_buckets - 1u, arena_stats::size_bucket(usize(1u) << 40u));
+    }
+
+    TEST(recorder_tracks_usage_and_waste)
+    {
+        arena_stats_recorder recorder;
+        recorder.on_allocate(20u, 32u);
+        recorder.on_allocate(100u, 128u);
+        recorder.on_free(32u);
+
+        arena_stats stats = recorder.snapshot(0u, 0u);
+        CHECK_EQUAL(1u, stats.num_allocations);
+        CHECK_EQUAL(2u, stats.total_allocations);
+        CHECK_EQUAL(128u, stats.bytes_in_use);
+        CHECK_EQUAL(160u, stats.peak_bytes_in_use);
+        CHECK_EQUAL(160u, stats.high_water_mark);
+        CHECK_EQUAL(1u, stats.size_histogram[4]);
+        CHECK_EQUAL(1u, stats.size_histogram[6]);
+        CHECK_EQUAL(12u, stats.waste_histogram[4]);
+        CHECK_EQUAL(40u, stats.internal_waste());
+    }
+
+    TEST(concurrent_recorder_counts_every_thread)
+    {
+        concurrent_arena_stats_recorder recorder;
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t)
+        {
+            threads.emplace_back([&recorder]() -> void
+            {
+                for (int i = 0; i < 1000; ++i)
+                {
+                    recorder.on_allocate(20u, 32u);
+                    recorder.on_resize(32u, 64u);
+                    recorder.on_free(64u);
+                }
+            });
+        }
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+        recorder.on_allocate(100u, 128u);
+
+        arena_stats stats = recorder.snapshot(0u, 0u);
+        CHECK_EQUAL(1u, stats.num_allocations);
+        CHECK_EQUAL(4001u, stats.total_allocations);
+        CHECK_EQUAL(128u, stats.bytes_in_use);
+        CHECK(stats.peak_bytes_in_use >= 128u && stats.peak_bytes_in_use <= 4u * 64u + 128u);
+        CHECK_EQUAL(4000u, stats.size_histogram[4]);
+        CHECK_EQUAL(4000u * 12u, stats.waste_histogram[4]);
+    }
+
+    TEST(fragmentation_is_zero_for_single_free_block)
+    {
+        arena_stats_recorder recorder;
+        CHECK_EQUAL(0.f, recorder.snapshot(0u, 0u).fragmentation());
+        CHECK_EQUAL(0.f, recorder.snapshot(1024u, 1024u).fragmentation());
+        CHECK_CLOSE(0.75f, recorder.snapshot(1024u, 256u).fragmentation(), 0.001f);
+    }
+
+#ifdef NLRS_ARENA_STATS
+    TEST(free_list_arena_reports_fragmented_free_memory)
+    {
+        alignas(16) static u8 memory[64u * 1024u];
+        free_list_arena arena(memory, sizeof(memory));
+
+        void* ptrs[8];
+        for (void*& ptr : ptrs)
+        {
+            ptr = arena.allocate(100u);
+        }
+        arena_stats full = arena.stats();
+        CHECK_EQUAL(8u, full.num_allocations);
+        CHECK_EQUAL(8u * arena.block_size(ptrs[0]), full.bytes_in_use);
+        CHECK_EQUAL(full.bytes_in_use + sizeof(usize), full.high_water_mark);
+        CHECK_EQUAL(8u, full.size_histogram[6]);
+        CHECK_EQUAL(0.f, full.fragmentation());
+
+        // every other block is freed, so none of them can be merged
+        for (usize i = 0u; i < 8u; i += 2u)
+        {
+            arena.free(ptrs[i]);
+        }
+        arena_stats holes = arena.stats();
+        CHECK_EQUAL(4u, holes.num_allocations);
+        CHECK_EQUAL(full.peak_bytes_in_use, holes.peak_bytes_in_use);
+        CHECK_EQUAL(full.free_bytes + 4u * arena.block_size(ptrs[1]), holes.free_bytes);
+        CHECK(holes.fragmentation() > 0.f);
+
+        for (usize i = 1u; i < 8u; i += 2u)
+        {
+            arena.free(ptrs[i]);
+        }
+        CHECK_EQUAL(0u, arena.stats().bytes_in_use);
+    }
+
+    TEST(linear_arena_reports_used_bytes_and_rewinds)
+    {
+        alignas(16) static u8 memory[1024u];
+        linear_arena arena(memory, sizeof(memory));
+        arena.allocate(100u);
+        linear_arena::marker m = arena.get_marker();
+        arena.allocate(200u);
+
+        arena_stats stats = arena.stats();
+        CHECK_EQUAL(arena.used(), stats.bytes_in_use);
+        CHECK_EQUAL(2u, stats.num_allocations);
+        CHECK_EQUAL(sizeof(memory) - arena.used(), stats.free_bytes);
+
+        arena.rewind(m);
+        CHECK_EQUAL(m, arena.stats().bytes_in_use);
+        CHECK_EQUAL(stats.high_water_mark, arena.stats().high_water_mark);
+        arena.reset();
+        CHECK_EQUAL(0u, arena.stats().num_allocations);
+    }
+
+    TEST(stack_arena_reports_both_stacks)
+    {
+        alignas(16) static u8 memory[1024u];
+        stack_arena arena(memory, sizeof(memory));
+        void* bottom = arena.allocate(64u);
+        void* top = arena.top().allocate(64u);
+
+        arena_stats stats = arena.top().stats();
+        CHECK_EQUAL(2u, stats.num_allocations);
+        CHECK_EQUAL(sizeof(memory) - arena.bytes_free(), stats.bytes_in_use);
+
+        arena.free(top);
+        arena.free(bottom);
+        CHECK_EQUAL(0u, arena.stats().bytes_in_use);
+        CHECK_EQUAL(sizeof(memory), arena.stats().free_bytes);
+    }
+
+    TEST(tlsf_arena_reports_free_blocks)
+    {
+        alignas(16) static u8 memory[64u * 1024u];
+        tlsf_arena arena(memory, sizeof(memory));
+        usize initial_free = arena.stats().free_bytes;
+
+        void* ptr = arena.allocate(1000u);
+        arena_stats stats = arena.stats();
+        CHECK_EQUAL(1u, stats.num_allocations);
+        CHECK(stats.bytes_in_use >= 1000u);
+        CHECK(stats.free_bytes < initial_free);
+
+        arena.free(ptr);
+        CHECK_EQUAL(initial_free, arena.stats().free_bytes);
+        CHECK_EQUAL(0u, arena.stats().bytes_in_use);
+    }
+
+    TEST(system_arena_counts_allocations)
+    {
+        system_arena& arena = system_arena::get_instance();
+        usize total = arena.stats().total_allocations;
+        void* ptr = arena.allocate(1000u);
+        CHECK_EQUAL(total + 1u, arena.stats().total_allocations);
+        arena.free(ptr);
+    }
+#endif
+}
+
+}
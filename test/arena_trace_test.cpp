@@ -0,0 +1,106 @@
+#include "aliases.h"
+#include "arena_trace.h"
+#include "memory_arena.h"
+#include "UnitTest++/UnitTest++.h"
+
+#include <cstdio>
+#include <vector>
+
+namespace nlrs
+{
+
+SUITE(arena_trace_test)
+{
+    TEST(recorded_trace_can_be_read_back)
+    {
+        const char* path = "arena_trace_test.trace";
+        {
+            recording_arena arena(system_arena::get_instance(), path);
+            CHECK(arena.is_recording());
+            void* a = arena.allocate(100u, 16u);
+            void* b = arena.allocate(20u);
+            a = arena.reallocate(a, 1000u);
+            arena.free(b);
+            arena.free(a);
+        }
+
+        std::vector<trace_event> events;
+        CHECK(read_arena_trace(path, events));
+        std::remove(path);
+        CHECK_EQUAL(5u, events.size());
+        if (events.size() != 5u)
+        {
+            return;
+        }
+
+        CHECK(events[0].op == trace_op::allocate);
+        CHECK_EQUAL(0u, events[0].id);
+        CHECK_EQUAL(100u, events[0].size);
+        CHECK_EQUAL(16u, events[0].alignment);
+
+        CHECK(events[1].op == trace_op::allocate);
+        CHECK_EQUAL(1u, events[1].id);
+
+        // the allocation keeps its id when reallocated
+        CHECK(events[2].op == trace_op::reallocate);
+        CHECK_EQUAL(0u, events[2].id);
+        CHECK_EQUAL(1000u, events[2].size);
+
+        CHECK(events[3].op == trace_op::free);
+        CHECK_EQUAL(1u, events[3].id);
+        CHECK(events[4].op == trace_op::free);
+        CHECK_EQUAL(0u, events[4].id);
+
+        for (usize i = 1u; i < events.size(); ++i)
+        {
+            CHECK(events[i - 1u].time_ns <= events[i].time_ns);
+        }
+    }
+
+    TEST(events_beyond_the_buffer_are_written)
+    {
+        const char* path = "arena_trace_buffer_test.trace";
+        const usize num_allocations = recording_arena::buffer_capacity + 10u;
+        {
+            recording_arena arena(system_arena::get_instance(), path);
+            for (usize i = 0u; i < num_allocations; ++i)
+            {
+                arena.free(arena.allocate(8u));
+            }
+        }
+
+        std::vector<trace_event> events;
+        CHECK(read_arena_trace(path, events));
+        std::remove(path);
+        CHECK_EQUAL(2u * num_allocations, events.size());
+    }
+
+    TEST(blocks_allocated_before_the_recording_are_not_recorded)
+    {
+        const char* path = "arena_trace_earlier_test.trace";
+        memory_arena& backing = system_arena::get_instance();
+        void* a = backing.allocate(100u);
+        void* b = backing.allocate(100u);
+        {
+            recording_arena arena(backing, path);
+            a = arena.reallocate(a, 4000u);
+            CHECK(a != nullptr);
+            arena.free(a);
+            arena.free(b, 100u);
+            arena.free(arena.allocate(8u));
+        }
+
+        std::vector<trace_event> events;
+        CHECK(read_arena_trace(path, events));
+        std::remove(path);
+        CHECK_EQUAL(2u, events.size());
+    }
+
+    TEST(reading_missing_trace_fails)
+    {
+        std::vector<trace_event> events;
+        CHECK(!read_arena_trace("this_trace_does_not_exist.trace", events));
+    }
+}
+
+}
@@ -1,102 +1,254 @@
 #include "aliases.h"
-#include "resizable_array.h"
+#include "array.h"
 #include "literals.h"
+#include "memory_arena.h"
 #include "UnitTest++/UnitTest++.h"
+
+#include <cstdlib>
 #include <utility>
-#include <vector>
 
 namespace nlrs
 {
 
-SUITE(resizable_array_test)
+SUITE(array_test)
 {
-    TEST(construct_static_array_from_initializer_list)
+    // Counts the live objects, and has a move constructor, so that it is not trivially
+    // relocatable.
+    struct counted
+    {
+        static int num_live;
+
+        int value;
+
+        counted(int v)
+            : value(v)
+        {
+            ++num_live;
+        }
+        counted(const counted& other)
+            : value(other.value)
+        {
+            ++num_live;
+        }
+        counted(counted&& other) noexcept
+            : value(other.value)
+        {
+            other.value = -1;
+            ++num_live;
+        }
+        ~counted()
+        {
+            --num_live;
+        }
+    };
+
+    int counted::num_live = 0;
+
+    struct array_with_allocator
+    {
+        array_with_allocator()
+            : ints(system_arena::get_instance())
+        {}
+
+        array<int> ints;
+    };
+
+    TEST_FIXTURE(array_with_allocator, default_constructed_array_holds_no_memory)
+    {
+        CHECK_EQUAL(0_sz, ints.size());
+        CHECK_EQUAL(0_sz, ints.capacity());
+        CHECK(ints.begin() == ints.end());
+    }
+
+    TEST_FIXTURE(array_with_allocator, push_back_grows_the_capacity_geometrically)
+    {
+        for (int i = 0; i < 100; ++i)
+        {
+            ints.push_back(i);
+        }
+        CHECK_EQUAL(100_sz, ints.size());
+        CHECK_EQUAL(128_sz, ints.capacity());
+        for (int i = 0; i < 100; ++i)
+        {
+            CHECK_EQUAL(i, ints[usize(i)]);
+        }
+        CHECK_EQUAL(0, ints.front());
+        CHECK_EQUAL(99, ints.back());
+    }
+
+    TEST_FIXTURE(array_with_allocator, push_back_of_an_element_survives_growth)
     {
-        resizable_array<int, 3> array{1, 2, 3};
-        CHECK_EQUAL(1, array.at(0u));
-        CHECK_EQUAL(2, array.at(1u));
-        CHECK_EQUAL(3, array.at(2u));
-        CHECK_EQUAL(3_sz, array.size());
+        ints.push_back(7);
+        for (int i = 0; i < 20; ++i)
+        {
+            ints.push_back(ints[0u]);
+        }
+        for (int value : ints)
+        {
+            CHECK_EQUAL(7, value);
+        }
     }
 
-    TEST(default_constructed_static_array_contains_no_elements)
+    TEST_FIXTURE(array_with_allocator, append_copies_the_elements)
     {
-        resizable_array<int, 3> array;
-        CHECK_EQUAL(0_sz, array.size());
+        int values[5] = { 1, 2, 3, 4, 5 };
+        ints.push_back(0);
+        ints.append(values, 5u);
+        CHECK_EQUAL(6_sz, ints.size());
+        for (int i = 0; i < 6; ++i)
+        {
+            CHECK_EQUAL(i, ints[usize(i)]);
+        }
     }
 
-    TEST(push_back_elements_into_static_array)
+    TEST_FIXTURE(array_with_allocator, append_of_its_own_elements_survives_growth)
     {
-        resizable_array<int, 5> array;
-        array.push_back(1);
-        array.push_back(2);
-        array.push_back(3);
-        CHECK_EQUAL(1, array[0u]);
-        CHECK_EQUAL(2, array[1u]);
-        CHECK_EQUAL(3, array[2u]);
-        CHECK_EQUAL(3_sz, array.size());
+        ints.reserve(4u);
+        for (int i = 0; i < 4; ++i)
+        {
+            ints.push_back(i);
+        }
+        ints.append(ints.data() + 1u, 3u);
+        CHECK_EQUAL(7_sz, ints.size());
+        int expected[7] = { 0, 1, 2, 3, 1, 2, 3 };
+        for (usize i = 0u; i < 7u; ++i)
+        {
+            CHECK_EQUAL(expected[i], ints[i]);
+        }
     }
 
-    TEST(iteration_over_elements)
+    TEST_FIXTURE(array_with_allocator, resize_value_initializes_the_new_elements)
     {
-        resizable_array<int, 5> array = { 1, 2, 3, 4 };
-        int values[4] = { 1, 2, 3, 4 };
-        usize index = 0u;
-        for (int value : array)
+        ints.resize(3u, 5);
+        ints.resize(6u);
+        int expected[6] = { 5, 5, 5, 0, 0, 0 };
+        for (usize i = 0u; i < 6u; ++i)
         {
-            CHECK_EQUAL(values[index], value);
-            index++;
+            CHECK_EQUAL(expected[i], ints[i]);
         }
+        ints.resize(2u);
+        CHECK_EQUAL(2_sz, ints.size());
+    }
+
+    TEST_FIXTURE(array_with_allocator, resize_uninitialized_keeps_the_old_elements)
+    {
+        ints.push_back(1);
+        ints.push_back(2);
+        ints.resize_uninitialized(1000u);
+        CHECK_EQUAL(1000_sz, ints.size());
+        CHECK(ints.capacity() >= 1000u);
+        CHECK_EQUAL(1, ints[0u]);
+        CHECK_EQUAL(2, ints[1u]);
     }
 
-    TEST(reverse_iteration_over_elements)
+    TEST(elements_which_are_not_trivially_relocatable_are_moved)
     {
-        resizable_array<int, 5> array = { 1, 2, 3, 4 };
-        int values[4] = { 4, 3, 2, 1 };
-        usize index = 0u;
-        for (auto it = array.rbegin(); it != array.rend(); ++it)
         {
-            CHECK_EQUAL(values[index], *it);
-            index++;
+            array<counted> objects(system_arena::get_instance());
+            for (int i = 0; i < 50; ++i)
+            {
+                objects.emplace_back(i);
+            }
+            CHECK_EQUAL(50, counted::num_live);
+            for (int i = 0; i < 50; ++i)
+            {
+                CHECK_EQUAL(i, objects[usize(i)].value);
+            }
+            objects.pop_back();
+            objects.resize(10u, counted(3));
+            CHECK_EQUAL(10, counted::num_live);
         }
+        CHECK_EQUAL(0, counted::num_live);
     }
 
-    TEST(begin_end_iterators_are_the_same_for_empty_container)
+    TEST(append_copies_elements_which_are_not_trivially_copyable)
     {
-        resizable_array<int, 3> array;
-        CHECK(array.begin() == array.end());
+        {
+            array<counted> objects(system_arena::get_instance());
+            objects.emplace_back(1);
+            objects.emplace_back(2);
+            objects.append(objects.data(), 2u);
+            CHECK_EQUAL(4_sz, objects.size());
+            CHECK_EQUAL(4, counted::num_live);
+            CHECK_EQUAL(1, objects[2u].value);
+            CHECK_EQUAL(2, objects[3u].value);
+        }
+        CHECK_EQUAL(0, counted::num_live);
     }
 
-    TEST(reverse_begin_reverse_end_iterators_are_the_same_for_empty_container)
+    TEST(arrays_of_arrays_are_relocated_by_reallocation)
     {
-        resizable_array<int, 3> array;
-        CHECK(array.rbegin() == array.rend());
+        array<array<int>> arrays(system_arena::get_instance());
+        for (int i = 0; i < 20; ++i)
+        {
+            arrays.emplace_back(system_arena::get_instance());
+            arrays.back().push_back(i);
+        }
+        for (int i = 0; i < 20; ++i)
+        {
+            CHECK_EQUAL(1_sz, arrays[usize(i)].size());
+            CHECK_EQUAL(i, arrays[usize(i)][0u]);
+        }
     }
 
-    TEST(is_copy_assignable)
+    TEST(growth_fails_without_changing_the_array_when_the_arena_runs_out)
     {
-        resizable_array<int, 3> a1;
-        a1.push_back(1);
-        a1.push_back(2);
-        a1.push_back(3);
-        resizable_array<int, 3> a2 = a1;
-
-        CHECK_EQUAL(a1[0], a2[0]);
-        CHECK_EQUAL(a1[1], a2[1]);
-        CHECK_EQUAL(a1[2], a2[2]);
+        const usize arena_size = 4096u;
+        void* memory = std::malloc(arena_size);
+        {
+            free_list_arena arena(memory, arena_size);
+            array<int> ints(arena);
+            for (int i = 0; i < 100; ++i)
+            {
+                ints.push_back(i);
+            }
+            usize capacity = ints.capacity();
+            CHECK(!ints.reserve(4096u));
+            CHECK(!ints.resize(4096u));
+            CHECK(!ints.resize(4096u, 1));
+            CHECK(!ints.resize_uninitialized(4096u));
+            CHECK(!ints.append(ints.data(), 4000u));
+            CHECK_EQUAL(capacity, ints.capacity());
+            CHECK_EQUAL(100_sz, ints.size());
+            for (int i = 0; i < 100; ++i)
+            {
+                CHECK_EQUAL(i, ints[usize(i)]);
+            }
+
+            array<counted> objects(arena);
+            objects.emplace_back(1);
+            CHECK(!objects.reserve(4096u));
+            CHECK(!objects.resize(4096u, counted(2)));
+            CHECK_EQUAL(1_sz, objects.size());
+            CHECK_EQUAL(1, objects[0u].value);
+            CHECK_EQUAL(1, counted::num_live);
+        }
+        CHECK_EQUAL(0, counted::num_live);
+        std::free(memory);
     }
 
-    TEST(is_copy_constructable)
+    TEST(move_assignment_takes_the_elements_and_the_arena)
     {
-        resizable_array<int, 3> a1;
-        a1.push_back(1);
-        a1.push_back(2);
-        a1.push_back(3);
-        resizable_array<int, 3> a2(a1);
-
-        CHECK_EQUAL(a1[0], a2[0]);
-        CHECK_EQUAL(a1[1], a2[1]);
-        CHECK_EQUAL(a1[2], a2[2]);
+        const usize arena_size = 4096u;
+        void* memory = std::malloc(arena_size);
+        {
+            free_list_arena arena(memory, arena_size);
+            array<int> from(arena);
+            from.push_back(1);
+            from.push_back(2);
+
+            array<int> to(system_arena::get_instance());
+            to.push_back(3);
+            to = std::move(from);
+            CHECK_EQUAL(&arena, &to.allocator());
+            CHECK_EQUAL(2_sz, to.size());
+            CHECK_EQUAL(1, to[0u]);
+            CHECK_EQUAL(0_sz, from.size());
+            // the moved-to array now frees its memory to the free list arena
+            to.clear();
+            to = array<int>(arena);
+        }
+        std::free(memory);
     }
 }
 
@@ -0,0 +1,148 @@
+#include "aliases.h"
+#include "buddy_arena.h"
+#include "random.h"
+#include "UnitTest++/UnitTest++.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace nlrs
+{
+
+struct buddy_memory_container
+{
+    // 64 KiB of blocks, and the block table behind them
+    buddy_memory_container()
+        : arena(memory, sizeof(memory))
+    {}
+
+    alignas(128) u8 memory[64u * 1024u + 64u * 1024u / 32u];
+    buddy_arena arena;
+};
+
+SUITE(buddy_arena_test)
+{
+    TEST_FIXTURE(buddy_memory_container, memory_is_a_single_block_initially)
+    {
+        CHECK_EQUAL(64u * 1024u, arena.capacity());
+        CHECK_EQUAL(64u * 1024u, arena.largest_free_block());
+        CHECK(arena.allocate(0u) == nullptr);
+    }
+
+    TEST_FIXTURE(buddy_memory_container, blocks_are_rounded_to_powers_of_two)
+    {
+        void* a = arena.allocate(1u);
+        void* b = arena.allocate(33u);
+        void* c = arena.allocate(1000u);
+        CHECK_EQUAL(32u, arena.block_size(a));
+        CHECK_EQUAL(64u, arena.block_size(b));
+        CHECK_EQUAL(1024u, arena.block_size(c));
+        CHECK_EQUAL(64u * 1024u - 32u - 64u - 1024u, arena.free_bytes());
+        arena.free(a);
+        arena.free(b);
+        arena.free(c);
+        CHECK_EQUAL(0u, arena.num_allocations());
+    }
+
+    TEST_FIXTURE(buddy_memory_container, buddies_are_adjacent)
+    {
+        u8* a = static_cast<u8*>(arena.allocate(32u));
+        u8* b = static_cast<u8*>(arena.allocate(32u));
+        CHECK_EQUAL(a + 32, b);
+        CHECK_EQUAL(0u, uptr(a - memory) % 128u);
+        arena.free(a);
+        arena.free(b);
+    }
+
+    TEST_FIXTURE(buddy_memory_container, freeing_all_blocks_merges_them_back)
+    {
+        std::vector<void*> ptrs;
+        for (usize i = 0u; i < 64u; ++i)
+        {
+            ptrs.push_back(arena.allocate(1000u));
+        }
+        CHECK(arena.allocate(1000u) == nullptr);
+        CHECK_EQUAL(0u, arena.largest_free_block());
+
+        // free every other block first, so that no buddies can merge until the second pass
+        for (usize i = 0u; i < ptrs.size(); i += 2u)
+        {
+            arena.free(ptrs[i]);
+        }
+        CHECK_EQUAL(1024u, arena.largest_free_block());
+        for (usize i = 1u; i < ptrs.size(); i += 2u)
+        {
+            arena.free(ptrs[i]);
+        }
+        CHECK_EQUAL(64u * 1024u, arena.largest_free_block());
+    }
+
+    TEST_FIXTURE(buddy_memory_container, alignment_is_correct)
+    {
+        u8 alignments[] = { 1u, 4u, 8u, 16u, 32u, 64u, 128u };
+        for (u8 alignment : alignments)
+        {
+            void* ptr = arena.allocate(24u, alignment);
+            CHECK_EQUAL(0u, reinterpret_cast<uptr>(ptr) % alignment);
+            arena.free(ptr, 24u, alignment);
+        }
+    }
+
+    TEST_FIXTURE(buddy_memory_container, reallocation_preserves_contents)
+    {
+        u8* ptr = static_cast<u8*>(arena.allocate(40u));
+        std::memset(ptr, 3, 40u);
+        CHECK_EQUAL(static_cast<void*>(ptr), arena.reallocate(ptr, 64u));
+        u8* grown = static_cast<u8*>(arena.reallocate(ptr, 500u));
+        CHECK_EQUAL(3, grown[39]);
+        arena.free(grown);
+        CHECK_EQUAL(64u * 1024u, arena.largest_free_block());
+    }
+
+    TEST(memory_which_is_not_a_power_of_two_is_split)
+    {
+        // leave room for aligning the start of the memory
+        const usize bytes = 48u * 1024u + 48u * 1024u / 32u + 200u;
+        void* memory = std::malloc(bytes);
+        {
+            buddy_arena arena(memory, bytes);
+            CHECK_EQUAL(32u * 1024u, arena.largest_free_block());
+            void* large = arena.allocate(32u * 1024u);
+            void* rest = arena.allocate(16u * 1024u);
+            CHECK(large != nullptr);
+            CHECK(rest != nullptr);
+            arena.free(large);
+            arena.free(rest);
+            CHECK_EQUAL(arena.capacity(), arena.free_bytes());
+        }
+        std::free(memory);
+    }
+
+    TEST(random_churn_coalesces_completely)
+    {
+        const usize bytes = 1024u * 1024u + 1024u * 1024u / 32u;
+        void* memory = std::malloc(bytes + 128u);
+        {
+            buddy_arena arena(memory, bytes + 128u);
+            nlrs::random<usize> rng;
+            rng.seed(7u);
+            std::vector<void*> live(200u, nullptr);
+            for (usize i = 0u; i < 20000u; ++i)
+            {
+                void*& slot = live[rng(0u, live.size() - 1u)];
+                arena.free(slot);
+                slot = arena.allocate(rng(1u, 4000u));
+                CHECK(slot != nullptr);
+            }
+            for (void* ptr : live)
+            {
+                arena.free(ptr);
+            }
+            CHECK_EQUAL(1024u * 1024u, arena.largest_free_block());
+        }
+        std::free(memory);
+    }
+}
+
+}
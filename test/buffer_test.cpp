@@ -1,6 +1,7 @@
 #include "buffer.h"
 #include "literals.h"
 #include "UnitTest++/UnitTest++.h"
+#include <cstdlib>
 #include <utility>
 
 namespace nlrs
@@ -77,6 +78,14 @@ SUITE(BufferTest)
         CHECK_EQUAL(1, *new_buffer.at(1));
     }
 
+    TEST(aligned_buffer_from_system_arena_is_aligned)
+    {
+        buffer<float, 64> aligned(system_arena::get_instance(), 16u);
+        CHECK_EQUAL(0u, reinterpret_cast<uptr>(aligned.at(0u)) % 64u);
+        aligned.reserve(1024u);
+        CHECK_EQUAL(0u, reinterpret_cast<uptr>(aligned.at(0u)) % 64u);
+    }
+
     TEST_FIXTURE(buffer_with_allocator, resize_after_move)
     {
         buffer<int> new_buffer = std::move(buf);
@@ -87,6 +96,23 @@ SUITE(BufferTest)
         CHECK_EQUAL(10, *buf[0]);
         CHECK_EQUAL(20, *buf[1]);
     }
+
+    TEST(failed_reserve_keeps_the_old_memory)
+    {
+        const usize arena_size = 1024u;
+        void* memory = std::malloc(arena_size);
+        {
+            free_list_arena arena(memory, arena_size);
+            buffer<int> ints(arena, 8u);
+            *ints[7] = 7;
+            int* data = ints.at(0u);
+            CHECK(!ints.reserve(4096u));
+            CHECK_EQUAL(8_sz, ints.capacity());
+            CHECK_EQUAL(data, ints.at(0u));
+            CHECK_EQUAL(7, *ints[7]);
+        }
+        std::free(memory);
+    }
 }
 
 }
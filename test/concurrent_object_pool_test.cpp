@@ -0,0 +1,193 @@
+#include "aliases.h"
+#include "concurrent_object_pool.h"
+#include "memory_arena.h"
+#include "random.h"
+#include "UnitTest++/UnitTest++.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace nlrs
+{
+
+SUITE(concurrent_object_pool_test)
+{
+    struct payload
+    {
+        u64 value;
+        u64 check;
+    };
+
+    TEST(released_objects_are_reused)
+    {
+        concurrent_object_pool<payload, 4> pool(system_arena::get_instance());
+        payload* a = pool.create(u64(1u), ~u64(1u));
+        CHECK_EQUAL(1u, a->value);
+        pool.release(a);
+        CHECK_EQUAL(a, pool.create(u64(2u), ~u64(2u)));
+        pool.release(a);
+    }
+
+    TEST(pool_grows_by_chunks)
+    {
+        concurrent_object_pool<payload, 4> pool(system_arena::get_instance());
+        std::vector<payload*> objects;
+        for (u64 i = 0u; i < 10u; ++i)
+        {
+            objects.push_back(pool.create(i, ~i));
+        }
+        CHECK_EQUAL(3u, pool.num_chunks());
+        CHECK_EQUAL(12u, pool.capacity());
+        for (u64 i = 0u; i < 10u; ++i)
+        {
+            CHECK_EQUAL(i, objects[i]->value);
+            pool.release(objects[i]);
+        }
+    }
+
+    TEST(create_returns_null_past_max_chunks)
+    {
+        concurrent_object_pool<payload, 2> pool(system_arena::get_instance(), 2u);
+        payload* objects[4];
+        for (payload*& obj : objects)
+        {
+            obj = pool.create();
+            CHECK(obj != nullptr);
+        }
+        CHECK(pool.create() == nullptr);
+        for (payload* obj : objects)
+        {
+            pool.release(obj);
+        }
+    }
+
+    TEST(thread_cache_returns_its_objects_when_destroyed)
+    {
+        concurrent_object_pool<payload, 64> pool(system_arena::get_instance(), 1u);
+        {
+            concurrent_object_pool<payload, 64>::thread_cache cache(pool);
+            payload* a = cache.create(u64(1u), ~u64(1u));
+            CHECK(a != nullptr);
+            cache.release(a);
+            CHECK_EQUAL(a, cache.create());
+            cache.release(a);
+        }
+        // every object is back in the shared stack, so the single chunk can be emptied
+        std::vector<payload*> objects;
+        while (payload* obj = pool.create())
+        {
+            objects.push_back(obj);
+        }
+        CHECK_EQUAL(64u, objects.size());
+        for (payload* obj : objects)
+        {
+            pool.release(obj);
+        }
+    }
+
+    // Each thread creates objects, swaps them with objects left by other threads in a
+    // shared array of slots, and releases what it took, so that objects are released by
+    // other threads than the ones which created them.
+    template<typename Create, typename Release>
+    void stress(int thread_id, std::vector<std::atomic<payload*>>& slots, std::atomic<int>& errors,
+        Create create, Release release)
+    {
+        nlrs::random<usize> rng;
+        rng.seed(u32(thread_id + 1));
+        for (int i = 0; i < 20000; ++i)
+        {
+            u64 value = (u64(thread_id) << 32u) | u64(i);
+            payload* obj = create(value, ~value);
+            if (!obj)
+            {
+                errors.fetch_add(1);
+                continue;
+            }
+            payload* taken = slots[rng(0u, slots.size() - 1u)].exchange(obj, std::memory_order_acq_rel);
+            if (taken)
+            {
+                if (taken->check != ~taken->value)
+                {
+                    errors.fetch_add(1);
+                }
+                release(taken);
+            }
+        }
+    }
+
+    TEST(objects_can_be_created_and_released_by_many_threads)
+    {
+        const int num_threads = 4;
+        concurrent_object_pool<payload, 16> pool(system_arena::get_instance());
+        std::vector<std::atomic<payload*>> slots(64u);
+        for (std::atomic<payload*>& slot : slots)
+        {
+            slot.store(nullptr);
+        }
+        std::atomic<int> errors{ 0 };
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < num_threads; ++t)
+        {
+            threads.emplace_back([&, t]() -> void
+            {
+                stress(t, slots, errors,
+                    [&](u64 value, u64 check) -> payload* { return pool.create(value, check); },
+                    [&](payload* obj) -> void { pool.release(obj); });
+            });
+        }
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+        CHECK_EQUAL(0, errors.load());
+        // at most one object per slot is alive, so the pool never needed more than that
+        CHECK(pool.capacity() <= slots.size() + num_threads * 16u);
+        for (std::atomic<payload*>& slot : slots)
+        {
+            if (payload* obj = slot.load())
+            {
+                pool.release(obj);
+            }
+        }
+    }
+
+    TEST(thread_caches_can_be_used_by_many_threads)
+    {
+        const int num_threads = 4;
+        concurrent_object_pool<payload, 16> pool(system_arena::get_instance());
+        std::vector<std::atomic<payload*>> slots(64u);
+        for (std::atomic<payload*>& slot : slots)
+        {
+            slot.store(nullptr);
+        }
+        std::atomic<int> errors{ 0 };
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < num_threads; ++t)
+        {
+            threads.emplace_back([&, t]() -> void
+            {
+                concurrent_object_pool<payload, 16>::thread_cache cache(pool);
+                stress(t, slots, errors,
+                    [&](u64 value, u64 check) -> payload* { return cache.create(value, check); },
+                    [&](payload* obj) -> void { cache.release(obj); });
+            });
+        }
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+        CHECK_EQUAL(0, errors.load());
+        for (std::atomic<payload*>& slot : slots)
+        {
+            if (payload* obj = slot.load())
+            {
+                pool.release(obj);
+            }
+        }
+    }
+}
+
+}
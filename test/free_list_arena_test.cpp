@@ -1,10 +1,14 @@
 #include "aliases.h"
 #include "memory_arena.h"
 #include "literals.h"
+#include "random.h"
 #include "UnitTest++/UnitTest++.h"
 
 #include "stl/vector.h"
+#include <cstring>
 #include <scoped_allocator>
+#include <utility>
+#include <vector>
 
 namespace nlrs
 {
@@ -27,7 +31,24 @@ struct memory_container
     }
 
     void* memory;
-    free_list_arena heap;
+    // the tests read the guarded block layout directly
+    basic_free_list_arena<free_list_debug_policy> heap;
+};
+
+struct compact_memory_container
+{
+    compact_memory_container()
+        : memory(std::malloc(1024 * 1024)),
+        heap(memory, 1024 * 1024)
+    {}
+
+    ~compact_memory_container()
+    {
+        std::free(memory);
+    }
+
+    void* memory;
+    basic_free_list_arena<free_list_release_policy> heap;
 };
 
 struct header
@@ -39,8 +60,9 @@ struct header
 
 struct free_block
 {
-    usize       size;
-    free_block*  next;
+    usize       tag;
+    free_block* next_in_class;
+    free_block* prev_in_class;
 };
 
 SUITE(free_list_allocator_test)
@@ -73,6 +95,14 @@ SUITE(free_list_allocator_test)
         heap.free(block4);
     }
 
+    TEST_FIXTURE(memory_container, allocate_returns_null_when_the_arena_is_full)
+    {
+        void* block = heap.allocate(1024);
+        CHECK(heap.allocate(2 * 1024 * 1024) == nullptr);
+        CHECK_EQUAL(1, heap.num_allocations());
+        heap.free(block);
+    }
+
     TEST_FIXTURE(memory_container, free_list_merge)
     {
         void* block1 = heap.allocate(64);
@@ -92,10 +122,216 @@ SUITE(free_list_allocator_test)
         CHECK_EQUAL(0, heap.num_allocations());
     }
 
+    TEST_FIXTURE(memory_container, freed_block_is_reused_by_smaller_allocation)
+    {
+        void* large = heap.allocate(1000);
+        void* separator = heap.allocate(64);
+        heap.free(large);
+        CHECK_EQUAL(1, heap.num_free_blocks());
+
+        void* small = heap.allocate(100);
+        CHECK_EQUAL(large, small);
+        // the rest of the large block is returned to the free list
+        CHECK_EQUAL(1, heap.num_free_blocks());
+        CHECK(heap.block_size(small) < 1024u);
+
+        heap.free(small);
+        heap.free(separator);
+        CHECK_EQUAL(1, heap.num_free_blocks());
+    }
+
+    TEST_FIXTURE(memory_container, freeing_in_any_order_merges_into_one_block)
+    {
+        const usize num_blocks = 512u;
+        nlrs::random<usize> rng;
+        rng.seed(42u);
+
+        std::vector<std::pair<u8*, usize>> blocks;
+        auto free_random_block = [&]() -> void
+        {
+            usize index = rng(0u, blocks.size() - 1u);
+            u8* block = blocks[index].first;
+            usize size = blocks[index].second;
+            // neighbouring blocks must not have been overwritten
+            CHECK_EQUAL(u8(size), block[0]);
+            CHECK_EQUAL(u8(size), block[size - 1u]);
+            heap.free(block);
+            blocks[index] = blocks.back();
+            blocks.pop_back();
+        };
+
+        for (int round = 0; round < 4; ++round)
+        {
+            while (blocks.size() < num_blocks)
+            {
+                usize size = rng(1u, 600u);
+                u8* block = static_cast<u8*>(heap.allocate(size));
+                std::memset(block, u8(size), size);
+                blocks.push_back(std::make_pair(block, size));
+            }
+
+            // free a random half of the blocks, so that the free blocks are scattered
+            while (blocks.size() > num_blocks / 2u)
+            {
+                free_random_block();
+            }
+        }
+
+        while (!blocks.empty())
+        {
+            free_random_block();
+        }
+
+        CHECK_EQUAL(0, heap.num_allocations());
+        CHECK_EQUAL(1, heap.num_free_blocks());
+    }
+
+    TEST_FIXTURE(memory_container, split_block_can_be_allocated)
+    {
+        void* large = heap.allocate(1000);
+        void* separator = heap.allocate(64);
+        heap.free(large);
+
+        void* small1 = heap.allocate(100);
+        void* small2 = heap.allocate(100);
+        CHECK(reinterpret_cast<uptr>(small2) > reinterpret_cast<uptr>(small1));
+        CHECK(reinterpret_cast<uptr>(small2) < reinterpret_cast<uptr>(separator));
+
+        heap.free(small1);
+        heap.free(small2);
+        heap.free(separator);
+        CHECK_EQUAL(1, heap.num_free_blocks());
+    }
+
+    TEST_FIXTURE(memory_container, reallocate_grows_block_at_top_in_place)
+    {
+        void* block = heap.allocate(100);
+        std::memset(block, 7, 100);
+        void* grown = heap.reallocate(block, 4000);
+        CHECK_EQUAL(block, grown);
+        CHECK(heap.block_size(grown) >= 4000u);
+        CHECK_EQUAL(7, static_cast<u8*>(grown)[99]);
+        heap.free(grown);
+    }
+
+    TEST_FIXTURE(memory_container, reallocate_grows_block_into_free_neighbour_in_place)
+    {
+        void* block = heap.allocate(100);
+        void* neighbour = heap.allocate(1000);
+        void* separator = heap.allocate(64);
+        std::memset(block, 7, 100);
+        heap.free(neighbour);
+
+        void* grown = heap.reallocate(block, 500);
+        CHECK_EQUAL(block, grown);
+        CHECK_EQUAL(7, static_cast<u8*>(grown)[99]);
+        // the part of the neighbour which wasn't needed is still free
+        CHECK_EQUAL(1, heap.num_free_blocks());
+
+        heap.free(grown);
+        heap.free(separator);
+        CHECK_EQUAL(1, heap.num_free_blocks());
+    }
+
+    TEST_FIXTURE(memory_container, reallocate_moves_block_when_neighbour_is_allocated)
+    {
+        void* block = heap.allocate(100);
+        void* neighbour = heap.allocate(100);
+        std::memset(block, 7, 100);
+
+        void* moved = heap.reallocate(block, 500);
+        CHECK(moved != block);
+        CHECK_EQUAL(7, static_cast<u8*>(moved)[99]);
+
+        heap.free(moved);
+        heap.free(neighbour);
+    }
+
+    TEST_FIXTURE(compact_memory_container, compact_block_has_one_word_of_overhead)
+    {
+        void* small = heap.allocate(24u);
+        void* word_sized = heap.allocate(56u);
+        CHECK_EQUAL(32u, heap.block_size(small));
+        CHECK_EQUAL(64u, heap.block_size(word_sized));
+        CHECK_EQUAL(static_cast<u8*>(small) + 32, static_cast<u8*>(word_sized));
+
+        heap.free(small);
+        heap.free(word_sized);
+        CHECK_EQUAL(1, heap.num_free_blocks());
+    }
+
+    TEST_FIXTURE(compact_memory_container, compact_block_honours_alignment)
+    {
+        std::vector<void*> blocks;
+        for (u32 shift = 0u; shift < 8u; ++shift)
+        {
+            u8 alignment = u8(1u << shift);
+            u8* block = static_cast<u8*>(heap.allocate(40u, alignment));
+            CHECK_EQUAL(0u, reinterpret_cast<uptr>(block) % alignment);
+            std::memset(block, shift, 40u);
+            blocks.push_back(block);
+        }
+
+        for (u32 shift = 0u; shift < 8u; ++shift)
+        {
+            CHECK_EQUAL(shift, static_cast<u8*>(blocks[shift])[39]);
+            heap.free(blocks[shift]);
+        }
+        CHECK_EQUAL(0, heap.num_allocations());
+        CHECK_EQUAL(1, heap.num_free_blocks());
+    }
+
+    TEST_FIXTURE(compact_memory_container, compact_block_keeps_alignment_when_moved)
+    {
+        u8* block = static_cast<u8*>(heap.allocate(40u, 64u));
+        void* neighbour = heap.allocate(100u);
+        std::memset(block, 7, 40u);
+
+        u8* moved = static_cast<u8*>(heap.reallocate(block, 1000u));
+        CHECK(moved != block);
+        CHECK_EQUAL(0u, reinterpret_cast<uptr>(moved) % 64u);
+        CHECK_EQUAL(7, moved[39]);
+
+        heap.free(moved);
+        heap.free(neighbour);
+        CHECK_EQUAL(1, heap.num_free_blocks());
+    }
+
+    TEST_FIXTURE(compact_memory_container, usable_size_excludes_block_overhead)
+    {
+        void* small = heap.allocate(24u);
+        void* aligned = heap.allocate(40u, 64u);
+        CHECK_EQUAL(24u, heap.usable_size(small));
+        CHECK(heap.usable_size(aligned) >= 40u);
+        CHECK(heap.usable_size(aligned) < heap.block_size(aligned));
+        CHECK_EQUAL(64u, heap.alignment(aligned));
+        heap.free(small);
+        heap.free(aligned);
+    }
+
+    TEST_FIXTURE(memory_container, guarded_usable_size_excludes_block_overhead)
+    {
+        void* block = heap.allocate(100u, 32u);
+        CHECK(heap.usable_size(block) >= 100u);
+        CHECK(heap.usable_size(block) < heap.block_size(block));
+        CHECK_EQUAL(32u, heap.alignment(block));
+        heap.free(block);
+    }
+
+    TEST_FIXTURE(compact_memory_container, compact_block_grows_in_place)
+    {
+        u8* block = static_cast<u8*>(heap.allocate(100u, 32u));
+        std::memset(block, 7, 100u);
+        u8* grown = static_cast<u8*>(heap.reallocate(block, 4000u));
+        CHECK_EQUAL(block, grown);
+        CHECK_EQUAL(7, grown[99]);
+        heap.free(grown);
+    }
+
     TEST_FIXTURE(memory_container, free_list_reallocate_contains_original_data)
     {
         auto alloc = polymorphic_allocator<u8>(heap);
-        std::pmr::vector<u8> vec(alloc);
+        pmr::vector<u8> vec(alloc);
 
         vec.resize(64);
         std::memset(vec.data(), 0, 64);
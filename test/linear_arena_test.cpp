@@ -0,0 +1,98 @@
+#include "aliases.h"
+#include "linear_arena.h"
+#include "literals.h"
+#include "UnitTest++/UnitTest++.h"
+
+#include "stl/vector.h"
+#include <cstring>
+
+namespace nlrs
+{
+
+struct linear_memory_container
+{
+    linear_memory_container()
+        : arena(memory, sizeof(memory))
+    {}
+
+    alignas(16) u8 memory[4096];
+    linear_arena arena;
+};
+
+SUITE(linear_arena_test)
+{
+    TEST_FIXTURE(linear_memory_container, allocations_are_contiguous_and_aligned)
+    {
+        u8* first = static_cast<u8*>(arena.allocate(3u, 1u));
+        u8* second = static_cast<u8*>(arena.allocate(8u, 8u));
+        u8* third = static_cast<u8*>(arena.allocate(16u, 16u));
+
+        CHECK_EQUAL(memory, first);
+        CHECK_EQUAL(memory + 8, second);
+        CHECK_EQUAL(memory + 16, third);
+        CHECK_EQUAL(32_sz, arena.used());
+    }
+
+    TEST_FIXTURE(linear_memory_container, rewinding_to_marker_releases_later_allocations)
+    {
+        arena.allocate(64u);
+        linear_arena::marker m = arena.get_marker();
+        void* ptr = arena.allocate(128u);
+        arena.allocate(128u);
+
+        arena.rewind(m);
+        CHECK_EQUAL(64_sz, arena.used());
+        CHECK_EQUAL(ptr, arena.allocate(128u));
+    }
+
+    TEST_FIXTURE(linear_memory_container, scope_rewinds_on_exit)
+    {
+        arena.allocate(64u);
+        {
+            linear_arena::scope scope(arena);
+            arena.allocate(256u);
+            CHECK_EQUAL(320_sz, arena.used());
+        }
+        CHECK_EQUAL(64_sz, arena.used());
+    }
+
+    TEST_FIXTURE(linear_memory_container, most_recent_allocation_is_reallocated_in_place)
+    {
+        void* ptr = arena.allocate(16u);
+        void* grown = arena.reallocate(ptr, 256u);
+        CHECK_EQUAL(ptr, grown);
+        CHECK_EQUAL(256_sz, arena.used());
+    }
+
+    TEST_FIXTURE(linear_memory_container, older_allocation_is_moved_on_reallocation)
+    {
+        u8* ptr = static_cast<u8*>(arena.allocate(16u));
+        std::memset(ptr, 9, 16u);
+        arena.allocate(16u);
+        u8* moved = static_cast<u8*>(arena.reallocate(ptr, 64u));
+        CHECK(moved != ptr);
+        CHECK_EQUAL(9, moved[15]);
+    }
+
+    TEST_FIXTURE(linear_memory_container, running_out_of_memory_returns_null)
+    {
+        void* ptr = arena.allocate(4000u);
+        CHECK(arena.allocate(128u) == nullptr);
+        CHECK(arena.reallocate(ptr, 8192u) == nullptr);
+        CHECK_EQUAL(4000_sz, arena.used());
+    }
+
+    TEST_FIXTURE(linear_memory_container, vector_can_use_linear_arena)
+    {
+        linear_arena::scope scope(arena);
+        pmr::vector<int> vec{ polymorphic_allocator<int>(arena) };
+        for (int i = 0; i < 100; ++i)
+        {
+            vec.push_back(i);
+        }
+        CHECK_EQUAL(0, vec.front());
+        CHECK_EQUAL(99, vec.back());
+    }
+}
+
+}
@@ -1,6 +1,11 @@
 #include "object_pool.h"
+#include "pool_arena.h"
 #include "UnitTest++/UnitTest++.h"
 
+#include <iterator>
+#include <utility>
+#include <vector>
+
 namespace nlrs
 {
 
@@ -96,13 +101,213 @@ SUITE(object_pool_test)
         CHECK_EQUAL(ptr, obj);
     }
 
-    TEST(pool_returns_null_at_max_capacity)
+    TEST(pool_grows_past_its_chunk_size)
     {
         object_pool<int, 3> pool(system_arena::get_instance());
-        pool.create();
-        pool.create();
-        pool.create();
-        CHECK_EQUAL((int*)nullptr, pool.create());
+        int* first = pool.create(1);
+        pool.create(2);
+        pool.create(3);
+        CHECK_EQUAL(1u, pool.num_chunks());
+        int* fourth = pool.create(4);
+        CHECK(fourth != nullptr);
+        CHECK_EQUAL(2u, pool.num_chunks());
+        CHECK_EQUAL(6u, pool.capacity());
+        CHECK_EQUAL(4u, pool.size());
+        // the objects in the first chunk stay where they were
+        CHECK_EQUAL(1, *first);
+        CHECK_EQUAL(4, *fourth);
+    }
+
+    TEST(pointers_stay_valid_as_the_pool_grows)
+    {
+        object_pool<test_object, 4> pool(system_arena::get_instance());
+        test_object* objects[100];
+        for (u64 i = 0u; i < 100u; ++i)
+        {
+            objects[i] = pool.create(i, u8(i));
+        }
+        CHECK_EQUAL(25u, pool.num_chunks());
+        for (u64 i = 0u; i < 100u; ++i)
+        {
+            CHECK_EQUAL(i, objects[i]->uint);
+            CHECK_EQUAL(u8(i), objects[i]->byte);
+            pool.release(objects[i]);
+        }
+        CHECK_EQUAL(0u, pool.size());
+        CHECK_EQUAL(25u, pool.num_chunks());
+    }
+
+    TEST(release_empty_chunks_keeps_the_chunks_in_use)
+    {
+        object_pool<int, 4> pool(system_arena::get_instance());
+        int* ints[12];
+        for (int i = 0; i < 12; ++i)
+        {
+            ints[i] = pool.create(i);
+        }
+        // empty the first and last chunks, and leave one object in the middle one
+        for (int i = 0; i < 12; ++i)
+        {
+            if (i != 6)
+            {
+                pool.release(ints[i]);
+            }
+        }
+        CHECK_EQUAL(2u, pool.release_empty_chunks());
+        CHECK_EQUAL(1u, pool.num_chunks());
+        CHECK_EQUAL(6, *ints[6]);
+
+        // the free list only holds elements of the remaining chunk
+        for (int i = 0; i < 3; ++i)
+        {
+            int* p = pool.create(i);
+            CHECK(p >= ints[4] && p <= ints[7]);
+        }
+        CHECK_EQUAL(1u, pool.num_chunks());
+        pool.create(100);
+        CHECK_EQUAL(2u, pool.num_chunks());
+    }
+
+    TEST(release_empty_chunks_counts_uncarved_elements_as_free)
+    {
+        object_pool<int, 4> pool(system_arena::get_instance());
+        int* a = pool.create(1);
+        pool.release(a);
+        CHECK_EQUAL(1u, pool.release_empty_chunks());
+        CHECK_EQUAL(0u, pool.num_chunks());
+        CHECK_EQUAL(0u, pool.release_empty_chunks());
+        CHECK(pool.create(2) != nullptr);
+    }
+
+    TEST(pool_returns_null_when_the_arena_is_full)
+    {
+        // room for three chunks of a header and eight elements of a chunk pointer and a u64
+        alignas(16) u8 memory[3u * 160u];
+        pool_arena arena(memory, sizeof(memory), 160u);
+        {
+            object_pool<u64, 8> pool(arena);
+            usize count = 0u;
+            while (pool.create(u64(count)))
+            {
+                ++count;
+            }
+            CHECK_EQUAL(24u, count);
+            CHECK_EQUAL(3u, pool.num_chunks());
+        }
+        CHECK_EQUAL(0u, arena.num_allocations());
+    }
+
+    TEST(for_each_live_visits_only_the_live_objects)
+    {
+        object_pool<int, 4> pool(system_arena::get_instance());
+        int* ints[10];
+        for (int i = 0; i < 10; ++i)
+        {
+            ints[i] = pool.create(i);
+        }
+        pool.release(ints[2]);
+        pool.release(ints[5]);
+
+        int sum = 0;
+        usize count = 0u;
+        pool.for_each_live([&](int& i) -> void { sum += i; ++count; });
+        CHECK_EQUAL(8u, count);
+        CHECK_EQUAL(45 - 2 - 5, sum);
+
+        // objects may be released during the iteration
+        pool.for_each_live([&](int& i) -> void
+        {
+            if (i % 2 == 0)
+            {
+                pool.release(&i);
+            }
+        });
+        CHECK_EQUAL(4u, pool.size());
+        pool.release_all();
+    }
+
+    TEST(create_n_writes_the_created_objects)
+    {
+        object_pool<test_object, 4> pool(system_arena::get_instance());
+        std::vector<test_object*> objects;
+        CHECK_EQUAL(10u, pool.create_n(10u, std::back_inserter(objects), u64(7u), u8(1u)));
+        CHECK_EQUAL(10u, objects.size());
+        CHECK_EQUAL(10u, pool.size());
+        CHECK_EQUAL(3u, pool.num_chunks());
+        for (test_object* obj : objects)
+        {
+            CHECK_EQUAL(7u, obj->uint);
+        }
+        pool.release_all();
+    }
+
+    TEST(release_all_destroys_the_live_objects)
+    {
+        static int destroyed = 0;
+        struct counted
+        {
+            ~counted() { ++destroyed; }
+        };
+
+        destroyed = 0;
+        object_pool<counted, 4> pool(system_arena::get_instance());
+        counted* objects[6];
+        for (counted*& obj : objects)
+        {
+            obj = pool.create();
+        }
+        pool.release(objects[0]);
+        CHECK_EQUAL(1, destroyed);
+        pool.release_all();
+        CHECK_EQUAL(6, destroyed);
+        CHECK_EQUAL(0u, pool.size());
+        CHECK_EQUAL(2u, pool.release_empty_chunks());
+
+        // the pool is usable again
+        CHECK(pool.create() != nullptr);
+        pool.release_all();
+    }
+
+    TEST(compact_moves_the_live_objects_to_the_front)
+    {
+        object_pool<int, 4> pool(system_arena::get_instance());
+        int* ints[12];
+        for (int i = 0; i < 12; ++i)
+        {
+            ints[i] = pool.create(i);
+        }
+        // leave holes in the first two chunks, and objects in the last one
+        pool.release(ints[0]);
+        pool.release(ints[5]);
+        pool.release(ints[6]);
+        pool.release(ints[9]);
+
+        std::vector<std::pair<int*, int*>> moves;
+        usize moved = pool.compact([&](int* from, int* to) -> void { moves.emplace_back(from, to); });
+        CHECK_EQUAL(3u, moved);
+        CHECK_EQUAL(moves.size(), moved);
+        // the last chunk's objects fill the holes, starting from its end
+        CHECK(moves[0] == std::make_pair(ints[11], ints[0]));
+        CHECK(moves[1] == std::make_pair(ints[10], ints[5]));
+        CHECK(moves[2] == std::make_pair(ints[8], ints[6]));
+
+        // the live objects are the first eight, in two full chunks
+        std::vector<int> values;
+        pool.for_each_live([&](int& i) -> void { values.push_back(i); });
+        CHECK_EQUAL(8u, values.size());
+        CHECK_EQUAL(1u, pool.release_empty_chunks());
+        CHECK_EQUAL(2u, pool.num_chunks());
+        int sum = 0;
+        for (int i : values)
+        {
+            sum += i;
+        }
+        CHECK_EQUAL(66 - 0 - 5 - 6 - 9, sum);
+
+        // the first two chunks are full, so the next object needs a new chunk
+        CHECK(pool.create(100) != nullptr);
+        CHECK_EQUAL(3u, pool.num_chunks());
+        pool.release_all();
     }
 }
 
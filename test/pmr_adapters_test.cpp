@@ -0,0 +1,118 @@
+#include "aliases.h"
+#include "linear_arena.h"
+#include "memory_arena.h"
+#include "pmr_adapters.h"
+#include "UnitTest++/UnitTest++.h"
+
+#include "stl/vector.h"
+
+#ifdef NLRS_HAS_MEMORY_RESOURCE
+
+#include <vector>
+
+namespace nlrs
+{
+
+struct pmr_memory_container
+{
+    pmr_memory_container()
+        : arena(memory, sizeof(memory)),
+        resource(arena)
+    {}
+
+    alignas(16) u8 memory[64u * 1024u];
+    free_list_arena arena;
+    arena_memory_resource resource;
+};
+
+SUITE(pmr_adapters_test)
+{
+    TEST_FIXTURE(pmr_memory_container, standard_containers_allocate_from_the_arena)
+    {
+        std::pmr::vector<u32> vec(&resource);
+        vec.resize(100u);
+        u8* data = reinterpret_cast<u8*>(vec.data());
+        CHECK(data >= memory && data < memory + sizeof(memory));
+    }
+
+    TEST_FIXTURE(pmr_memory_container, resources_over_the_same_arena_are_equal)
+    {
+        arena_memory_resource other(arena);
+        CHECK(resource.is_equal(other));
+        CHECK(!resource.is_equal(*std::pmr::new_delete_resource()));
+    }
+
+    TEST_FIXTURE(pmr_memory_container, pool_resource_can_be_layered_over_the_arena)
+    {
+        std::pmr::unsynchronized_pool_resource pool(&resource);
+        std::vector<void*> ptrs;
+        for (usize i = 0u; i < 100u; ++i)
+        {
+            ptrs.push_back(pool.allocate(32u, 8u));
+        }
+        for (void* ptr : ptrs)
+        {
+            pool.deallocate(ptr, 32u, 8u);
+        }
+        pool.release();
+    }
+
+    TEST_FIXTURE(pmr_memory_container, empty_requests_get_a_block)
+    {
+        void* ptr = resource.allocate(0u, 8u);
+        CHECK(ptr != nullptr);
+        resource.deallocate(ptr, 0u, 8u);
+    }
+
+    TEST(arena_allocates_from_the_resource)
+    {
+        alignas(64) u8 buffer[4096];
+        std::pmr::monotonic_buffer_resource monotonic(buffer, sizeof(buffer), std::pmr::null_memory_resource());
+        memory_resource_arena arena(&monotonic);
+
+        u8* ptr = static_cast<u8*>(arena.allocate(100u, 64u));
+        CHECK(ptr >= buffer && ptr < buffer + sizeof(buffer));
+        CHECK_EQUAL(0u, reinterpret_cast<uptr>(ptr) & 63u);
+        CHECK(arena.allocate(0u) == nullptr);
+        arena.free(ptr);
+
+        // the monotonic resource is exhausted
+        CHECK(arena.allocate(8000u) == nullptr);
+    }
+
+    TEST(arena_reallocates_and_preserves_contents)
+    {
+        memory_resource_arena arena(std::pmr::new_delete_resource());
+        u32* ptr = static_cast<u32*>(arena.allocate(4u * sizeof(u32)));
+        for (u32 i = 0u; i < 4u; ++i)
+        {
+            ptr[i] = i;
+        }
+        CHECK_EQUAL(static_cast<void*>(ptr), arena.reallocate(ptr, 2u * sizeof(u32)));
+
+        u32* moved = static_cast<u32*>(arena.reallocate(ptr, 1000u * sizeof(u32)));
+        for (u32 i = 0u; i < 4u; ++i)
+        {
+            CHECK_EQUAL(i, moved[i]);
+        }
+        arena.free(moved, 1000u * sizeof(u32), alignof(u32));
+    }
+
+    TEST(library_containers_can_use_standard_resources)
+    {
+        std::pmr::unsynchronized_pool_resource pool;
+        memory_resource_arena arena(&pool);
+        {
+            pmr::vector<u64> vec{ polymorphic_allocator<u64>(arena) };
+            for (u64 i = 0u; i < 1000u; ++i)
+            {
+                vec.push_back(i);
+            }
+            CHECK_EQUAL(999u, vec.back());
+        }
+    }
+}
+
+}
+
+#endif
@@ -0,0 +1,109 @@
+#include "aliases.h"
+#include "memory_arena.h"
+#include "pool_arena.h"
+#include "UnitTest++/UnitTest++.h"
+
+#include <list>
+
+namespace nlrs
+{
+
+struct pool_memory_container
+{
+    pool_memory_container()
+        : arena(memory, sizeof(memory), 24u)
+    {}
+
+    alignas(16) u8 memory[24u * 16u];
+    pool_arena arena;
+};
+
+SUITE(pool_arena_test)
+{
+    TEST_FIXTURE(pool_memory_container, chunks_are_contiguous)
+    {
+        CHECK_EQUAL(24u, arena.chunk_size());
+        CHECK_EQUAL(16u, arena.capacity());
+
+        u8* first = static_cast<u8*>(arena.allocate(24u));
+        u8* second = static_cast<u8*>(arena.allocate(10u));
+        CHECK_EQUAL(memory, first);
+        CHECK_EQUAL(memory + 24, second);
+        CHECK_EQUAL(2u, arena.num_allocations());
+
+        arena.free(first);
+        arena.free(second, 10u);
+        CHECK_EQUAL(0u, arena.num_allocations());
+    }
+
+    TEST_FIXTURE(pool_memory_container, freed_chunks_are_reused_first)
+    {
+        void* first = arena.allocate(8u);
+        void* second = arena.allocate(8u);
+        arena.free(first);
+        CHECK_EQUAL(first, arena.allocate(8u));
+        arena.free(first);
+        arena.free(second);
+    }
+
+    TEST_FIXTURE(pool_memory_container, exhausted_pool_returns_null)
+    {
+        void* ptrs[16];
+        for (void*& ptr : ptrs)
+        {
+            ptr = arena.allocate(16u);
+            CHECK(ptr != nullptr);
+        }
+        CHECK(arena.allocate(16u) == nullptr);
+        for (void* ptr : ptrs)
+        {
+            arena.free(ptr);
+        }
+    }
+
+    TEST_FIXTURE(pool_memory_container, reallocation_within_chunk_is_in_place)
+    {
+        void* ptr = arena.allocate(8u);
+        CHECK_EQUAL(ptr, arena.reallocate(ptr, 24u));
+        arena.free(ptr);
+    }
+
+    TEST_FIXTURE(pool_memory_container, requests_which_do_not_fit_a_chunk_return_null)
+    {
+        CHECK(arena.allocate(25u) == nullptr);
+        CHECK(arena.allocate(8u, 64u) == nullptr);
+        void* ptr = arena.allocate(8u);
+        CHECK(arena.reallocate(ptr, 25u) == nullptr);
+        CHECK_EQUAL(1u, arena.num_allocations());
+        arena.free(ptr);
+    }
+
+    TEST(chunk_size_is_rounded_to_alignment)
+    {
+        alignas(64) static u8 memory[1024u];
+        pool_arena arena(memory + 8, sizeof(memory) - 8u, 20u, 32u);
+        CHECK_EQUAL(32u, arena.chunk_size());
+        CHECK_EQUAL(31u, arena.capacity());
+        void* ptr = arena.allocate(20u, 32u);
+        CHECK_EQUAL(0u, reinterpret_cast<uptr>(ptr) % 32u);
+        arena.free(ptr);
+    }
+
+    TEST(list_nodes_fit_in_pool)
+    {
+        alignas(16) static u8 node_memory[64u * 1024u];
+        pool_arena nodes(node_memory, sizeof(node_memory), 32u);
+        {
+            std::list<u64, polymorphic_allocator<u64>> list{ polymorphic_allocator<u64>(nodes) };
+            for (u64 i = 0u; i < 100u; ++i)
+            {
+                list.push_back(i);
+            }
+            CHECK_EQUAL(100u, nodes.num_allocations());
+            CHECK_EQUAL(99u, list.back());
+        }
+        CHECK_EQUAL(0u, nodes.num_allocations());
+    }
+}
+
+}
@@ -0,0 +1,303 @@
+#include "aliases.h"
+#include "random.h"
+#include "relocatable_heap.h"
+#include "UnitTest++/UnitTest++.h"
+
+#include <cstring>
+#include <vector>
+
+namespace nlrs
+{
+
+struct relocatable_heap_container
+{
+    relocatable_heap_container()
+        : heap(memory, sizeof(memory), 64u)
+    {}
+
+    alignas(16) u8 memory[16u * 1024u];
+    relocatable_heap heap;
+};
+
+namespace
+{
+
+void fill(relocatable_heap& heap, relocatable_heap::handle h, usize bytes, u8 value)
+{
+    std::memset(heap.get(h), value, bytes);
+}
+
+bool holds(const relocatable_heap& heap, relocatable_heap::handle h, usize bytes, u8 value)
+{
+    const u8* p = static_cast<const u8*>(heap.get(h));
+    for (usize i = 0u; i < bytes; ++i)
+    {
+        if (p[i] != value)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+}
+
+SUITE(relocatable_heap_test)
+{
+    TEST_FIXTURE(relocatable_heap_container, blocks_are_aligned_and_sized)
+    {
+        relocatable_heap::handle a = heap.allocate(1u);
+        relocatable_heap::handle b = heap.allocate(100u);
+        CHECK(a);
+        CHECK(b);
+        CHECK(a != b);
+        CHECK_EQUAL(0u, uptr(heap.get(a)) % 16u);
+        CHECK_EQUAL(0u, uptr(heap.get(b)) % 16u);
+        CHECK(heap.size(a) >= 1u);
+        CHECK(heap.size(b) >= 100u);
+        CHECK_EQUAL(2u, heap.num_allocations());
+        heap.free(a);
+        heap.free(b);
+        CHECK_EQUAL(0u, heap.num_allocations());
+        CHECK_EQUAL(heap.capacity(), heap.free_bytes());
+    }
+
+    TEST_FIXTURE(relocatable_heap_container, freed_handles_are_invalid)
+    {
+        relocatable_heap::handle a = heap.allocate(64u);
+        CHECK(heap.is_valid(a));
+        heap.free(a);
+        CHECK(!heap.is_valid(a));
+
+        // the entry is reused, but with a new generation
+        relocatable_heap::handle b = heap.allocate(64u);
+        CHECK_EQUAL(a.index, b.index);
+        CHECK(a != b);
+        CHECK(!heap.is_valid(a));
+        CHECK(!heap.is_valid(relocatable_heap::invalid_handle));
+        heap.free(b);
+    }
+
+    TEST_FIXTURE(relocatable_heap_container, running_out_of_space_returns_an_invalid_handle)
+    {
+        CHECK(!heap.allocate(0u));
+        CHECK(!heap.allocate(heap.capacity()));
+
+        std::vector<relocatable_heap::handle> handles;
+        while (relocatable_heap::handle h = heap.allocate(1000u))
+        {
+            handles.push_back(h);
+        }
+        CHECK(!handles.empty());
+        for (relocatable_heap::handle h : handles)
+        {
+            heap.free(h);
+        }
+    }
+
+    TEST_FIXTURE(relocatable_heap_container, freed_neighbours_merge)
+    {
+        relocatable_heap::handle a = heap.allocate(1000u);
+        relocatable_heap::handle b = heap.allocate(1000u);
+        relocatable_heap::handle c = heap.allocate(1000u);
+        relocatable_heap::handle d = heap.allocate(1000u);
+        heap.free(a);
+        heap.free(c);
+        heap.free(b);
+
+        // the three blocks make a single free block, where d's neighbour used to be
+        relocatable_heap::handle e = heap.allocate(3u * 1024u - 16u);
+        CHECK(e);
+        CHECK_EQUAL(static_cast<u8*>(heap.get(d)) - 3u * 1024u, heap.get(e));
+        heap.free(d);
+        heap.free(e);
+        CHECK_EQUAL(heap.capacity(), heap.free_bytes());
+    }
+
+    TEST_FIXTURE(relocatable_heap_container, defragment_closes_the_holes)
+    {
+        std::vector<relocatable_heap::handle> handles;
+        for (usize i = 0u; i < 12u; ++i)
+        {
+            handles.push_back(heap.allocate(1000u));
+            fill(heap, handles.back(), 1000u, u8(i));
+        }
+        for (usize i = 0u; i < handles.size(); i += 2u)
+        {
+            heap.free(handles[i]);
+        }
+        usize largest_before = heap.largest_free_block();
+
+        CHECK(heap.defragment(heap.capacity()) > 0u);
+        CHECK_EQUAL(0u, heap.defragment(heap.capacity()));
+        CHECK(heap.largest_free_block() > largest_before);
+        CHECK_EQUAL(heap.free_bytes() - 16u, heap.largest_free_block());
+
+        for (usize i = 1u; i < handles.size(); i += 2u)
+        {
+            CHECK(holds(heap, handles[i], 1000u, u8(i)));
+            heap.free(handles[i]);
+        }
+    }
+
+    TEST_FIXTURE(relocatable_heap_container, defragment_makes_room_for_a_large_block)
+    {
+        std::vector<relocatable_heap::handle> handles;
+        while (relocatable_heap::handle h = heap.allocate(500u))
+        {
+            handles.push_back(h);
+        }
+        for (usize i = 0u; i < handles.size(); i += 2u)
+        {
+            heap.free(handles[i]);
+        }
+        CHECK(!heap.allocate(2000u));
+
+        heap.defragment(heap.capacity());
+        relocatable_heap::handle large = heap.allocate(2000u);
+        CHECK(large);
+        heap.free(large);
+        for (usize i = 1u; i < handles.size(); i += 2u)
+        {
+            heap.free(handles[i]);
+        }
+    }
+
+    TEST_FIXTURE(relocatable_heap_container, defragment_respects_the_budget)
+    {
+        std::vector<relocatable_heap::handle> handles;
+        for (usize i = 0u; i < 8u; ++i)
+        {
+            handles.push_back(heap.allocate(1000u));
+            fill(heap, handles.back(), 1000u, u8(i));
+        }
+        heap.free(handles[0]);
+
+        // each call moves a single block
+        usize num_calls = 0u;
+        while (usize moved = heap.defragment(1500u))
+        {
+            CHECK(moved <= 1500u);
+            ++num_calls;
+        }
+        CHECK_EQUAL(7u, num_calls);
+
+        for (usize i = 1u; i < handles.size(); ++i)
+        {
+            CHECK(holds(heap, handles[i], 1000u, u8(i)));
+            heap.free(handles[i]);
+        }
+    }
+
+    TEST_FIXTURE(relocatable_heap_container, pinned_blocks_stay_in_place)
+    {
+        relocatable_heap::handle a = heap.allocate(1000u);
+        relocatable_heap::handle b = heap.allocate(1000u);
+        relocatable_heap::handle c = heap.allocate(1000u);
+        relocatable_heap::handle d = heap.allocate(1000u);
+        fill(heap, d, 1000u, 0xddu);
+        heap.free(a);
+        heap.free(c);
+
+        {
+            relocatable_heap::scoped_pin pin(heap, b);
+            CHECK(heap.is_pinned(b));
+            void* before = pin.get();
+            heap.defragment(heap.capacity());
+            CHECK_EQUAL(before, heap.get(b));
+            // the block behind the pinned one is still compacted
+            CHECK_EQUAL(static_cast<u8*>(before) + 1024, heap.get(d));
+            CHECK(holds(heap, d, 1000u, 0xddu));
+        }
+        CHECK(!heap.is_pinned(b));
+
+        // once unpinned, the block can move
+        CHECK(heap.defragment(heap.capacity()) > 0u);
+        CHECK_EQUAL(static_cast<void*>(memory + 64u * 16u + 16u), heap.get(b));
+        CHECK(holds(heap, d, 1000u, 0xddu));
+        heap.free(b);
+        heap.free(d);
+    }
+
+    TEST_FIXTURE(relocatable_heap_container, defragment_resumes_past_a_pinned_block)
+    {
+        std::vector<relocatable_heap::handle> handles;
+        for (usize i = 0u; i < 8u; ++i)
+        {
+            handles.push_back(heap.allocate(1000u));
+            fill(heap, handles.back(), 1000u, u8(i));
+        }
+        heap.free(handles[0]);
+        heap.free(handles[2]);
+
+        {
+            relocatable_heap::scoped_pin pin(heap, handles[1]);
+            // each call moves a single block from behind the pinned one
+            usize num_calls = 0u;
+            while (heap.defragment(1500u))
+            {
+                ++num_calls;
+            }
+            CHECK_EQUAL(5u, num_calls);
+            CHECK_EQUAL(pin.get(), heap.get(handles[1]));
+        }
+
+        // once unpinned, the next calls start over from the hole in front of it
+        CHECK(heap.defragment(heap.capacity()) > 0u);
+        CHECK_EQUAL(0u, heap.defragment(heap.capacity()));
+        CHECK_EQUAL(static_cast<void*>(memory + 64u * 16u + 16u), heap.get(handles[1]));
+        for (usize i = 1u; i < handles.size(); ++i)
+        {
+            if (i != 2u)
+            {
+                CHECK(holds(heap, handles[i], 1000u, u8(i)));
+                heap.free(handles[i]);
+            }
+        }
+    }
+
+    TEST_FIXTURE(relocatable_heap_container, random_operations_keep_the_contents)
+    {
+        nlrs::random<usize> rng;
+        rng.seed(42u);
+        std::vector<relocatable_heap::handle> handles;
+        std::vector<usize> sizes;
+        for (usize i = 0u; i < 5000u; ++i)
+        {
+            usize op = rng(0u, 9u);
+            if (op < 5u)
+            {
+                usize size = rng(1u, 600u);
+                relocatable_heap::handle h = heap.allocate(size);
+                if (h)
+                {
+                    fill(heap, h, size, u8(h.index));
+                    handles.push_back(h);
+                    sizes.push_back(size);
+                }
+            }
+            else if (op < 9u && !handles.empty())
+            {
+                usize j = rng(0u, handles.size() - 1u);
+                CHECK(holds(heap, handles[j], sizes[j], u8(handles[j].index)));
+                heap.free(handles[j]);
+                handles[j] = handles.back();
+                sizes[j] = sizes.back();
+                handles.pop_back();
+                sizes.pop_back();
+            }
+            else
+            {
+                heap.defragment(rng(0u, 2000u));
+            }
+        }
+        for (usize j = 0u; j < handles.size(); ++j)
+        {
+            CHECK(holds(heap, handles[j], sizes[j], u8(handles[j].index)));
+            heap.free(handles[j]);
+        }
+        CHECK_EQUAL(heap.capacity(), heap.free_bytes());
+    }
+}
+
+}
@@ -0,0 +1,182 @@
+#include "aliases.h"
+#include "memory_arena.h"
+#include "sharded_arena.h"
+#include "UnitTest++/UnitTest++.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace nlrs
+{
+
+struct sharded_memory_container
+{
+    sharded_memory_container()
+        : memory(std::malloc(16 * 1024 * 1024)),
+        arena(new sharded_arena(memory, 16 * 1024 * 1024, 4u))
+    {}
+
+    ~sharded_memory_container()
+    {
+        delete arena;
+        std::free(memory);
+    }
+
+    void* memory;
+    sharded_arena* arena;
+};
+
+SUITE(sharded_arena_test)
+{
+    TEST_FIXTURE(sharded_memory_container, blocks_come_from_the_home_shard)
+    {
+        void* block = arena->allocate(100u);
+        CHECK_EQUAL(arena->home_shard(), arena->shard_of(block));
+        arena->free(block, 100u);
+    }
+
+    TEST_FIXTURE(sharded_memory_container, threads_get_different_shards)
+    {
+        usize shards[2];
+        std::thread first([&]() -> void { shards[0] = arena->home_shard(); });
+        first.join();
+        std::thread second([&]() -> void { shards[1] = arena->home_shard(); });
+        second.join();
+        CHECK(shards[0] != shards[1]);
+    }
+
+    TEST_FIXTURE(sharded_memory_container, remote_frees_are_drained_by_home_shard)
+    {
+        void* block = arena->allocate(64u);
+        std::thread other([&]() -> void { arena->free(block); });
+        other.join();
+
+        // the block waits in the queue until this thread allocates again
+        void* next = arena->allocate(64u);
+        CHECK_EQUAL(block, next);
+        arena->free(next);
+    }
+
+    TEST_FIXTURE(sharded_memory_container, reallocate_moves_remote_blocks_to_home_shard)
+    {
+        u8* block = static_cast<u8*>(arena->allocate(32u));
+        std::memset(block, 5, 32u);
+        u8* moved = nullptr;
+        usize moved_shard = 0u;
+        usize other_home = 0u;
+        std::thread other([&]() -> void
+        {
+            moved = static_cast<u8*>(arena->reallocate(block, 1000u));
+            moved_shard = arena->shard_of(moved);
+            other_home = arena->home_shard();
+            arena->free(moved);
+        });
+        other.join();
+        CHECK_EQUAL(other_home, moved_shard);
+    }
+
+    TEST_FIXTURE(sharded_memory_container, reallocating_remote_blocks_keeps_alignment_and_contents)
+    {
+        u8* block = static_cast<u8*>(arena->allocate(48u, 64u));
+        for (u8 i = 0u; i < 48u; ++i)
+        {
+            block[i] = i;
+        }
+        u8* grown = nullptr;
+        u8* shrunk = nullptr;
+        std::thread other([&]() -> void
+        {
+            grown = static_cast<u8*>(arena->reallocate(block, 4096u));
+        });
+        other.join();
+        CHECK_EQUAL(0u, usize(grown) % 64u);
+        for (u8 i = 0u; i < 48u; ++i)
+        {
+            CHECK_EQUAL(i, grown[i]);
+        }
+
+        std::thread another([&]() -> void
+        {
+            shrunk = static_cast<u8*>(arena->reallocate(grown, 16u));
+        });
+        another.join();
+        CHECK_EQUAL(0u, usize(shrunk) % 64u);
+        for (u8 i = 0u; i < 16u; ++i)
+        {
+            CHECK_EQUAL(i, shrunk[i]);
+        }
+        arena->free(shrunk);
+    }
+
+    TEST_FIXTURE(sharded_memory_container, blocks_can_be_used_and_freed_across_threads)
+    {
+        const int num_threads = 4;
+        const int num_blocks = 2000;
+        std::vector<void*> handoff(num_threads * num_blocks, nullptr);
+        std::atomic<int> errors{ 0 };
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < num_threads; ++t)
+        {
+            threads.emplace_back([&, t]() -> void
+            {
+                for (int i = 0; i < num_blocks; ++i)
+                {
+                    usize size = usize(8 + (i % 100) * 8);
+                    u8* block = static_cast<u8*>(arena->allocate(size));
+                    std::memset(block, t, size);
+                    handoff[t * num_blocks + i] = block;
+                }
+            });
+        }
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+        threads.clear();
+
+        // free every block on a different thread than the one which allocated it, while
+        // the threads keep allocating from their own shards
+        for (int t = 0; t < num_threads; ++t)
+        {
+            threads.emplace_back([&, t]() -> void
+            {
+                int source = (t + 1) % num_threads;
+                for (int i = 0; i < num_blocks; ++i)
+                {
+                    u8* block = static_cast<u8*>(handoff[source * num_blocks + i]);
+                    if (block[0] != u8(source))
+                    {
+                        ++errors;
+                    }
+                    arena->free(block);
+                    arena->free(arena->allocate(16u));
+                }
+            });
+        }
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+
+        CHECK_EQUAL(0, errors.load());
+        arena->drain_remote_frees();
+    }
+
+#ifdef NLRS_ARENA_STATS
+    TEST_FIXTURE(sharded_memory_container, stats_sum_the_shards)
+    {
+        void* block = arena->allocate(100u);
+        usize free_before = arena->stats().free_bytes;
+        CHECK_EQUAL(1u, arena->stats().num_allocations);
+        arena->free(block);
+        CHECK_EQUAL(0u, arena->stats().num_allocations);
+        CHECK(arena->stats().free_bytes > free_before);
+    }
+#endif
+}
+
+}
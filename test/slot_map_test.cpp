@@ -0,0 +1,227 @@
+#include "aliases.h"
+#include "linear_arena.h"
+#include "memory_arena.h"
+#include "random.h"
+#include "slot_map.h"
+#include "UnitTest++/UnitTest++.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace nlrs
+{
+
+SUITE(slot_map_test)
+{
+    struct int_slot_map
+    {
+        int_slot_map()
+            : map(system_arena::get_instance(), 4u)
+        {}
+
+        slot_map<int> map;
+    };
+
+    TEST_FIXTURE(int_slot_map, inserted_objects_are_reachable_by_handle)
+    {
+        slot_map<int>::handle a = map.insert(1);
+        slot_map<int>::handle b = map.insert(2);
+        CHECK(a);
+        CHECK(a != b);
+        CHECK_EQUAL(2u, map.size());
+        CHECK_EQUAL(1, map[a]);
+        CHECK_EQUAL(2, *map.get(b));
+        CHECK(map.contains(a));
+    }
+
+    TEST_FIXTURE(int_slot_map, erased_handles_are_stale)
+    {
+        slot_map<int>::handle a = map.insert(1);
+        map.erase(a);
+        CHECK(!map.contains(a));
+        CHECK(map.get(a) == nullptr);
+
+        // the slot is reused with a new generation, so the old handle stays stale
+        slot_map<int>::handle b = map.insert(2);
+        CHECK_EQUAL(a.index, b.index);
+        CHECK(a != b);
+        CHECK(map.get(a) == nullptr);
+        CHECK_EQUAL(2, map[b]);
+        CHECK(!map.contains(slot_map<int>::handle{ 0u, 0u }));
+    }
+
+    TEST_FIXTURE(int_slot_map, erasing_a_stale_handle_does_nothing)
+    {
+        slot_map<int>::handle a = map.insert(1);
+        map.erase(a);
+        slot_map<int>::handle b = map.insert(2);
+        map.erase(a);
+        CHECK_EQUAL(1u, map.size());
+        CHECK_EQUAL(2, map[b]);
+    }
+
+    TEST_FIXTURE(int_slot_map, erase_keeps_the_objects_dense)
+    {
+        slot_map<int>::handle handles[4];
+        for (int i = 0; i < 4; ++i)
+        {
+            handles[i] = map.insert(i);
+        }
+        map.erase(handles[1]);
+        CHECK_EQUAL(3u, map.size());
+        CHECK_EQUAL(3, map.data()[1]);
+        CHECK(map.handle_at(1u) == handles[3]);
+        CHECK_EQUAL(3, map[handles[3]]);
+
+        int sum = 0;
+        for (int i : map)
+        {
+            sum += i;
+        }
+        CHECK_EQUAL(0 + 2 + 3, sum);
+    }
+
+    TEST_FIXTURE(int_slot_map, handles_survive_growth)
+    {
+        std::vector<slot_map<int>::handle> handles;
+        for (int i = 0; i < 100; ++i)
+        {
+            handles.push_back(map.insert(i));
+        }
+        CHECK(map.capacity() >= 100u);
+        for (int i = 0; i < 100; ++i)
+        {
+            CHECK_EQUAL(i, map[handles[i]]);
+        }
+    }
+
+    TEST_FIXTURE(int_slot_map, handles_round_trip_through_integers)
+    {
+        slot_map<int>::handle a = map.insert(5);
+        u64 value = a.value();
+        CHECK(value != 0u);
+        CHECK(slot_map<int>::handle::from_value(value) == a);
+        CHECK(!slot_map<int>::handle::from_value(0u));
+    }
+
+    TEST_FIXTURE(int_slot_map, clear_invalidates_all_handles)
+    {
+        slot_map<int>::handle a = map.insert(1);
+        slot_map<int>::handle b = map.insert(2);
+        map.clear();
+        CHECK(map.empty());
+        CHECK(!map.contains(a));
+        CHECK(!map.contains(b));
+        slot_map<int>::handle c = map.insert(3);
+        CHECK_EQUAL(3, map[c]);
+    }
+
+    TEST(objects_are_destroyed_and_moved)
+    {
+        slot_map<std::string> map(system_arena::get_instance(), 2u);
+        std::vector<slot_map<std::string>::handle> handles;
+        for (int i = 0; i < 20; ++i)
+        {
+            handles.push_back(map.insert(std::string(32u, char('a' + i))));
+        }
+        for (int i = 0; i < 20; i += 3)
+        {
+            map.erase(handles[i]);
+        }
+        for (int i = 0; i < 20; ++i)
+        {
+            if (i % 3 == 0)
+            {
+                CHECK(!map.contains(handles[i]));
+            }
+            else
+            {
+                CHECK(map[handles[i]] == std::string(32u, char('a' + i)));
+            }
+        }
+    }
+
+    TEST(inserting_an_object_of_a_full_map_copies_it_before_growing)
+    {
+        slot_map<std::string> map(system_arena::get_instance(), 2u);
+        slot_map<std::string>::handle a = map.insert(std::string(32u, 'a'));
+        map.insert(std::string(32u, 'b'));
+        CHECK_EQUAL(map.size(), map.capacity());
+        slot_map<std::string>::handle c = map.insert(map[a]);
+        CHECK(map[c] == std::string(32u, 'a'));
+        CHECK(map[a] == std::string(32u, 'a'));
+    }
+
+    TEST(running_out_of_memory_returns_the_invalid_handle)
+    {
+        alignas(16) u8 memory[256];
+        linear_arena arena(memory, sizeof(memory));
+        slot_map<int> map(arena, 8u);
+        std::vector<slot_map<int>::handle> handles;
+        for (int i = 0; i < 8; ++i)
+        {
+            handles.push_back(map.insert(i));
+        }
+        slot_map<int>::handle h = map.insert(8);
+        CHECK(!h);
+        CHECK_EQUAL(8u, map.size());
+        for (int i = 0; i < 8; ++i)
+        {
+            CHECK_EQUAL(i, map[handles[i]]);
+        }
+    }
+
+    TEST(objects_without_a_move_constructor_are_copied)
+    {
+        struct copy_only
+        {
+            copy_only(int v) : value(v) {}
+            copy_only(const copy_only&) = default;
+            copy_only(copy_only&&) = delete;
+            int value;
+        };
+
+        slot_map<copy_only> map(system_arena::get_instance(), 1u);
+        slot_map<copy_only>::handle a = map.emplace(1);
+        slot_map<copy_only>::handle b = map.emplace(2);
+        map.erase(a);
+        CHECK_EQUAL(2, map[b].value);
+    }
+
+    TEST_FIXTURE(int_slot_map, random_operations_match_a_reference)
+    {
+        nlrs::random<int> rng;
+        rng.seed(7u);
+        std::unordered_map<u64, int> reference;
+        std::vector<slot_map<int>::handle> handles;
+        for (int i = 0; i < 10000; ++i)
+        {
+            if (handles.empty() || rng(0, 2) > 0)
+            {
+                slot_map<int>::handle h = map.insert(i);
+                handles.push_back(h);
+                reference[h.value()] = i;
+            }
+            else
+            {
+                usize j = usize(rng(0, int(handles.size()) - 1));
+                map.erase(handles[j]);
+                reference.erase(handles[j].value());
+                handles[j] = handles.back();
+                handles.pop_back();
+            }
+        }
+        CHECK_EQUAL(reference.size(), map.size());
+        for (slot_map<int>::handle h : handles)
+        {
+            CHECK_EQUAL(reference[h.value()], map[h]);
+        }
+        for (usize i = 0u; i < map.size(); ++i)
+        {
+            CHECK_EQUAL(reference[map.handle_at(i).value()], map.data()[i]);
+        }
+    }
+}
+
+}
@@ -0,0 +1,180 @@
+#include "aliases.h"
+#include "literals.h"
+#include "memory_arena.h"
+#include "small_array.h"
+#include "UnitTest++/UnitTest++.h"
+
+#include <cstdlib>
+#include <utility>
+
+namespace nlrs
+{
+
+SUITE(small_array_test)
+{
+    // Counts the live objects, and has a move constructor, so that it is not trivially
+    // relocatable.
+    struct counted
+    {
+        static int num_live;
+
+        int value;
+
+        counted(int v)
+            : value(v)
+        {
+            ++num_live;
+        }
+        counted(const counted& other)
+            : value(other.value)
+        {
+            ++num_live;
+        }
+        counted(counted&& other) noexcept
+            : value(other.value)
+        {
+            other.value = -1;
+            ++num_live;
+        }
+        ~counted()
+        {
+            --num_live;
+        }
+    };
+
+    int counted::num_live = 0;
+
+    struct array_with_arena
+    {
+        array_with_arena()
+            : memory(std::malloc(4096u)),
+            arena(memory, 4096u)
+        {}
+
+        ~array_with_arena()
+        {
+            std::free(memory);
+        }
+
+        void* memory;
+        free_list_arena arena;
+    };
+
+    TEST_FIXTURE(array_with_arena, elements_up_to_the_inline_capacity_do_not_allocate)
+    {
+        small_array<int, 4> ints(arena);
+        for (int i = 0; i < 4; ++i)
+        {
+            CHECK_EQUAL(usize(i), ints.push_back(i));
+        }
+        CHECK(ints.is_inline());
+        CHECK_EQUAL(0u, arena.num_allocations());
+        for (int i = 0; i < 4; ++i)
+        {
+            CHECK_EQUAL(i, ints[usize(i)]);
+        }
+    }
+
+    TEST_FIXTURE(array_with_arena, elements_past_the_inline_capacity_spill_to_the_arena)
+    {
+        {
+            small_array<int, 4> ints(arena);
+            for (int i = 0; i < 20; ++i)
+            {
+                ints.push_back(i);
+            }
+            CHECK(!ints.is_inline());
+            CHECK_EQUAL(32_sz, ints.capacity());
+            CHECK_EQUAL(1u, arena.num_allocations());
+            for (int i = 0; i < 20; ++i)
+            {
+                CHECK_EQUAL(i, ints[usize(i)]);
+            }
+            ints.clear();
+            CHECK_EQUAL(32_sz, ints.capacity());
+        }
+        CHECK_EQUAL(0u, arena.num_allocations());
+    }
+
+    TEST(push_back_of_an_element_survives_the_spill)
+    {
+        small_array<int, 2> ints;
+        ints.push_back(7);
+        for (int i = 0; i < 10; ++i)
+        {
+            ints.push_back(ints[0u]);
+        }
+        for (int value : ints)
+        {
+            CHECK_EQUAL(7, value);
+        }
+    }
+
+    TEST(elements_which_are_not_trivially_relocatable_are_moved)
+    {
+        {
+            small_array<counted, 3> objects;
+            for (int i = 0; i < 10; ++i)
+            {
+                objects.emplace_back(i);
+            }
+            CHECK_EQUAL(10, counted::num_live);
+            for (int i = 0; i < 10; ++i)
+            {
+                CHECK_EQUAL(i, objects[usize(i)].value);
+            }
+            objects.pop_back();
+            CHECK_EQUAL(9, counted::num_live);
+        }
+        CHECK_EQUAL(0, counted::num_live);
+    }
+
+    TEST(copies_are_independent)
+    {
+        {
+            small_array<counted, 3> inline_objects{ counted(1), counted(2) };
+            small_array<counted, 3> spilled{ counted(1), counted(2), counted(3), counted(4) };
+            small_array<counted, 3> inline_copy(inline_objects);
+            small_array<counted, 3> spilled_copy(spilled);
+            spilled_copy[0u].value = 10;
+            CHECK(inline_copy.is_inline());
+            CHECK_EQUAL(2_sz, inline_copy.size());
+            CHECK_EQUAL(4_sz, spilled_copy.size());
+            CHECK_EQUAL(1, spilled[0u].value);
+            CHECK_EQUAL(4, spilled_copy[3u].value);
+
+            inline_copy = spilled;
+            CHECK_EQUAL(4_sz, inline_copy.size());
+            CHECK_EQUAL(14, counted::num_live);
+        }
+        CHECK_EQUAL(0, counted::num_live);
+    }
+
+    TEST(moving_a_spilled_array_takes_its_memory)
+    {
+        small_array<counted, 2> objects{ counted(1), counted(2), counted(3) };
+        const counted* data = objects.data();
+        small_array<counted, 2> moved(std::move(objects));
+        CHECK(moved.data() == data);
+        CHECK_EQUAL(3_sz, moved.size());
+        CHECK_EQUAL(0_sz, objects.size());
+        CHECK(objects.is_inline());
+        CHECK_EQUAL(3, counted::num_live);
+    }
+
+    TEST(moving_an_inline_array_moves_its_elements)
+    {
+        small_array<counted, 4> objects{ counted(1), counted(2) };
+        small_array<counted, 4> moved;
+        moved.emplace_back(5);
+        moved = std::move(objects);
+        CHECK(moved.is_inline());
+        CHECK_EQUAL(2_sz, moved.size());
+        CHECK_EQUAL(1, moved[0u].value);
+        CHECK_EQUAL(2, moved[1u].value);
+        CHECK_EQUAL(0_sz, objects.size());
+        CHECK_EQUAL(2, counted::num_live);
+    }
+}
+
+}
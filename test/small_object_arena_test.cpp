@@ -0,0 +1,149 @@
+#include "aliases.h"
+#include "memory_arena.h"
+#include "small_object_arena.h"
+#include "UnitTest++/UnitTest++.h"
+
+#include "stl/unordered_map.h"
+
+#include <cstring>
+#include <vector>
+
+namespace nlrs
+{
+
+struct small_object_container
+{
+    small_object_container()
+        : backing(memory, sizeof(memory)),
+        arena(backing)
+    {}
+
+    alignas(16) static u8 memory[4u * 1024u * 1024u];
+    free_list_arena backing;
+    small_object_arena arena;
+};
+
+alignas(16) u8 small_object_container::memory[4u * 1024u * 1024u];
+
+SUITE(small_object_arena_test)
+{
+    TEST_FIXTURE(small_object_container, same_class_allocations_are_adjacent)
+    {
+        u8* first = static_cast<u8*>(arena.allocate(20u));
+        u8* second = static_cast<u8*>(arena.allocate(24u));
+        CHECK_EQUAL(first + 24, second);
+        CHECK_EQUAL(1u, arena.num_slabs());
+
+        arena.free(second, 24u);
+        arena.free(first, 20u);
+        CHECK_EQUAL(0u, arena.num_allocations());
+    }
+
+    TEST_FIXTURE(small_object_container, freed_chunks_are_reused)
+    {
+        void* first = arena.allocate(100u);
+        arena.free(first, 100u);
+        void* second = arena.allocate(97u);
+        CHECK_EQUAL(first, second);
+        arena.free(second);
+    }
+
+    TEST_FIXTURE(small_object_container, size_classes_use_separate_slabs)
+    {
+        void* small = arena.allocate(8u);
+        void* large = arena.allocate(256u);
+        CHECK_EQUAL(2u, arena.num_slabs());
+        arena.free(small);
+        arena.free(large);
+    }
+
+    TEST_FIXTURE(small_object_container, large_requests_go_to_the_backing_arena)
+    {
+        void* ptr = arena.allocate(1000u);
+        CHECK_EQUAL(0u, arena.num_slabs());
+        CHECK_EQUAL(1u, backing.num_allocations());
+        arena.free(ptr, 1000u);
+        CHECK_EQUAL(0u, backing.num_allocations());
+    }
+
+    TEST_FIXTURE(small_object_container, alignment_is_correct)
+    {
+        u8 alignments[] = { 1u, 4u, 8u, 16u, 32u, 64u, 128u };
+        for (u8 alignment : alignments)
+        {
+            void* ptr = arena.allocate(24u, alignment);
+            CHECK_EQUAL(0u, reinterpret_cast<uptr>(ptr) % alignment);
+            arena.free(ptr, 24u, alignment);
+        }
+    }
+
+    TEST_FIXTURE(small_object_container, reallocation_moves_between_classes)
+    {
+        u8* ptr = static_cast<u8*>(arena.allocate(16u));
+        std::memset(ptr, 7, 16u);
+        CHECK_EQUAL(static_cast<void*>(ptr), arena.reallocate(ptr, 12u));
+
+        u8* grown = static_cast<u8*>(arena.reallocate(ptr, 200u));
+        CHECK(grown != ptr);
+        CHECK_EQUAL(7, grown[15]);
+
+        u8* large = static_cast<u8*>(arena.reallocate(grown, 4000u));
+        CHECK_EQUAL(7, large[15]);
+        CHECK_EQUAL(1u, backing.num_allocations() - arena.num_slabs());
+
+        u8* small = static_cast<u8*>(arena.reallocate(large, 32u));
+        CHECK_EQUAL(7, small[15]);
+        arena.free(small, 32u);
+        CHECK_EQUAL(0u, arena.num_allocations());
+    }
+
+    TEST_FIXTURE(small_object_container, map_nodes_come_from_the_size_classes)
+    {
+        {
+            pmr::unordered_map<u32, u64> map{ 16u, std::hash<u32>(), std::equal_to<u32>(), polymorphic_allocator<std::pair<const u32, u64>>(arena) };
+            for (u32 i = 0u; i < 1000u; ++i)
+            {
+                map.emplace(i, i);
+            }
+            for (u32 i = 0u; i < 1000u; i += 2u)
+            {
+                map.erase(i);
+            }
+            CHECK_EQUAL(500u, map.size());
+        }
+        CHECK_EQUAL(0u, arena.num_allocations());
+    }
+
+    TEST_FIXTURE(small_object_container, slabs_are_returned_on_destruction)
+    {
+        {
+            small_object_arena temp(backing);
+            std::vector<void*> ptrs;
+            for (usize i = 0u; i < 10000u; ++i)
+            {
+                ptrs.push_back(temp.allocate(8u + (i % 32u) * 8u));
+            }
+            CHECK(temp.num_slabs() > 1u);
+            for (void* ptr : ptrs)
+            {
+                temp.free(ptr);
+            }
+        }
+        CHECK_EQUAL(0u, backing.num_allocations());
+    }
+
+#ifdef NLRS_ARENA_STATS
+    TEST_FIXTURE(small_object_container, stats_count_chunks)
+    {
+        void* ptr = arena.allocate(20u);
+        arena_stats stats = arena.stats();
+        CHECK_EQUAL(1u, stats.num_allocations);
+        CHECK_EQUAL(24u, stats.bytes_in_use);
+        CHECK_EQUAL(((small_object_arena::slab_size - 128u) / 24u - 1u) * 24u, stats.free_bytes);
+        arena.free(ptr, 20u);
+        CHECK_EQUAL(0u, arena.stats().bytes_in_use);
+    }
+#endif
+}
+
+}
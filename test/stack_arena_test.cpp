@@ -0,0 +1,148 @@
+#include "aliases.h"
+#include "buffer.h"
+#include "literals.h"
+#include "stack_arena.h"
+#include "UnitTest++/UnitTest++.h"
+
+#include <cstring>
+
+namespace nlrs
+{
+
+struct stack_memory_container
+{
+    stack_memory_container()
+        : arena(memory, sizeof(memory))
+    {}
+
+    alignas(16) u8 memory[4096];
+    stack_arena arena;
+};
+
+SUITE(stack_arena_test)
+{
+    TEST_FIXTURE(stack_memory_container, allocations_are_aligned)
+    {
+        void* b1 = arena.allocate(3u, 1u);
+        void* b2 = arena.allocate(16u, 16u);
+        void* t1 = arena.top().allocate(3u, 1u);
+        void* t2 = arena.top().allocate(16u, 32u);
+
+        CHECK_EQUAL(0u, reinterpret_cast<uptr>(b2) % 16u);
+        CHECK_EQUAL(0u, reinterpret_cast<uptr>(t2) % 32u);
+        CHECK(reinterpret_cast<uptr>(b2) > reinterpret_cast<uptr>(b1));
+        CHECK(reinterpret_cast<uptr>(t2) < reinterpret_cast<uptr>(t1));
+
+        arena.free(t2);
+        arena.free(t1);
+        arena.free(b2);
+        arena.free(b1);
+        CHECK_EQUAL(4096_sz, arena.bytes_free());
+    }
+
+    TEST_FIXTURE(stack_memory_container, lifo_free_restores_free_space)
+    {
+        usize initial = arena.bytes_free();
+        void* b1 = arena.allocate(100u);
+        usize after_first = arena.bytes_free();
+        void* b2 = arena.allocate(200u);
+        arena.free(b2);
+        CHECK_EQUAL(after_first, arena.bytes_free());
+        arena.free(b1);
+        CHECK_EQUAL(initial, arena.bytes_free());
+    }
+
+    TEST_FIXTURE(stack_memory_container, both_ends_are_independent)
+    {
+        void* bottom = arena.allocate(100u);
+        void* top = arena.allocate(stack_arena::end::top, 100u);
+        void* bottom2 = arena.allocate(100u);
+        arena.free(top);
+        arena.free(bottom2);
+        arena.free(bottom);
+        CHECK_EQUAL(4096_sz, arena.bytes_free());
+    }
+
+    TEST_FIXTURE(stack_memory_container, topmost_bottom_allocation_grows_in_place)
+    {
+        void* ptr = arena.allocate(16u);
+        void* grown = arena.reallocate(ptr, 1024u);
+        CHECK_EQUAL(ptr, grown);
+        arena.free(grown);
+        CHECK_EQUAL(4096_sz, arena.bytes_free());
+    }
+
+    TEST_FIXTURE(stack_memory_container, topmost_top_allocation_is_moved_down)
+    {
+        u8* ptr = static_cast<u8*>(arena.top().allocate(16u));
+        std::memset(ptr, 5, 16u);
+        u8* grown = static_cast<u8*>(arena.top().reallocate(ptr, 1024u));
+        CHECK(grown < ptr);
+        CHECK_EQUAL(5, grown[0]);
+        CHECK_EQUAL(5, grown[15]);
+        arena.top().free(grown);
+        CHECK_EQUAL(4096_sz, arena.bytes_free());
+    }
+
+    TEST_FIXTURE(stack_memory_container, running_out_of_memory_returns_null)
+    {
+        void* bottom = arena.allocate(2000u);
+        void* top = arena.top().allocate(2000u);
+        CHECK(bottom && top);
+        usize free_bytes = arena.bytes_free();
+        CHECK(arena.allocate(128u) == nullptr);
+        CHECK(arena.top().allocate(128u) == nullptr);
+        CHECK(arena.reallocate(bottom, 2200u) == nullptr);
+        CHECK(arena.top().reallocate(top, 2200u) == nullptr);
+        CHECK_EQUAL(free_bytes, arena.bytes_free());
+
+        // the failed reallocations leave the allocations usable
+        arena.top().free(top);
+        arena.free(bottom);
+        CHECK_EQUAL(4096_sz, arena.bytes_free());
+    }
+
+    TEST_FIXTURE(stack_memory_container, shrinking_an_older_allocation_leaves_it_in_place)
+    {
+        for (stack_arena::end e : { stack_arena::end::bottom, stack_arena::end::top })
+        {
+            u8* older = static_cast<u8*>(arena.allocate(e, 64u));
+            std::memset(older, 3, 64u);
+            u8* newer = static_cast<u8*>(arena.allocate(e, 16u));
+            usize free_bytes = arena.bytes_free();
+
+            CHECK_EQUAL(older, static_cast<u8*>(arena.reallocate(older, 32u)));
+            CHECK_EQUAL(3, older[31]);
+            CHECK_EQUAL(free_bytes, arena.bytes_free());
+
+            // the allocations can still be freed in LIFO order
+            arena.free(newer);
+            arena.free(older);
+        }
+        CHECK_EQUAL(4096_sz, arena.bytes_free());
+    }
+
+    TEST_FIXTURE(stack_memory_container, buffer_grows_without_copying)
+    {
+        buffer<int> buf(arena, 8u);
+        int* data = buf.at(0u);
+        buf.reserve(256u);
+        CHECK_EQUAL(data, buf.at(0u));
+    }
+
+    TEST_FIXTURE(stack_memory_container, rewinding_to_marker_releases_stack)
+    {
+        arena.allocate(64u);
+        stack_arena::marker bottom = arena.get_marker(stack_arena::end::bottom);
+        stack_arena::marker top = arena.get_marker(stack_arena::end::top);
+        usize free_bytes = arena.bytes_free();
+        arena.allocate(64u);
+        arena.allocate(stack_arena::end::top, 64u);
+        arena.allocate(stack_arena::end::top, 64u);
+        arena.rewind(stack_arena::end::bottom, bottom);
+        arena.rewind(stack_arena::end::top, top);
+        CHECK_EQUAL(free_bytes, arena.bytes_free());
+    }
+}
+
+}
@@ -0,0 +1,116 @@
+#include "aliases.h"
+#include "linear_arena.h"
+#include "memory_arena.h"
+#include "static_allocator.h"
+#include "UnitTest++/UnitTest++.h"
+
+#include "stl/string.h"
+#include "stl/unordered_map.h"
+#include "stl/vector.h"
+
+namespace nlrs
+{
+
+struct static_allocator_container
+{
+    static_allocator_container()
+        : arena(memory, sizeof(memory))
+    {}
+
+    alignas(16) u8 memory[16u * 1024u];
+    linear_arena arena;
+};
+
+// Counts the calls made through the derived class, which static_allocator is expected to bypass
+class counting_linear_arena : public linear_arena
+{
+public:
+    using linear_arena::linear_arena;
+
+    void* allocate(usize bytes, u8 alignment = 8u) override
+    {
+        ++num_calls;
+        return linear_arena::allocate(bytes, alignment);
+    }
+
+    usize num_calls{ 0u };
+};
+
+SUITE(static_allocator_test)
+{
+    TEST_FIXTURE(static_allocator_container, allocations_come_from_the_arena)
+    {
+        static_allocator<u64, linear_arena> allocator(arena);
+        u64* ptr = allocator.allocate(4u);
+        CHECK_EQUAL(static_cast<void*>(memory), static_cast<void*>(ptr));
+        CHECK_EQUAL(4u * sizeof(u64), arena.used());
+        allocator.deallocate(ptr, 4u);
+    }
+
+    TEST_FIXTURE(static_allocator_container, rebound_allocators_compare_equal)
+    {
+        static_allocator<u32, linear_arena> a(arena);
+        static_allocator<u64, linear_arena> b(a);
+        CHECK(a == b);
+        CHECK_EQUAL(&arena, &b.arena());
+
+        alignas(16) u8 other_memory[64];
+        linear_arena other(other_memory, sizeof(other_memory));
+        CHECK((a != static_allocator<u32, linear_arena>(other)));
+    }
+
+    TEST_FIXTURE(static_allocator_container, allocations_are_aligned_for_the_type)
+    {
+        struct alignas(16) vec4 { float v[4]; };
+        arena.allocate(1u, 1u);
+        static_allocator<vec4, linear_arena> allocator(arena);
+        vec4* ptr = allocator.allocate(1u);
+        CHECK_EQUAL(0u, reinterpret_cast<uptr>(ptr) & 15u);
+        allocator.deallocate(ptr, 1u);
+    }
+
+    TEST(calls_are_not_dispatched_virtually)
+    {
+        alignas(16) u8 memory[256];
+        counting_linear_arena arena(memory, sizeof(memory));
+        static_allocator<u32, linear_arena> allocator(arena);
+        allocator.deallocate(allocator.allocate(4u), 4u);
+        CHECK_EQUAL(0u, arena.num_calls);
+        CHECK_EQUAL(16u, arena.used());
+    }
+
+    TEST_FIXTURE(static_allocator_container, containers_can_use_the_allocator)
+    {
+        pmr::arena_vector<u32, linear_arena> vec{ static_allocator<u32, linear_arena>(arena) };
+        for (u32 i = 0u; i < 100u; ++i)
+        {
+            vec.push_back(i);
+        }
+        CHECK_EQUAL(99u, vec.back());
+
+        pmr::arena_string<linear_arena> str{ "a string too long for small string optimization", static_allocator<char, linear_arena>(arena) };
+        CHECK_EQUAL('a', str[0]);
+
+        pmr::arena_unordered_map<u32, u32, linear_arena> map{ 16u, std::hash<u32>(), std::equal_to<u32>(), static_allocator<std::pair<const u32, u32>, linear_arena>(arena) };
+        map[1u] = 2u;
+        CHECK_EQUAL(2u, map[1u]);
+
+        CHECK(arena.used() > 100u * sizeof(u32));
+    }
+
+    TEST(free_list_arena_reclaims_freed_memory)
+    {
+        alignas(16) static u8 memory[16u * 1024u];
+        free_list_arena arena(memory, sizeof(memory));
+        {
+            pmr::arena_vector<u64, free_list_arena> vec{ static_allocator<u64, free_list_arena>(arena) };
+            vec.resize(100u);
+        }
+        // everything was returned, so a block of a quarter of the arena fits again
+        void* ptr = arena.allocate(4u * 1024u);
+        CHECK(ptr != nullptr);
+        arena.free(ptr);
+    }
+}
+
+}
@@ -0,0 +1,86 @@
+#include "aliases.h"
+#include "memory_arena.h"
+#include "UnitTest++/UnitTest++.h"
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace nlrs
+{
+
+SUITE(system_arena_test)
+{
+    TEST(zero_sized_allocation_returns_null)
+    {
+        CHECK(system_arena::get_instance().allocate(0u) == nullptr);
+    }
+
+    TEST(alignment_is_honoured)
+    {
+        system_arena& arena = system_arena::get_instance();
+        for (u32 shift = 0u; shift < 8u; ++shift)
+        {
+            u8 alignment = u8(1u << shift);
+            void* ptr = arena.allocate(100u, alignment);
+            CHECK_EQUAL(0u, reinterpret_cast<uptr>(ptr) % alignment);
+            arena.free(ptr);
+        }
+    }
+
+    TEST(reallocation_keeps_alignment_and_contents)
+    {
+        system_arena& arena = system_arena::get_instance();
+        u8* ptr = static_cast<u8*>(arena.allocate(64u, 128u));
+        std::memset(ptr, 3, 64u);
+        u8* grown = static_cast<u8*>(arena.reallocate(ptr, 100000u));
+        CHECK_EQUAL(0u, reinterpret_cast<uptr>(grown) % 128u);
+        CHECK_EQUAL(3, grown[63]);
+        arena.free(grown);
+    }
+
+    TEST(large_allocation_is_mapped_and_can_be_reallocated)
+    {
+        system_arena& arena = system_arena::get_instance();
+        usize size = system_arena::huge_page_threshold + 100u;
+        u8* ptr = static_cast<u8*>(arena.allocate(size, 64u));
+        CHECK(ptr != nullptr);
+        CHECK_EQUAL(0u, reinterpret_cast<uptr>(ptr) % 64u);
+        ptr[0] = 1u;
+        ptr[size - 1u] = 2u;
+
+        // the mapping is rounded up to whole huge pages, so this fits in place
+        u8* grown = static_cast<u8*>(arena.reallocate(ptr, size + 1000u));
+        CHECK_EQUAL(ptr, grown);
+        grown = static_cast<u8*>(arena.reallocate(grown, 3u * system_arena::huge_page_size));
+        CHECK_EQUAL(1u, grown[0]);
+        CHECK_EQUAL(2u, grown[size - 1u]);
+        arena.free(grown);
+    }
+
+    TEST(allocation_count_is_consistent_across_threads)
+    {
+        system_arena& arena = system_arena::get_instance();
+        unsigned int count_was = arena.num_allocations();
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t)
+        {
+            threads.emplace_back([&arena]() -> void
+            {
+                for (int i = 0; i < 1000; ++i)
+                {
+                    arena.free(arena.allocate(32u));
+                }
+            });
+        }
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+
+        CHECK_EQUAL(count_was, arena.num_allocations());
+    }
+}
+
+}
@@ -0,0 +1,180 @@
+#include "aliases.h"
+#include "memory_arena.h"
+#include "thread_cache_arena.h"
+#include "UnitTest++/UnitTest++.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace nlrs
+{
+
+struct thread_cache_container
+{
+    thread_cache_container()
+        : memory(std::malloc(16 * 1024 * 1024)),
+        backing(memory, 16 * 1024 * 1024),
+        arena(new thread_cache_arena(backing))
+    {}
+
+    ~thread_cache_container()
+    {
+        delete arena;
+        std::free(memory);
+    }
+
+    void* memory;
+    free_list_arena backing;
+    thread_cache_arena* arena;
+};
+
+SUITE(thread_cache_arena_test)
+{
+    TEST_FIXTURE(thread_cache_container, freed_block_is_reused_from_cache)
+    {
+        void* block = arena->allocate(24u);
+        arena->free(block);
+        CHECK_EQUAL(block, arena->allocate(20u));
+        arena->free(block);
+    }
+
+    TEST_FIXTURE(thread_cache_container, refill_takes_a_batch_from_backing_arena)
+    {
+        void* block = arena->allocate(64u);
+        CHECK_EQUAL(thread_cache_arena::batch_size, usize(backing.num_allocations()));
+        arena->free(block);
+        arena->flush_thread_cache();
+        CHECK_EQUAL(0u, backing.num_allocations());
+    }
+
+    TEST_FIXTURE(thread_cache_container, large_and_over_aligned_allocations_go_to_backing_arena)
+    {
+        void* large = arena->allocate(thread_cache_arena::max_class_size + 1u);
+        void* aligned = arena->allocate(32u, 64u);
+        CHECK_EQUAL(2u, backing.num_allocations());
+        CHECK_EQUAL(0u, reinterpret_cast<uptr>(aligned) % 64u);
+        arena->free(large);
+        arena->free(aligned);
+        CHECK_EQUAL(0u, backing.num_allocations());
+    }
+
+    TEST_FIXTURE(thread_cache_container, reallocate_keeps_contents)
+    {
+        u8* block = static_cast<u8*>(arena->allocate(32u));
+        std::memset(block, 4, 32u);
+        u8* grown = static_cast<u8*>(arena->reallocate(block, 10000u));
+        CHECK_EQUAL(4, grown[0]);
+        CHECK_EQUAL(4, grown[31]);
+        arena->free(grown);
+    }
+
+    TEST_FIXTURE(thread_cache_container, sized_free_returns_block_to_cache)
+    {
+        void* block = arena->allocate(100u);
+        arena->free(block, 100u);
+        CHECK_EQUAL(block, arena->allocate(120u));
+        arena->free(block, 120u);
+
+        void* aligned = arena->allocate(100u, 64u);
+        arena->free(aligned, 100u, 64u);
+        void* large = arena->allocate(thread_cache_arena::max_class_size + 1u);
+        arena->free(large, thread_cache_arena::max_class_size + 1u);
+        arena->flush_thread_cache();
+        CHECK_EQUAL(0u, backing.num_allocations());
+    }
+
+    TEST_FIXTURE(thread_cache_container, reallocating_to_another_size_class_moves_block)
+    {
+        u8* block = static_cast<u8*>(arena->allocate(100u));
+        std::memset(block, 7, 100u);
+        CHECK_EQUAL(block, static_cast<u8*>(arena->reallocate(block, 120u)));
+
+        // the sized free must find the block in the class of its new size
+        u8* shrunk = static_cast<u8*>(arena->reallocate(block, 20u));
+        CHECK(shrunk != block);
+        CHECK_EQUAL(7, shrunk[19]);
+        arena->free(shrunk, 20u);
+    }
+
+    TEST_FIXTURE(thread_cache_container, polymorphic_allocator_frees_with_size)
+    {
+        polymorphic_allocator<u64> allocator(*arena);
+        u64* values = allocator.allocate(4u);
+        allocator.deallocate(values, 4u);
+        CHECK_EQUAL(values, allocator.allocate(4u));
+        allocator.deallocate(values, 4u);
+    }
+
+    TEST_FIXTURE(thread_cache_container, destroying_arena_returns_cached_blocks)
+    {
+        void* block = arena->allocate(128u);
+        arena->free(block);
+        delete arena;
+        arena = nullptr;
+        CHECK_EQUAL(0u, backing.num_allocations());
+        arena = new thread_cache_arena(backing);
+    }
+
+    TEST_FIXTURE(thread_cache_container, blocks_can_be_used_and_freed_across_threads)
+    {
+        const int num_threads = 4;
+        const int num_blocks = 2000;
+        std::vector<void*> handoff(num_threads * num_blocks, nullptr);
+        std::atomic<int> errors{ 0 };
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < num_threads; ++t)
+        {
+            threads.emplace_back([&, t]() -> void
+            {
+                for (int i = 0; i < num_blocks; ++i)
+                {
+                    usize size = usize(8 + (i % 100) * 8);
+                    u8* block = static_cast<u8*>(arena->allocate(size));
+                    std::memset(block, t, size);
+                    handoff[t * num_blocks + i] = block;
+                    if (block[size - 1u] != u8(t))
+                    {
+                        ++errors;
+                    }
+                }
+            });
+        }
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+        threads.clear();
+
+        // free every block on a different thread than the one which allocated it
+        for (int t = 0; t < num_threads; ++t)
+        {
+            threads.emplace_back([&, t]() -> void
+            {
+                int source = (t + 1) % num_threads;
+                for (int i = 0; i < num_blocks; ++i)
+                {
+                    u8* block = static_cast<u8*>(handoff[source * num_blocks + i]);
+                    if (block[0] != u8(source))
+                    {
+                        ++errors;
+                    }
+                    arena->free(block);
+                }
+            });
+        }
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+
+        CHECK_EQUAL(0, errors.load());
+        // the exited threads have returned their caches
+        CHECK_EQUAL(0u, backing.num_allocations());
+    }
+}
+
+}
@@ -0,0 +1,138 @@
+#include "aliases.h"
+#include "tlsf_arena.h"
+#include "random.h"
+#include "UnitTest++/UnitTest++.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+namespace nlrs
+{
+
+struct tlsf_memory_container
+{
+    tlsf_memory_container()
+        : memory(std::malloc(1024 * 1024)),
+        heap(memory, 1024 * 1024)
+    {}
+
+    ~tlsf_memory_container()
+    {
+        std::free(memory);
+    }
+
+    void* memory;
+    tlsf_arena heap;
+};
+
+SUITE(tlsf_arena_test)
+{
+    TEST_FIXTURE(tlsf_memory_container, zero_sized_allocation_returns_null)
+    {
+        CHECK(heap.allocate(0u) == nullptr);
+        CHECK_EQUAL(0u, heap.num_allocations());
+    }
+
+    TEST_FIXTURE(tlsf_memory_container, alignment_is_correct)
+    {
+        u8 alignments[] = { 1u, 4u, 8u, 16u, 32u, 64u, 128u };
+        void* blocks[7];
+        for (int i = 0; i < 7; ++i)
+        {
+            blocks[i] = heap.allocate(40u, alignments[i]);
+            CHECK(blocks[i] != nullptr);
+            CHECK_EQUAL(0u, reinterpret_cast<uptr>(blocks[i]) % alignments[i]);
+        }
+        for (void* block : blocks)
+        {
+            heap.free(block);
+        }
+        CHECK_EQUAL(0u, heap.num_allocations());
+    }
+
+    TEST_FIXTURE(tlsf_memory_container, freed_memory_is_reused)
+    {
+        void* block1 = heap.allocate(64u);
+        heap.free(block1);
+        void* block2 = heap.allocate(64u);
+        CHECK_EQUAL(block1, block2);
+        heap.free(block2);
+    }
+
+    TEST_FIXTURE(tlsf_memory_container, allocation_fails_when_out_of_memory)
+    {
+        void* block = heap.allocate(2u * 1024u * 1024u);
+        CHECK(block == nullptr);
+
+        void* most = heap.allocate(1000u * 1024u);
+        CHECK(most != nullptr);
+        CHECK(heap.allocate(100u * 1024u) == nullptr);
+        heap.free(most);
+    }
+
+    TEST_FIXTURE(tlsf_memory_container, freed_blocks_merge_into_whole_pool)
+    {
+        nlrs::random<usize> rng;
+        rng.seed(7u);
+
+        std::vector<std::pair<u8*, usize>> blocks;
+        for (int round = 0; round < 8; ++round)
+        {
+            while (blocks.size() < 256u)
+            {
+                usize size = rng(1u, 1000u);
+                u8* block = static_cast<u8*>(heap.allocate(size, u8(1u << rng(0u, 6u))));
+                CHECK(block != nullptr);
+                std::memset(block, u8(size), size);
+                blocks.push_back(std::make_pair(block, size));
+            }
+            while (blocks.size() > 128u)
+            {
+                usize index = rng(0u, blocks.size() - 1u);
+                CHECK_EQUAL(u8(blocks[index].second), blocks[index].first[0]);
+                CHECK_EQUAL(u8(blocks[index].second), blocks[index].first[blocks[index].second - 1u]);
+                heap.free(blocks[index].first);
+                blocks[index] = blocks.back();
+                blocks.pop_back();
+            }
+        }
+        for (auto& block : blocks)
+        {
+            heap.free(block.first);
+        }
+        CHECK_EQUAL(0u, heap.num_allocations());
+
+        // if everything was merged, then almost the whole pool can be allocated again
+        void* all = heap.allocate(1000u * 1024u);
+        CHECK(all != nullptr);
+        heap.free(all);
+    }
+
+    TEST_FIXTURE(tlsf_memory_container, reallocate_grows_in_place_into_free_neighbour)
+    {
+        void* block = heap.allocate(64u);
+        std::memset(block, 3, 64u);
+        void* grown = heap.reallocate(block, 4096u);
+        CHECK_EQUAL(block, grown);
+        CHECK(heap.block_size(grown) >= 4096u);
+        CHECK_EQUAL(3, static_cast<u8*>(grown)[63]);
+        heap.free(grown);
+    }
+
+    TEST_FIXTURE(tlsf_memory_container, reallocate_moves_block_and_keeps_contents)
+    {
+        void* block = heap.allocate(64u, 32u);
+        void* neighbour = heap.allocate(64u);
+        std::memset(block, 3, 64u);
+        void* moved = heap.reallocate(block, 4096u);
+        CHECK(moved != block);
+        CHECK_EQUAL(0u, reinterpret_cast<uptr>(moved) % 32u);
+        CHECK_EQUAL(3, static_cast<u8*>(moved)[63]);
+        heap.free(moved);
+        heap.free(neighbour);
+    }
+}
+
+}
@@ -0,0 +1,93 @@
+#include "aliases.h"
+#include "virtual_arena.h"
+#include "UnitTest++/UnitTest++.h"
+
+#include <cstring>
+#include <vector>
+
+namespace nlrs
+{
+
+SUITE(virtual_arena_test)
+{
+    TEST(only_the_first_chunk_is_committed_initially)
+    {
+        virtual_arena arena(16u * 1024u * 1024u, 64u * 1024u);
+        CHECK_EQUAL(16u * 1024u * 1024u, arena.reserved_bytes());
+        CHECK_EQUAL(64u * 1024u, arena.committed_bytes());
+    }
+
+    TEST(arena_commits_memory_as_it_grows)
+    {
+        virtual_arena arena(16u * 1024u * 1024u, 64u * 1024u);
+        std::vector<void*> ptrs;
+        for (int i = 0; i < 100; ++i)
+        {
+            // with the block overhead, this fills a 4 KiB block
+            void* ptr = arena.allocate(4000u);
+            CHECK(ptr != nullptr);
+            std::memset(ptr, i, 4000u);
+            ptrs.push_back(ptr);
+        }
+        CHECK(arena.committed_bytes() >= 100u * 4000u);
+        CHECK(arena.committed_bytes() <= 100u * 4096u + 64u * 1024u);
+
+        // earlier allocations don't move as the arena grows
+        CHECK_EQUAL(0, static_cast<u8*>(ptrs[0])[3999]);
+        CHECK_EQUAL(99, static_cast<u8*>(ptrs[99])[0]);
+
+        for (void* ptr : ptrs)
+        {
+            arena.free(ptr);
+        }
+    }
+
+    TEST(allocation_beyond_reservation_fails)
+    {
+        virtual_arena arena(256u * 1024u, 64u * 1024u);
+        void* ptr = arena.allocate(100u * 1024u);
+        CHECK(ptr != nullptr);
+        CHECK(arena.allocate(256u * 1024u) == nullptr);
+        arena.free(ptr);
+    }
+
+    TEST(trim_decommits_free_memory_at_top)
+    {
+        virtual_arena arena(16u * 1024u * 1024u, 64u * 1024u);
+        void* small = arena.allocate(64u);
+        void* large = arena.allocate(1024u * 1024u);
+        usize committed = arena.committed_bytes();
+        CHECK(committed > 1024u * 1024u);
+
+        arena.free(large);
+        usize decommitted = arena.trim();
+        CHECK(decommitted >= 1024u * 1024u - 64u * 1024u);
+        CHECK_EQUAL(committed - decommitted, arena.committed_bytes());
+        CHECK_EQUAL(64u * 1024u, arena.committed_bytes());
+
+        // nothing more to trim
+        CHECK_EQUAL(0u, arena.trim());
+
+        // the decommitted range is committed again on demand
+        u8* again = static_cast<u8*>(arena.allocate(512u * 1024u));
+        CHECK(again != nullptr);
+        again[512u * 1024u - 1u] = 1u;
+
+        arena.free(again);
+        arena.free(small);
+    }
+
+    TEST(reallocation_grows_in_place_across_commit_boundary)
+    {
+        virtual_arena arena(16u * 1024u * 1024u, 64u * 1024u);
+        u8* ptr = static_cast<u8*>(arena.allocate(1024u));
+        std::memset(ptr, 7, 1024u);
+        u8* grown = static_cast<u8*>(arena.reallocate(ptr, 300u * 1024u));
+        CHECK_EQUAL(ptr, grown);
+        CHECK_EQUAL(7, grown[1023]);
+        grown[300u * 1024u - 1u] = 1u;
+        arena.free(grown);
+    }
+}
+
+}
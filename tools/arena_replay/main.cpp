@@ -0,0 +1,304 @@
+#include "arena_trace.h"
+#include "bench.h"
+#include "buddy_arena.h"
+#include "memory_arena.h"
+#include "thread_cache_arena.h"
+#include "tlsf_arena.h"
+#include "virtual_arena.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Usage: arena_replay <trace file> [arena filter]
+//
+// Replays an allocation trace recorded with recording_arena against each arena whose name
+// contains the filter, and reports the throughput, the latency percentiles of each
+// operation, and the peak footprint.
+//
+// The trace is replayed twice for each arena. The throughput is measured over the whole
+// first run, and the latencies of the individual calls during the second run. The footprint
+// is the address range spanned by the arena's allocations, which for the arenas managing
+// a single block of memory is the memory they actually touched.
+
+namespace
+{
+
+using namespace nlrs;
+
+struct trace_summary
+{
+    usize num_allocations;
+    usize peak_live_bytes;
+    bench::latency_samples lifetimes;
+};
+
+void summarize(const std::vector<trace_event>& events, trace_summary& summary)
+{
+    std::vector<u64> sizes;
+    std::vector<u64> birth;
+    usize live_bytes = 0u;
+    summary.num_allocations = 0u;
+    summary.peak_live_bytes = 0u;
+
+    for (const trace_event& e : events)
+    {
+        if (e.id >= sizes.size())
+        {
+            sizes.resize(e.id + 1u, 0u);
+            birth.resize(e.id + 1u, 0u);
+        }
+        switch (e.op)
+        {
+        case trace_op::allocate:
+            ++summary.num_allocations;
+            sizes[e.id] = e.size;
+            birth[e.id] = e.time_ns;
+            live_bytes += usize(e.size);
+            break;
+        case trace_op::reallocate:
+            live_bytes = live_bytes - usize(sizes[e.id]) + usize(e.size);
+            sizes[e.id] = e.size;
+            break;
+        case trace_op::free:
+            live_bytes -= usize(sizes[e.id]);
+            sizes[e.id] = 0u;
+            summary.lifetimes.add(e.time_ns - birth[e.id]);
+            break;
+        }
+        summary.peak_live_bytes = std::max(summary.peak_live_bytes, live_bytes);
+    }
+}
+
+struct replay_state
+{
+    explicit replay_state(const std::vector<trace_event>& events)
+    {
+        u32 num_ids = 0u;
+        for (const trace_event& e : events)
+        {
+            num_ids = std::max(num_ids, e.id + 1u);
+        }
+        ptrs.resize(num_ids, nullptr);
+    }
+
+    std::vector<void*> ptrs;
+};
+
+// Replays the events, and returns false if the arena ran out of memory.
+bool replay_timed(const std::vector<trace_event>& events, memory_arena& arena, double& seconds)
+{
+    replay_state state(events);
+    bool succeeded = true;
+    bench::stopwatch watch;
+    for (const trace_event& e : events)
+    {
+        void*& ptr = state.ptrs[e.id];
+        void* result = nullptr;
+        switch (e.op)
+        {
+        case trace_op::allocate:
+            result = arena.allocate(usize(e.size), e.alignment);
+            break;
+        case trace_op::reallocate:
+            // a failed reallocation leaves the old block live, so it is kept to be freed
+            result = arena.reallocate(ptr, usize(e.size));
+            break;
+        case trace_op::free:
+            arena.free(ptr);
+            ptr = nullptr;
+            continue;
+        }
+        if (!result)
+        {
+            succeeded = false;
+            break;
+        }
+        ptr = result;
+    }
+    seconds = watch.elapsed_seconds();
+
+    for (void* ptr : state.ptrs)
+    {
+        arena.free(ptr);
+    }
+    return succeeded;
+}
+
+bool replay_measured(
+    const std::vector<trace_event>& events,
+    memory_arena& arena,
+    bench::latency_samples* latencies,
+    usize& footprint)
+{
+    replay_state state(events);
+    bool succeeded = true;
+    uptr lowest = ~uptr(0u);
+    uptr highest = 0u;
+    for (const trace_event& e : events)
+    {
+        void*& ptr = state.ptrs[e.id];
+        void* result = nullptr;
+        bench::stopwatch watch;
+        switch (e.op)
+        {
+        case trace_op::allocate:
+            result = arena.allocate(usize(e.size), e.alignment);
+            break;
+        case trace_op::reallocate:
+            // a failed reallocation leaves the old block live, so it is kept to be freed
+            result = arena.reallocate(ptr, usize(e.size));
+            break;
+        case trace_op::free:
+            arena.free(ptr);
+            break;
+        }
+        latencies[usize(e.op)].add(watch.elapsed_ns());
+
+        if (e.op == trace_op::free)
+        {
+            ptr = nullptr;
+            continue;
+        }
+        if (!result)
+        {
+            succeeded = false;
+            break;
+        }
+        ptr = result;
+        lowest = std::min(lowest, reinterpret_cast<uptr>(ptr));
+        highest = std::max(highest, reinterpret_cast<uptr>(ptr) + usize(e.size));
+    }
+    footprint = highest > lowest ? usize(highest - lowest) : 0u;
+
+    for (void* ptr : state.ptrs)
+    {
+        arena.free(ptr);
+    }
+    return succeeded;
+}
+
+struct arena_factory
+{
+    const char* name;
+    // whether the arena manages a single block of memory, so that the footprint is meaningful
+    bool contiguous;
+    std::function<std::shared_ptr<memory_arena>()> create;
+};
+
+void replay(const arena_factory& factory, const std::vector<trace_event>& events)
+{
+    std::printf("\n%s\n", factory.name);
+
+    double seconds = 0.0;
+    {
+        std::shared_ptr<memory_arena> arena = factory.create();
+        if (!replay_timed(events, *arena, seconds))
+        {
+            std::printf("  out of memory\n");
+            return;
+        }
+    }
+    bench::report_throughput("throughput", events.size(), seconds);
+
+    bench::latency_samples latencies[3] = {
+        bench::latency_samples(events.size()),
+        bench::latency_samples(),
+        bench::latency_samples(events.size())
+    };
+    usize footprint = 0u;
+    {
+        std::shared_ptr<memory_arena> arena = factory.create();
+        if (!replay_measured(events, *arena, latencies, footprint))
+        {
+            std::printf("  out of memory\n");
+            return;
+        }
+#ifdef NLRS_ARENA_STATS
+        bench::report_bytes("peak bytes in use", arena->stats().peak_bytes_in_use);
+#endif
+    }
+    bench::report_latency("allocate", latencies[usize(trace_op::allocate)]);
+    if (latencies[usize(trace_op::reallocate)].count())
+    {
+        bench::report_latency("reallocate", latencies[usize(trace_op::reallocate)]);
+    }
+    bench::report_latency("free", latencies[usize(trace_op::free)]);
+    if (factory.contiguous)
+    {
+        bench::report_bytes("peak footprint", footprint);
+    }
+}
+
+// Keeps the memory of the arenas which work on a caller-provided block alive
+template<typename Arena>
+class owning_arena : public Arena
+{
+public:
+    explicit owning_arena(usize num_bytes)
+        : owning_arena(std::malloc(num_bytes), num_bytes)
+    {}
+
+    ~owning_arena()
+    {
+        std::free(memory_);
+    }
+
+private:
+    owning_arena(void* memory, usize num_bytes)
+        : Arena(memory, num_bytes),
+        memory_(memory)
+    {}
+
+    void* memory_;
+};
+
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::printf("usage: arena_replay <trace file> [arena filter]\n");
+        return 1;
+    }
+
+    std::vector<trace_event> events;
+    if (!read_arena_trace(argv[1], events))
+    {
+        std::printf("could not read the trace %s\n", argv[1]);
+        return 1;
+    }
+
+    trace_summary summary;
+    summarize(events, summary);
+    std::printf("%s: %zu events, %zu allocations\n", argv[1], events.size(), summary.num_allocations);
+    bench::report_bytes("peak live bytes requested", summary.peak_live_bytes);
+    bench::report_latency("allocation lifetime", summary.lifetimes);
+
+    // leave plenty of room for each arena's overhead and fragmentation
+    const usize arena_bytes = std::max(usize(64u * 1024u * 1024u), 8u * summary.peak_live_bytes);
+
+    const arena_factory factories[] = {
+        { "free_list_arena", true, [=]() { return std::shared_ptr<memory_arena>(new owning_arena<free_list_arena>(arena_bytes)); } },
+        { "buddy_arena", true, [=]() { return std::shared_ptr<memory_arena>(new owning_arena<buddy_arena>(arena_bytes)); } },
+        { "tlsf_arena", true, [=]() { return std::shared_ptr<memory_arena>(new owning_arena<tlsf_arena>(arena_bytes)); } },
+        { "virtual_arena", true, [=]() { return std::shared_ptr<memory_arena>(new virtual_arena(arena_bytes)); } },
+        { "system_arena", false, []() { return std::shared_ptr<memory_arena>(&system_arena::get_instance(), [](memory_arena*) {}); } },
+        { "thread_cache_arena", false, []() { return std::shared_ptr<memory_arena>(new thread_cache_arena(system_arena::get_instance())); } },
+    };
+
+    const char* filter = argc > 2 ? argv[2] : nullptr;
+    for (const arena_factory& factory : factories)
+    {
+        if (!filter || std::strstr(factory.name, filter))
+        {
+            replay(factory, events);
+        }
+    }
+
+    return 0;
+}